@@ -0,0 +1,672 @@
+#include "e_modbus_gateway.h"
+#include <ezmb/e_crc.h>
+#include <event2/buffer.h>
+#include <json-c/json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/eventfd.h>
+
+static void bus_dispatch(gw_bus_t *bus);
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* 按 MBAP 格式应答客户端，pdu 从功能码开始 */
+static void reply(gw_client_t *client, uint16_t tid, uint8_t unit, const uint8_t *pdu, size_t pdu_len) {
+    if (!client) return;
+
+    uint8_t adu[MBAP_MAX_ADU];
+    put_u16(adu, tid);
+    put_u16(adu + 2, 0);
+    put_u16(adu + 4, (uint16_t)(pdu_len + 1));
+    adu[6] = unit;
+    memcpy(adu + MBAP_HEADER_LEN, pdu, pdu_len);
+    bufferevent_write(client->bev, adu, MBAP_HEADER_LEN + pdu_len);
+}
+
+static void reply_exception(gw_client_t *client, uint16_t tid, uint8_t unit, uint8_t function, uint8_t code) {
+    uint8_t pdu[2] = { function | 0x80, code };
+    reply(client, tid, unit, pdu, sizeof(pdu));
+}
+
+/* 应答链表中的每个事务同一个异常码 */
+static void reply_exception_all(gw_txn_t *txn, uint8_t code) {
+    for (; txn; txn = txn->next) {
+        reply_exception(txn->client, txn->tid, txn->unit, txn->req.function, code);
+    }
+}
+
+static void txn_free(gw_txn_t *txn) {
+    while (txn) {
+        gw_txn_t *next = txn->next;
+        free(txn);
+        txn = next;
+    }
+}
+
+/* 结束总线上的当前事务并调度下一个 */
+static void bus_complete(gw_bus_t *bus) {
+    evtimer_del(bus->timer);
+    txn_free(bus->inflight);
+    bus->inflight = NULL;
+    bus->rx_len = 0;
+    bus_dispatch(bus);
+}
+
+/* 进入超时后的静默期：从超时起固定一个超时时间，期间不发送新请求 */
+static void bus_guard(gw_bus_t *bus) {
+    int ms = bus->gw->timeout_ms;
+    struct timeval tv = { ms / 1000, (ms % 1000) * 1000 };
+    bus->guard = 1;
+    evtimer_add(bus->timer, &tv);
+}
+
+static void bus_timeout_cb(evutil_socket_t fd, short events, void *arg) {
+    (void)fd;
+    (void)events;
+    gw_bus_t *bus = (gw_bus_t *)arg;
+    if (bus->guard) {
+        bus->guard = 0;
+        bus_dispatch(bus);
+        return;
+    }
+
+    gw_txn_t *txn = bus->inflight;
+    if (!txn) return;
+
+    // 广播请求没有响应，静默时间结束即完成
+    if (txn->req.slave == 0) {
+        bus_complete(bus);
+        return;
+    }
+
+    // 超时的请求仍可能在采集器中排队或执行，它的迟到响应只按从站、功能码和长度无法与下一个请求区分，
+    // 静默期内收到的数据全部丢弃
+    bus->stats.timeouts++;
+    reply_exception_all(txn, MODBUS_EXC_GATEWAY_TARGET_FAILED);
+    txn_free(txn);
+    bus->inflight = NULL;
+    bus->rx_len = 0;
+    bus_guard(bus);
+}
+
+/* 把队列中可与 head 合并的读请求挂到 head 上，bus->req 扩展为覆盖全部地址的读取；
+ * 同一从站（或广播）的写请求之后的读请求不参与合并，保证读写顺序 */
+static void bus_coalesce(gw_bus_t *bus, gw_txn_t *head) {
+    e_modbus_gateway_t *gw = bus->gw;
+    if (gw->coalesce_gap < 0 || !e_modbus_is_read(head->req.function)) return;
+
+    gw_txn_t **tail = &head->next;
+    int merged;
+    do {
+        merged = 0;
+        int barrier = 0;
+        e_queue_t rest;
+        e_queue_init(&rest, 0);
+        while (!e_queue_empty(&bus->queue)) {
+            gw_txn_t *txn = (gw_txn_t *)e_queue_pop(&bus->queue);
+            if (!barrier && txn->client &&
+                e_modbus_merge_reads(&bus->req, &txn->req, gw->coalesce_gap, gw->coalesce_span, &bus->req)) {
+                *tail = txn;
+                tail = &txn->next;
+                bus->stats.coalesced++;
+                merged = 1;
+                continue;
+            }
+            if ((txn->req.slave == head->req.slave || txn->req.slave == 0) && !e_modbus_is_read(txn->req.function)) {
+                barrier = 1;
+            }
+            e_queue_push(&rest, txn);
+        }
+        e_queue_merge(&bus->queue, &rest);
+        e_queue_destroy(&rest);
+    } while (merged);   // 范围扩大后之前不相邻的请求可能变为可合并
+}
+
+/* 总线空闲时发送队首事务 */
+static void bus_dispatch(gw_bus_t *bus) {
+    while (!bus->inflight && !bus->guard && !e_queue_empty(&bus->queue)) {
+        gw_txn_t *txn = (gw_txn_t *)e_queue_pop(&bus->queue);
+
+        // 客户端已断开的事务不再上总线
+        if (!txn->client) {
+            free(txn);
+            continue;
+        }
+
+        bus->req = txn->req;
+        bus_coalesce(bus, txn);
+
+        const uint8_t *frame = txn->frame;
+        size_t frame_len = txn->frame_len;
+        uint8_t merged[MODBUS_RTU_MAX_ADU];
+        if (txn->next) {
+            frame = merged;
+            frame_len = e_modbus_build_request(&bus->req, NULL, merged, sizeof(merged));
+        }
+
+        if (e_monitor_send(bus->monitor, (const char *)frame, frame_len) < 0) {
+            reply_exception_all(txn, MODBUS_EXC_GATEWAY_PATH_UNAVAILABLE);
+            txn_free(txn);
+            continue;
+        }
+
+        bus->inflight = txn;
+        bus->rx_len = 0;
+        bus->stats.requests++;
+
+        int ms = txn->req.slave == 0 ? GW_BROADCAST_DELAY_MS : bus->gw->timeout_ms;
+        struct timeval tv = { ms / 1000, (ms % 1000) * 1000 };
+        evtimer_add(bus->timer, &tv);
+    }
+}
+
+/* 合并读取的响应按各事务的地址范围切片后分别应答 */
+static void reply_sliced(gw_bus_t *bus, const uint16_t *values) {
+    uint8_t pdu[MBAP_MAX_ADU];
+    for (gw_txn_t *txn = bus->inflight; txn; txn = txn->next) {
+        int len = e_modbus_build_read_pdu(&txn->req, &bus->req, values, pdu, sizeof(pdu));
+        if (len < 0) {
+            reply_exception(txn->client, txn->tid, txn->unit, txn->req.function, MODBUS_EXC_SLAVE_FAILURE);
+            continue;
+        }
+        reply(txn->client, txn->tid, txn->unit, pdu, len);
+    }
+}
+
+/*
+ * 串口侧数据到达：重组并匹配当前事务。读响应不带地址，只能按从站、功能码和长度匹配，
+ * 写响应回显的地址与数量由 e_modbus_parse_response 校验；北向主题上其他监视器的同形读响应
+ * 无法区分，因此网关路由的串口不能再有其他监视器发送请求
+ */
+static void bus_on_rx(gw_bus_t *bus, const uint8_t *data, size_t len) {
+    // 静默期内的数据可能是超时请求的迟到响应，丢弃；不延长静默期，
+    // 北向主题上其他监视器的响应不会让总线一直停在静默期
+    if (bus->guard) {
+        bus->stats.late++;
+        return;
+    }
+
+    gw_txn_t *txn = bus->inflight;
+    if (!txn || txn->req.slave == 0) return;   // 总线空闲或广播，多余数据丢弃
+
+    if (len > sizeof(bus->rx) - bus->rx_len) len = sizeof(bus->rx) - bus->rx_len;
+    memcpy(bus->rx + bus->rx_len, data, len);
+    bus->rx_len += len;
+
+    uint8_t exception = 0;
+    uint16_t values[MODBUS_MAX_READ_BITS];
+    int need_values = txn->next || bus->cache;
+    e_modbus_status_t status = e_modbus_parse_response(&bus->req, bus->rx, bus->rx_len,
+                                                       need_values ? values : NULL, &exception);
+    switch (status) {
+        case E_MODBUS_INCOMPLETE:
+            if (bus->rx_len == sizeof(bus->rx)) bus->rx_len = 0;
+            return;
+        case E_MODBUS_OK:
+            bus->stats.responses++;
+            if (e_modbus_is_read(bus->req.function)) {
+                e_modbus_cache_store(bus->cache, &bus->req, values, monotonic_us());
+            } else {
+                e_modbus_cache_invalidate(bus->cache, &bus->req);
+            }
+            if (txn->next) {
+                reply_sliced(bus, values);
+            } else {
+                reply(txn->client, txn->tid, txn->unit, bus->rx + 1, e_modbus_response_length(&txn->req) - 3);
+            }
+            break;
+        case E_MODBUS_EXCEPTION:
+            bus->stats.exceptions++;
+            for (; txn; txn = txn->next) {
+                reply(txn->client, txn->tid, txn->unit, bus->rx + 1, 2);
+            }
+            break;
+        default:
+            // 残留的迟到响应或噪声，丢弃后继续等待直到超时
+            bus->rx_len = 0;
+            return;
+    }
+    bus_complete(bus);
+}
+
+/* 采集器数据主题消息：轮询结果填充缓存，写通知使缓存失效 */
+static void bus_on_data(gw_bus_t *bus, const char *json) {
+    if (!bus->cache) return;
+
+    struct json_object *root = json_tokener_parse(json);
+    if (!root) return;
+
+    struct json_object *j_slave, *j_function, *j_address, *j_count, *j_status, *j_values;
+    if (json_object_object_get_ex(root, "slave", &j_slave) &&
+        json_object_object_get_ex(root, "function", &j_function) &&
+        json_object_object_get_ex(root, "address", &j_address) &&
+        json_object_object_get_ex(root, "count", &j_count) &&
+        json_object_object_get_ex(root, "status", &j_status)) {
+        e_modbus_request_t req = {
+            .slave = json_object_get_int(j_slave),
+            .function = json_object_get_int(j_function),
+            .address = json_object_get_int(j_address),
+            .count = json_object_get_int(j_count),
+        };
+        const char *status = json_object_get_string(j_status);
+
+        if (!status) {
+            // 非法消息，忽略
+        } else if (strcmp(status, "write") == 0) {
+            e_modbus_cache_invalidate(bus->cache, &req);
+        } else if (strcmp(status, "ok") == 0 && e_modbus_request_valid(&req) == 0 &&
+                   json_object_object_get_ex(root, "values", &j_values) &&
+                   json_object_get_type(j_values) == json_type_array &&
+                   (int)json_object_array_length(j_values) == req.count) {
+            uint16_t values[MODBUS_MAX_READ_BITS];
+            for (int i = 0; i < req.count; i++) {
+                values[i] = json_object_get_int(json_object_array_get_idx(j_values, i));
+            }
+            e_modbus_cache_store(bus->cache, &req, values, monotonic_us());
+        }
+    }
+    json_object_put(root);
+}
+
+static void notify_cb(evutil_socket_t fd, short events, void *arg) {
+    (void)events;
+    e_modbus_gateway_t *gw = (e_modbus_gateway_t *)arg;
+    uint64_t val;
+    ssize_t n = read(fd, &val, sizeof(val));
+    (void)n;
+
+    e_queue_t pending;
+    e_queue_init(&pending, 0);
+    pthread_mutex_lock(&gw->rx_mutex);
+    e_queue_merge(&pending, &gw->rx_queue);
+    pthread_mutex_unlock(&gw->rx_mutex);
+
+    while (!e_queue_empty(&pending)) {
+        gw_rx_t *rx = (gw_rx_t *)e_queue_pop(&pending);
+        if (rx->json) {
+            bus_on_data(rx->bus, (const char *)rx->data);
+        } else {
+            bus_on_rx(rx->bus, rx->data, rx->len);
+        }
+        free(rx);
+    }
+    e_queue_destroy(&pending);
+}
+
+/* 监视器线程：复制数据投递给事件循环 */
+static void monitor_recv_cb(const char *topic, size_t topic_len, const void *payload, size_t payload_len, void *data) {
+    e_device_t *monitor = (e_device_t *)data;
+    gw_bus_t *bus = (gw_bus_t *)monitor->arg;
+    if (!bus || payload_len == 0) return;
+
+    int json = topic_len == strlen(monitor->data_topic) && memcmp(topic, monitor->data_topic, topic_len) == 0;
+    gw_rx_t *rx = malloc(sizeof(gw_rx_t) + payload_len + 1);
+    if (!rx) return;
+    rx->bus = bus;
+    rx->json = json;
+    rx->len = payload_len;
+    memcpy(rx->data, payload, payload_len);
+    rx->data[payload_len] = '\0';
+
+    pthread_mutex_lock(&bus->gw->rx_mutex);
+    e_queue_push(&bus->gw->rx_queue, rx);
+    pthread_mutex_unlock(&bus->gw->rx_mutex);
+
+    uint64_t one = 1;
+    ssize_t n = write(bus->gw->notify_fd, &one, sizeof(one));
+    (void)n;
+}
+
+/* 处理一个完整的 MBAP 请求 */
+static void handle_request(e_modbus_gateway_t *gw, gw_client_t *client, const uint8_t *adu, size_t len) {
+    uint16_t tid = get_u16(adu);
+    uint8_t unit = adu[6];
+    const uint8_t *pdu = adu + MBAP_HEADER_LEN;
+    size_t pdu_len = len - MBAP_HEADER_LEN;
+
+    gw_bus_t *bus = gw->units[unit];
+    if (!bus) {
+        reply_exception(client, tid, unit, pdu[0], MODBUS_EXC_GATEWAY_PATH_UNAVAILABLE);
+        return;
+    }
+
+    e_modbus_request_t req = { .slave = unit };
+    int exc = e_modbus_parse_request(pdu, pdu_len, &req);
+    if (exc != 0) {
+        bus->stats.rejected++;
+        reply_exception(client, tid, unit, pdu[0], exc);
+        return;
+    }
+    if (unit == 0 && e_modbus_is_read(req.function)) {
+        // 广播只允许写功能码，且不应答
+        bus->stats.rejected++;
+        return;
+    }
+    if (bus->cache) {
+        uint16_t values[MODBUS_MAX_READ_BITS];
+        uint8_t rsp[MBAP_MAX_ADU];
+        if (!e_modbus_is_read(req.function)) {
+            // 写请求入队即失效，之后的读请求不会再读到旧值
+            e_modbus_cache_invalidate(bus->cache, &req);
+        } else if (e_modbus_cache_lookup(bus->cache, &req, values, monotonic_us())) {
+            int n = e_modbus_build_read_pdu(&req, &req, values, rsp, sizeof(rsp));
+            if (n > 0) {
+                reply(client, tid, unit, rsp, n);
+                return;
+            }
+        }
+    }
+    if (e_queue_size(&bus->queue) >= GW_BUS_QUEUE_MAX) {
+        bus->stats.rejected++;
+        reply_exception(client, tid, unit, pdu[0], MODBUS_EXC_SLAVE_BUSY);
+        return;
+    }
+
+    gw_txn_t *txn = malloc(sizeof(gw_txn_t));
+    if (!txn) {
+        reply_exception(client, tid, unit, pdu[0], MODBUS_EXC_SLAVE_FAILURE);
+        return;
+    }
+    txn->client = client;
+    txn->tid = tid;
+    txn->unit = unit;
+    txn->req = req;
+    txn->next = NULL;
+
+    // RTU 帧 = 从站地址 + PDU + CRC
+    txn->frame[0] = unit;
+    memcpy(txn->frame + 1, pdu, pdu_len);
+    uint16_t crc = e_crc16_modbus(txn->frame, pdu_len + 1);
+    txn->frame[pdu_len + 1] = crc & 0xFF;
+    txn->frame[pdu_len + 2] = crc >> 8;
+    txn->frame_len = pdu_len + 3;
+
+    e_queue_push(&bus->queue, txn);
+    bus_dispatch(bus);
+}
+
+static gw_client_t *find_client(e_modbus_gateway_t *gw, struct bufferevent *bev, int create) {
+    for (gw_client_t *c = gw->clients; c; c = c->next) {
+        if (c->bev == bev) return c;
+    }
+    if (!create) return NULL;
+
+    gw_client_t *c = calloc(1, sizeof(gw_client_t));
+    if (!c) return NULL;
+    c->bev = bev;
+    c->next = gw->clients;
+    gw->clients = c;
+    return c;
+}
+
+void e_modbus_gateway_on_recv(e_modbus_gateway_t *gw, struct bufferevent *bev, const void *data, size_t len) {
+    if (!gw || !bev) return;
+    gw_client_t *client = find_client(gw, bev, 1);
+    if (!client) return;
+
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        // 先凑齐 MBAP 头，再按长度字段凑齐整个 ADU
+        size_t need = MBAP_HEADER_LEN;
+        if (client->len >= MBAP_HEADER_LEN) {
+            uint16_t length = get_u16(client->buf + 4);
+            if (get_u16(client->buf + 2) != 0 || length < 2 || length > MBAP_MAX_ADU - MBAP_HEADER_LEN + 1) {
+                // 非 Modbus 协议或长度非法，无法再同步，丢弃已缓存数据
+                fprintf(stderr, "[GATEWAY] Invalid MBAP header, dropping %zu bytes\n", client->len + len);
+                client->len = 0;
+                return;
+            }
+            need = MBAP_HEADER_LEN - 1 + length;
+        }
+
+        size_t n = need - client->len;
+        if (n > len) n = len;
+        memcpy(client->buf + client->len, p, n);
+        client->len += n;
+        p += n;
+        len -= n;
+
+        if (client->len >= MBAP_HEADER_LEN && client->len == (size_t)MBAP_HEADER_LEN - 1 + get_u16(client->buf + 4)) {
+            handle_request(gw, client, client->buf, client->len);
+            client->len = 0;
+        }
+    }
+}
+
+static int detach_txn(void *arg, void *data) {
+    gw_txn_t *txn = (gw_txn_t *)data;
+    if (txn->client == arg) txn->client = NULL;
+    return 0;
+}
+
+void e_modbus_gateway_on_close(e_modbus_gateway_t *gw, struct bufferevent *bev) {
+    if (!gw) return;
+
+    gw_client_t **pp = &gw->clients;
+    while (*pp && (*pp)->bev != bev) pp = &(*pp)->next;
+    gw_client_t *client = *pp;
+    if (!client) return;
+    *pp = client->next;
+
+    for (int i = 0; i < gw->bus_count; i++) {
+        gw_bus_t *bus = gw->buses[i];
+        e_queue_foreach(&bus->queue, client, detach_txn);
+        for (gw_txn_t *txn = bus->inflight; txn; txn = txn->next) {
+            if (txn->client == client) txn->client = NULL;
+        }
+    }
+    free(client);
+}
+
+static gw_bus_t *get_bus(e_modbus_gateway_t *gw, const char *uid) {
+    for (int i = 0; i < gw->bus_count; i++) {
+        if (strcmp(gw->buses[i]->uid, uid) == 0) return gw->buses[i];
+    }
+
+    gw_bus_t **buses = realloc(gw->buses, sizeof(gw_bus_t *) * (gw->bus_count + 1));
+    if (!buses) return NULL;
+    gw->buses = buses;
+
+    gw_bus_t *bus = calloc(1, sizeof(gw_bus_t));
+    if (!bus) return NULL;
+    bus->gw = gw;
+    bus->uid = strdup(uid);
+    bus->timer = evtimer_new(gw->base, bus_timeout_cb, bus);
+    e_queue_init(&bus->queue, 0);
+    gw->buses[gw->bus_count++] = bus;
+    return bus;
+}
+
+int e_modbus_gateway_set_routes(e_modbus_gateway_t *gw, const char *spec) {
+    if (!gw || !spec) return -1;
+
+    char *copy = strdup(spec);
+    if (!copy) return -1;
+
+    gw_bus_t *fallback = NULL;
+    int ret = 0;
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(copy, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        char *eq = strchr(tok, '=');
+        if (!eq || eq == tok || !eq[1]) {
+            fprintf(stderr, "Invalid gateway route '%s' (expected unit=uid)\n", tok);
+            ret = -1;
+            break;
+        }
+        *eq = '\0';
+
+        gw_bus_t *bus = get_bus(gw, eq + 1);
+        if (!bus) {
+            ret = -1;
+            break;
+        }
+
+        if (strcmp(tok, "*") == 0) {
+            fallback = bus;
+            continue;
+        }
+
+        char *end;
+        long first = strtol(tok, &end, 10), last = first;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        if (*end != '\0' || first < 0 || last >= GW_MAX_UNITS || first > last) {
+            fprintf(stderr, "Invalid gateway unit '%s' (0-255)\n", tok);
+            ret = -1;
+            break;
+        }
+        for (long u = first; u <= last; u++) {
+            gw->units[u] = bus;
+        }
+    }
+
+    if (ret == 0 && fallback) {
+        for (int u = 0; u < GW_MAX_UNITS; u++) {
+            if (!gw->units[u]) gw->units[u] = fallback;
+        }
+    }
+    free(copy);
+    return ret;
+}
+
+e_modbus_gateway_t *e_modbus_gateway_create(struct event_base *base, int timeout_ms) {
+    if (!base) return NULL;
+
+    e_modbus_gateway_t *gw = calloc(1, sizeof(e_modbus_gateway_t));
+    if (!gw) {
+        perror("Failed to allocate gateway");
+        return NULL;
+    }
+    gw->base = base;
+    gw->timeout_ms = timeout_ms > 0 ? timeout_ms : GW_DEFAULT_TIMEOUT_MS;
+    gw->coalesce_gap = GW_DEFAULT_COALESCE_GAP;
+    pthread_mutex_init(&gw->rx_mutex, NULL);
+    e_queue_init(&gw->rx_queue, 0);
+
+    gw->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (gw->notify_fd < 0) {
+        perror("eventfd failed");
+        free(gw);
+        return NULL;
+    }
+    gw->notify_ev = event_new(base, gw->notify_fd, EV_READ | EV_PERSIST, notify_cb, gw);
+    event_add(gw->notify_ev, NULL);
+    return gw;
+}
+
+void e_modbus_gateway_set_coalesce(e_modbus_gateway_t *gw, int gap, int span) {
+    if (!gw) return;
+    gw->coalesce_gap = gap < 0 ? -1 : gap;
+    gw->coalesce_span = span > 0 ? span : 0;
+}
+
+int e_modbus_gateway_set_cache(e_modbus_gateway_t *gw, const char *spec) {
+    if (!gw || !spec) return -1;
+
+    // 先试解析一次，规则有误时尽早报错
+    e_modbus_cache_t *probe = e_modbus_cache_create(0);
+    if (!probe) return -1;
+    int ret = e_modbus_cache_set_ttl(probe, spec);
+    e_modbus_cache_destroy(probe);
+    if (ret != 0) return -1;
+
+    free(gw->cache_spec);
+    gw->cache_spec = strdup(spec);
+    return gw->cache_spec ? 0 : -1;
+}
+
+int e_modbus_gateway_start(e_modbus_gateway_t *gw) {
+    if (!gw || gw->bus_count == 0) return -1;
+
+    for (int i = 0; i < gw->bus_count; i++) {
+        gw_bus_t *bus = gw->buses[i];
+        bus->monitor = e_monitor_create_default(bus->uid, monitor_recv_cb);
+        if (!bus->monitor) {
+            fprintf(stderr, "Could not create monitor for %s\n", bus->uid);
+            return -1;
+        }
+        bus->monitor->arg = bus;
+        if (gw->cache_spec) {
+            bus->cache = e_modbus_cache_create(0);
+            if (!bus->cache || e_modbus_cache_set_ttl(bus->cache, gw->cache_spec) != 0) {
+                fprintf(stderr, "Could not create cache for %s\n", bus->uid);
+                return -1;
+            }
+            // 订阅采集器的轮询结果与写通知
+            e_device_subscribe_data(bus->monitor);
+        }
+        e_monitor_listen(bus->monitor);
+        printf("[GATEWAY] bus %s ready\n", bus->uid);
+    }
+    return 0;
+}
+
+void e_modbus_gateway_print_stats(e_modbus_gateway_t *gw) {
+    if (!gw) return;
+
+    for (int i = 0; i < gw->bus_count; i++) {
+        gw_bus_t *bus = gw->buses[i];
+        printf("[GATEWAY] bus %s: req %llu rsp %llu exc %llu timeout %llu late %llu rejected %llu coalesced %llu, queued %d%s\n",
+               bus->uid,
+               (unsigned long long)bus->stats.requests, (unsigned long long)bus->stats.responses,
+               (unsigned long long)bus->stats.exceptions, (unsigned long long)bus->stats.timeouts,
+               (unsigned long long)bus->stats.late,
+               (unsigned long long)bus->stats.rejected, (unsigned long long)bus->stats.coalesced,
+               e_queue_size(&bus->queue),
+               bus->inflight ? ", busy" : bus->guard ? ", guard" : "");
+        if (bus->cache) {
+            const e_modbus_cache_stats_t *cs = &bus->cache->stats;
+            printf("[GATEWAY] bus %s cache: %d points, hit %llu miss %llu store %llu invalidate %llu\n",
+                   bus->uid, bus->cache->size,
+                   (unsigned long long)cs->hits, (unsigned long long)cs->misses,
+                   (unsigned long long)cs->stores, (unsigned long long)cs->invalidations);
+        }
+    }
+}
+
+void e_modbus_gateway_destroy(e_modbus_gateway_t *gw) {
+    if (!gw) return;
+
+    for (int i = 0; i < gw->bus_count; i++) {
+        gw_bus_t *bus = gw->buses[i];
+        if (bus->monitor) {
+            e_monitor_stop(bus->monitor);
+            e_monitor_destroy(bus->monitor);
+        }
+        event_free(bus->timer);
+        e_queue_destroy(&bus->queue);
+        txn_free(bus->inflight);
+        e_modbus_cache_destroy(bus->cache);
+        free(bus->uid);
+        free(bus);
+    }
+    free(gw->buses);
+
+    while (gw->clients) {
+        gw_client_t *next = gw->clients->next;
+        free(gw->clients);
+        gw->clients = next;
+    }
+
+    free(gw->cache_spec);
+    event_free(gw->notify_ev);
+    close(gw->notify_fd);
+    e_queue_destroy(&gw->rx_queue);
+    pthread_mutex_destroy(&gw->rx_mutex);
+    free(gw);
+}
@@ -0,0 +1,166 @@
+#ifndef E_MODBUS_GATEWAY_H
+#define E_MODBUS_GATEWAY_H
+
+#include <ezmb/ezmb.h>
+#include <ezmb/e_queue.h>
+#include <ezmb/e_modbus.h>
+#include <ezmb/e_modbus_cache.h>
+#include <event2/event.h>
+#include <event2/bufferevent.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#define MBAP_HEADER_LEN             7       // 事务号2 + 协议号2 + 长度2 + 单元号1
+#define MBAP_MAX_ADU                260     // MBAP 头 + 最大 PDU 253
+#define GW_MAX_UNITS                256
+#define GW_BUS_QUEUE_MAX            64      // 每条总线排队的最大事务数，超过应答从站忙
+/*
+ * 默认事务超时。请求在采集器一侧可能排在扫描轮询之后，最坏等待约为
+ * 串口超时 x (可能排在前面的轮询数 + 1)，超时应不小于该值，否则迟到的响应会落入超时后的静默期被丢弃
+ */
+#define GW_DEFAULT_TIMEOUT_MS       1000
+#define GW_BROADCAST_DELAY_MS       100     // 广播请求后的总线静默时间
+#define GW_DEFAULT_COALESCE_GAP     0       // 默认只合并重叠或相邻的读请求
+
+/* TCP 客户端：按 MBAP 长度字段重组请求 */
+typedef struct gw_client {
+    struct bufferevent *bev;
+    uint8_t buf[MBAP_MAX_ADU];
+    size_t len;
+    struct gw_client *next;
+} gw_client_t;
+
+/* 一次网关事务 */
+typedef struct gw_txn {
+    gw_client_t *client;            // 发起请求的客户端，断开后置为 NULL，响应丢弃
+    uint16_t tid;                   // MBAP 事务号
+    uint8_t unit;                   // MBAP 单元号（原样应答）
+    e_modbus_request_t req;         // 解析后的请求，用于匹配响应
+    uint8_t frame[MODBUS_RTU_MAX_ADU]; // 发往总线的 RTU 帧
+    size_t frame_len;
+    struct gw_txn *next;            // 合并到同一次总线读取的其他事务
+} gw_txn_t;
+
+/* 网关统计 */
+typedef struct {
+    uint64_t requests;              // 已发往总线的请求数
+    uint64_t responses;             // 正常应答数
+    uint64_t exceptions;            // 从站异常应答数
+    uint64_t timeouts;              // 超时数
+    uint64_t rejected;              // 队列满或路由不存在被网关直接拒绝的请求数
+    uint64_t coalesced;             // 合并进其他读请求、未单独占用总线的请求数
+    uint64_t late;                  // 超时后的静默期内丢弃的迟到数据次数
+} gw_stats_t;
+
+struct e_modbus_gateway;
+
+/* RTU 总线：一个串口 uid，事务在总线上串行执行；该串口只能由网关发送请求 */
+typedef struct gw_bus {
+    struct e_modbus_gateway *gw;
+    char *uid;
+    e_device_t *monitor;            // 与采集器通信的监视器
+    e_queue_t queue;                // 排队中的事务（gw_txn_t*）
+    gw_txn_t *inflight;             // 正在等待响应的事务（链表），NULL 表示总线空闲
+    e_modbus_request_t req;         // 实际发往总线的请求，合并读取时覆盖链表中所有事务的地址范围
+    uint8_t rx[MODBUS_RTU_MAX_ADU]; // 响应重组缓冲
+    size_t rx_len;
+    struct event *timer;            // 事务超时/广播静默/超时后静默期定时器
+    int guard;                      // 1 表示处于超时后的静默期：丢弃收到的数据，不发送新请求
+    e_modbus_cache_t *cache;        // 寄存器映像缓存，NULL 表示不缓存
+    gw_stats_t stats;
+} gw_bus_t;
+
+/* 串口侧收到的数据，由监视器线程投递给事件循环 */
+typedef struct {
+    gw_bus_t *bus;
+    int json;                       // 1 表示数据主题上的 JSON（以 '\0' 结尾）
+    size_t len;
+    uint8_t data[];
+} gw_rx_t;
+
+/* Modbus TCP 到 RTU 网关：所有总线与客户端状态只在事件循环线程中访问 */
+typedef struct e_modbus_gateway {
+    struct event_base *base;
+    gw_bus_t *units[GW_MAX_UNITS];  // 单元号 -> 总线
+    gw_bus_t **buses;
+    int bus_count;
+    gw_client_t *clients;
+    int timeout_ms;
+    int coalesce_gap;               // 合并读请求允许跨过的最大地址空洞，-1 表示不合并
+    int coalesce_span;              // 合并后的最大数量，0 表示协议上限
+    char *cache_spec;               // 缓存 TTL 规则，NULL 表示不缓存
+    int notify_fd;                  // eventfd，监视器线程收到数据后唤醒事件循环
+    struct event *notify_ev;
+    pthread_mutex_t rx_mutex;       // 保护 rx_queue
+    e_queue_t rx_queue;             // 待处理的串口数据（gw_rx_t*）
+} e_modbus_gateway_t;
+
+/**
+ * @brief 创建网关
+ * @param base 事件循环
+ * @param timeout_ms 事务超时时间
+ * @return 网关句柄，失败返回NULL
+ */
+e_modbus_gateway_t *e_modbus_gateway_create(struct event_base *base, int timeout_ms);
+
+/**
+ * @brief 设置单元号路由
+ * @param gw 网关句柄
+ * @param spec 路由表，如 "1=port1,2-10=port2,*=port3"，* 表示其余所有单元号
+ * @return 0成功，-1失败
+ */
+int e_modbus_gateway_set_routes(e_modbus_gateway_t *gw, const char *spec);
+
+/**
+ * @brief 设置读请求合并参数：同一总线上排队的同从站、同功能码读请求合并为一次总线读取
+ * @param gw 网关句柄
+ * @param gap 允许跨过的最大地址空洞，-1 表示不合并
+ * @param span 合并后的最大数量，0 表示协议上限
+ */
+void e_modbus_gateway_set_coalesce(e_modbus_gateway_t *gw, int gap, int span);
+
+/**
+ * @brief 启用寄存器缓存：读请求的所有点均未过期时直接由缓存应答；
+ * 缓存由网关自身的读取和采集器数据主题上的轮询结果填充，由写请求和采集器的写通知失效
+ * @param gw 网关句柄
+ * @param spec TTL 规则，格式见 e_modbus_cache_set_ttl，如 "500,1:3:100-120=2000"
+ * @return 0成功，-1失败
+ */
+int e_modbus_gateway_set_cache(e_modbus_gateway_t *gw, const char *spec);
+
+/**
+ * @brief 创建各总线的监视器并开始监听
+ * @param gw 网关句柄
+ * @return 0成功，-1失败
+ */
+int e_modbus_gateway_start(e_modbus_gateway_t *gw);
+
+/**
+ * @brief 处理 TCP 客户端数据（事件循环线程）
+ * @param gw 网关句柄
+ * @param bev 客户端
+ * @param data 数据
+ * @param len 数据长度
+ */
+void e_modbus_gateway_on_recv(e_modbus_gateway_t *gw, struct bufferevent *bev, const void *data, size_t len);
+
+/**
+ * @brief TCP 客户端断开（事件循环线程），其未完成事务的响应将被丢弃
+ * @param gw 网关句柄
+ * @param bev 客户端
+ */
+void e_modbus_gateway_on_close(e_modbus_gateway_t *gw, struct bufferevent *bev);
+
+/**
+ * @brief 打印各总线统计信息
+ * @param gw 网关句柄
+ */
+void e_modbus_gateway_print_stats(e_modbus_gateway_t *gw);
+
+/**
+ * @brief 销毁网关
+ * @param gw 网关句柄
+ */
+void e_modbus_gateway_destroy(e_modbus_gateway_t *gw);
+
+#endif // E_MODBUS_GATEWAY_H
@@ -0,0 +1,165 @@
+#include "e_plugin_router.h"
+#include <fnmatch.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+e_plugin_router_t *e_plugin_router_create(const char *spec, const char *default_path) {
+    e_plugin_router_t *router = calloc(1, sizeof(e_plugin_router_t));
+    if (!router) {
+        perror("Failed to allocate plugin router");
+        return NULL;
+    }
+    if (e_hash_init(&router->ids, ROUTER_MAX_TOPICS) != 0 ||
+        (default_path && !(router->default_path = strdup(default_path)))) {
+        e_plugin_router_destroy(router);
+        return NULL;
+    }
+    if (!spec) return router;
+
+    char *copy = strdup(spec);
+    if (!copy) {
+        e_plugin_router_destroy(router);
+        return NULL;
+    }
+
+    int ret = 0;
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(copy, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        char *eq = strchr(tok, '=');
+        if (!eq || eq == tok || !eq[1]) {
+            fprintf(stderr, "Invalid plugin route '%s' (expected pattern=plugin)\n", tok);
+            ret = -1;
+            break;
+        }
+        if (router->rule_count == ROUTER_MAX_RULES) {
+            fprintf(stderr, "Too many plugin routes (max %d)\n", ROUTER_MAX_RULES);
+            ret = -1;
+            break;
+        }
+        *eq = '\0';
+        router_rule_t *rule = &router->rules[router->rule_count++];
+        rule->pattern = strdup(tok);
+        rule->path = strdup(eq + 1);
+        if (!rule->pattern || !rule->path) {
+            ret = -1;
+            break;
+        }
+    }
+    free(copy);
+
+    if (ret != 0) {
+        e_plugin_router_destroy(router);
+        return NULL;
+    }
+    return router;
+}
+
+void e_plugin_router_set_budget(e_plugin_router_t *router, const e_plugin_budget_t *budget) {
+    if (!router || !budget) return;
+    router->budget = *budget;
+    router->has_budget = true;
+}
+
+/* 取得路径对应的插件，首次使用时加载 */
+static e_plugin_context_t *get_plugin(e_plugin_router_t *router, const char *path) {
+    for (int i = 0; i < router->plugin_count; i++) {
+        if (strcmp(router->plugins[i].path, path) == 0) return router->plugins[i].ctx;
+    }
+
+    e_plugin_context_t *ctx = e_plugin_create(path);
+    if (!ctx) {
+        fprintf(stderr, "Failed to load plugin %s\n", path);
+        return NULL;
+    }
+    if (router->has_budget) e_plugin_set_budget(ctx, &router->budget);
+
+    router_plugin_t *plugin = &router->plugins[router->plugin_count];
+    if (!(plugin->path = strdup(path))) {
+        e_plugin_destroy(ctx);
+        return NULL;
+    }
+    plugin->ctx = ctx;
+    router->plugin_count++;
+    return ctx;
+}
+
+int e_plugin_router_intern(e_plugin_router_t *router, const char *uid) {
+    if (!router || !uid) return -1;
+
+    void *found = e_hash_get(&router->ids, uid);
+    if (found) return (int)(intptr_t)found - 1;
+
+    if (router->topic_count == ROUTER_MAX_TOPICS) {
+        fprintf(stderr, "Too many plugin routes for uid %s (max %d)\n", uid, ROUTER_MAX_TOPICS);
+        return -1;
+    }
+
+    // 按规则顺序匹配，只在登记时比较一次
+    const char *path = router->default_path;
+    for (int i = 0; i < router->rule_count; i++) {
+        if (fnmatch(router->rules[i].pattern, uid, 0) == 0) {
+            path = router->rules[i].path;
+            break;
+        }
+    }
+
+    e_plugin_context_t *ctx = NULL;
+    if (path && !(ctx = get_plugin(router, path))) return -1;
+
+    int id = router->topic_count;
+    router->topics[id] = strdup(uid);
+    if (!router->topics[id] || e_hash_put(&router->ids, uid, (void *)(intptr_t)(id + 1)) != 0) {
+        free(router->topics[id]);
+        router->topics[id] = NULL;
+        return -1;
+    }
+    router->routes[id] = ctx;
+    router->topic_count++;
+    printf("[ROUTER] %s -> %s\n", uid, path ? path : "(none)");
+    return id;
+}
+
+e_plugin_context_t *e_plugin_router_get(const e_plugin_router_t *router, int id) {
+    return router->routes[id];
+}
+
+bool e_plugin_router_has_plugins(const e_plugin_router_t *router) {
+    return router->plugin_count > 0;
+}
+
+void e_plugin_router_reload(e_plugin_router_t *router) {
+    if (!router) return;
+    for (int i = 0; i < router->plugin_count; i++) {
+        if (e_plugin_reload(router->plugins[i].ctx, NULL) == 0) {
+            printf("plugin reloaded: %s\n", router->plugins[i].path);
+        }
+    }
+}
+
+void e_plugin_router_print_stats(e_plugin_router_t *router) {
+    if (!router) return;
+    for (int i = 0; i < router->plugin_count; i++) {
+        printf("[%s]\n", router->plugins[i].path);
+        e_plugin_print_stats(router->plugins[i].ctx);
+    }
+}
+
+void e_plugin_router_destroy(e_plugin_router_t *router) {
+    if (!router) return;
+    for (int i = 0; i < router->rule_count; i++) {
+        free(router->rules[i].pattern);
+        free(router->rules[i].path);
+    }
+    for (int i = 0; i < router->plugin_count; i++) {
+        e_plugin_destroy(router->plugins[i].ctx);
+        free(router->plugins[i].path);
+    }
+    for (int i = 0; i < router->topic_count; i++) {
+        free(router->topics[i]);
+    }
+    e_hash_destroy(&router->ids);
+    free(router->default_path);
+    free(router);
+}
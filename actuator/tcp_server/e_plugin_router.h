@@ -0,0 +1,94 @@
+#ifndef E_PLUGIN_ROUTER_H
+#define E_PLUGIN_ROUTER_H
+
+#include <ezmb/e_hash.h>
+#include <ezmb/e_plugin_driver.h>
+
+#define ROUTER_MAX_RULES            64
+#define ROUTER_MAX_TOPICS           256     // 最多登记的 uid 数
+
+/* 路由规则：uid 匹配 pattern（fnmatch）时使用 path 指定的插件 */
+typedef struct {
+    char *pattern;
+    char *path;
+} router_rule_t;
+
+/* 已加载的插件，同一路径只加载一次，多个 uid 共用 */
+typedef struct {
+    char *path;
+    e_plugin_context_t *ctx;
+} router_plugin_t;
+
+/*
+ * 插件路由表：登记 uid 时按规则顺序匹配一次，把结果保存在按主题 ID 下标的数组中，
+ * 转发时按主题 ID 直接取出插件，不再比较字符串。
+ */
+typedef struct {
+    router_rule_t rules[ROUTER_MAX_RULES];
+    int rule_count;
+    char *default_path;                         // 没有规则匹配时使用的插件，NULL 表示透传
+    router_plugin_t plugins[ROUTER_MAX_RULES + 1];
+    int plugin_count;
+    e_hash_t ids;                               // uid -> 主题 ID + 1
+    char *topics[ROUTER_MAX_TOPICS];            // 主题 ID -> uid
+    e_plugin_context_t *routes[ROUTER_MAX_TOPICS];  // 主题 ID -> 插件，NULL 表示透传
+    int topic_count;
+    e_plugin_budget_t budget;
+    bool has_budget;
+} e_plugin_router_t;
+
+/**
+ * @brief 创建插件路由表
+ * @param spec 路由规则 "pattern=path[,pattern=path...]"，按顺序匹配，可为 NULL
+ * @param default_path 没有规则匹配时使用的插件，可为 NULL
+ * @return 路由表，NULL 表示规则格式错误
+ */
+e_plugin_router_t *e_plugin_router_create(const char *spec, const char *default_path);
+
+/**
+ * @brief 设置之后加载的插件的 lua CPU 预算，应在登记 uid 之前调用
+ * @param router 路由表
+ * @param budget 预算
+ */
+void e_plugin_router_set_budget(e_plugin_router_t *router, const e_plugin_budget_t *budget);
+
+/**
+ * @brief 登记 uid，匹配路由规则并加载所需插件，重复登记返回同一 ID
+ * @param router 路由表
+ * @param uid 设备uid
+ * @return 主题 ID，-1 失败（插件加载失败或超过 ROUTER_MAX_TOPICS）
+ */
+int e_plugin_router_intern(e_plugin_router_t *router, const char *uid);
+
+/**
+ * @brief 按主题 ID 取得插件
+ * @param router 路由表
+ * @param id 主题 ID
+ * @return 插件上下文，NULL 表示透传
+ */
+e_plugin_context_t *e_plugin_router_get(const e_plugin_router_t *router, int id);
+
+/**
+ * @brief 路由表是否加载了插件
+ */
+bool e_plugin_router_has_plugins(const e_plugin_router_t *router);
+
+/**
+ * @brief 重新加载全部插件，失败的插件保持原样
+ * @param router 路由表
+ */
+void e_plugin_router_reload(e_plugin_router_t *router);
+
+/**
+ * @brief 打印全部插件的转换统计
+ * @param router 路由表
+ */
+void e_plugin_router_print_stats(e_plugin_router_t *router);
+
+/**
+ * @brief 销毁路由表与已加载的插件
+ * @param router 路由表
+ */
+void e_plugin_router_destroy(e_plugin_router_t *router);
+
+#endif // E_PLUGIN_ROUTER_H
@@ -46,6 +46,7 @@ e_tcp_server_t *e_tcp_server_create(struct event_base *base, int port, e_tcp_ser
 
     server->port = port;
     server->read_cb = cb;
+    server->close_cb = NULL;
     server->client_count = 0;
     server->client_capacity = E_TCP_SERVER_CLIENT_CAPACITY;
     server->clients = (struct bufferevent **)malloc(server->client_capacity * sizeof(struct bufferevent *));
@@ -58,6 +59,12 @@ e_tcp_server_t *e_tcp_server_create(struct event_base *base, int port, e_tcp_ser
     return server;
 }
 
+void e_tcp_server_set_close_callback(e_tcp_server_t *server, e_tcp_server_close_callback cb) {
+    if (server) {
+        server->close_cb = cb;
+    }
+}
+
 static void *e_tcp_server_send(void *arg) {
     send_arg_t *send_arg = (send_arg_t *)arg;
     e_tcp_server_t *server = send_arg->server;
@@ -167,5 +174,8 @@ static void conn_eventcb(struct bufferevent *bev, short events, void *user_data)
     }
 
     e_tcp_server_remove_client(server, bev);
+    if (server->close_cb) {
+        server->close_cb((void *)bev);
+    }
     bufferevent_free(bev);
 }
\ No newline at end of file
@@ -12,6 +12,13 @@
  */
 typedef void (*e_tcp_server_rev_callback)(const void *payload, size_t size, void *data);
 
+/**
+ * @brief 客户端断开回调类型，data 为断开的 bufferevent，回调返回后即被释放
+ * 
+ * 
+ */
+typedef void (*e_tcp_server_close_callback)(void *data);
+
 /**
  * @brief TCP 服务器结构体
  * 
@@ -22,6 +29,7 @@ typedef struct e_tcp_server {
     struct sockaddr_in sin;          // 服务器地址
     int port;
     e_tcp_server_rev_callback read_cb; // 读取回调函数
+    e_tcp_server_close_callback close_cb; // 客户端断开回调函数
     struct bufferevent **clients;     // 客户端列表
     int client_count;                // 客户端数量
     int client_capacity;             // 客户端列表容量
@@ -49,6 +57,13 @@ typedef struct {
  */
 e_tcp_server_t *e_tcp_server_create(struct event_base *base, int port, e_tcp_server_rev_callback cb);
 
+/**
+ * @brief 设置客户端断开回调
+ * @param server 服务器结构体
+ * @param cb 回调函数
+ */
+void e_tcp_server_set_close_callback(e_tcp_server_t *server, e_tcp_server_close_callback cb);
+
 /**
  * @brief 启动事件循环（如果需要）
  * @param server 服务器结构体
@@ -9,11 +9,33 @@
 
 void e_tcp_server_config_usage(const char *prog) {
     fprintf(stderr, "Usage: %s [options]\n", prog);
-    fprintf(stderr, "  -u, --uid <uid>                 UID for south device\n");
+    fprintf(stderr, "  -u, --uid <uid[,uid...]>        UID for south device, repeat or comma separate for several\n");
+    fprintf(stderr, "                                  (several need a plugin each; TCP data goes to every device\n");
+    fprintf(stderr, "                                  whose plugin accepts it)\n");
     fprintf(stderr, "  -l, --listen <port>             TCP server port (e.g., 8080)\n");
     fprintf(stderr, "  -p, --plugin <path>             Plugin path (e.g., /usr/lib/e_plugin.so)\n");
+    fprintf(stderr, "  -B, --budget <spec>             Lua plugin CPU budget per call:\n");
+    fprintf(stderr, "                                  <time_us>[,<instructions>][:drop|pass|disable] (default drop)\n");
+    fprintf(stderr, "  -R, --route <pattern=path,...>  Per-device plugins, first uid pattern match wins,\n");
+    fprintf(stderr, "                                  devices without a match use -p\n");
+    fprintf(stderr, "  -G, --gateway <routes>          Modbus TCP gateway mode, unit to serial uid routes\n");
+    fprintf(stderr, "                                  (e.g., 1=port1,2-10=port2,*=port3)\n");
+    fprintf(stderr, "                                  Read replies carry no address, so no other monitor may send\n");
+    fprintf(stderr, "                                  requests to a routed serial uid\n");
+    fprintf(stderr, "  -T, --timeout <ms>              Gateway transaction timeout (default 1000 ms); must cover the\n");
+    fprintf(stderr, "                                  collector's worst case, serial timeout x (queued scan polls + 1).\n");
+    fprintf(stderr, "                                  After a timeout the bus stays idle for this long to drop late replies\n");
+    fprintf(stderr, "  -g, --coalesce-gap <n>          Merge queued reads whose addresses are at most n apart\n");
+    fprintf(stderr, "                                  (default 0: overlapping or adjacent only, -1 disables)\n");
+    fprintf(stderr, "  -S, --coalesce-span <n>         Maximum registers/coils in a merged read (default protocol limit)\n");
+    fprintf(stderr, "  -c, --cache <ttl[,rules]>       Answer reads from a register cache, TTL in ms with optional\n");
+    fprintf(stderr, "                                  slave:function:address[-address]=ttl rules (* matches any)\n");
     fprintf(stderr, "\nExample:\n");
     fprintf(stderr, "  %s -u ttyusb2 -l 8080 -p /usr/lib/e_plugin.so\n", prog);
+    fprintf(stderr, "  %s -u ttyusb2 -l 8080 -p plug.lua -B 5000:pass\n", prog);
+    fprintf(stderr, "  %s -u meter1,meter2,plc1 -l 8080 -R 'meter*=meter.json,plc*=plc.so'\n", prog);
+    fprintf(stderr, "  %s -l 502 -G 1-5=port1,*=port2\n", prog);
+    fprintf(stderr, "  %s -l 502 -G *=port1 -c 500,1:3:100-120=2000\n", prog);
 }
 
 void e_tcp_server_config_print(const tcp_server_config_t *config) {
@@ -22,6 +44,15 @@ void e_tcp_server_config_print(const tcp_server_config_t *config) {
     printf("    Listen port  : %d\n", config->port);
     printf("    Plugin path  : %s\n", config->plugin_path);
     printf("    Plugin enable: %s\n", config->plugin_enable ? "true" : "false");
+    printf("    Plugin budget: %s\n", config->plugin_budget ? config->plugin_budget : "unlimited");
+    printf("    Plugin routes: %s\n", config->plugin_routes ? config->plugin_routes : "none");
+    if (config->gateway_routes) {
+        printf("    Gateway      : %s\n", config->gateway_routes);
+        printf("    Timeout (ms) : %d\n", config->gateway_timeout_ms);
+        printf("    Coalesce gap : %d\n", config->coalesce_gap);
+        printf("    Coalesce span: %d\n", config->coalesce_span);
+        printf("    Cache        : %s\n", config->cache_spec ? config->cache_spec : "disabled");
+    }
 }
 
 static void e_tcp_server_config_init(tcp_server_config_t *config) {
@@ -29,6 +60,24 @@ static void e_tcp_server_config_init(tcp_server_config_t *config) {
     config->port = 0;
     config->plugin_path = NULL;
     config->plugin_enable = false;
+    config->plugin_budget = NULL;
+    config->plugin_routes = NULL;
+    config->gateway_routes = NULL;
+    config->gateway_timeout_ms = 1000;
+    config->coalesce_gap = 0;
+    config->coalesce_span = 0;
+    config->cache_spec = NULL;
+}
+
+/* -u 可重复指定，多个 uid 以逗号连接 */
+static int append_uid(tcp_server_config_t *config, const char *uid) {
+    size_t len = config->uid ? strlen(config->uid) + 1 : 0;
+    char *list = realloc(config->uid, len + strlen(uid) + 1);
+    if (!list) return -1;
+    if (len) list[len - 1] = ',';
+    strcpy(list + len, uid);
+    config->uid = list;
+    return 0;
 }
 
 bool e_tcp_server_config_parse(int argc, char **argv, tcp_server_config_t *config) {
@@ -38,17 +87,24 @@ bool e_tcp_server_config_parse(int argc, char **argv, tcp_server_config_t *confi
         {"uid", required_argument, 0, 'u'},
         {"listen", required_argument, 0, 'l'},
         {"plugin", required_argument, 0, 'p'},
+        {"budget", required_argument, 0, 'B'},
+        {"route", required_argument, 0, 'R'},
+        {"gateway", required_argument, 0, 'G'},
+        {"timeout", required_argument, 0, 'T'},
+        {"coalesce-gap", required_argument, 0, 'g'},
+        {"coalesce-span", required_argument, 0, 'S'},
+        {"cache", required_argument, 0, 'c'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     int opt;
     int long_index = 0;
-    while ((opt = getopt_long(argc, argv, "u:l:p:h", 
+    while ((opt = getopt_long(argc, argv, "u:l:p:B:R:G:T:g:S:c:h", 
                             long_options, &long_index)) != -1) {
         switch (opt) {
             case 'u':
-                config->uid = strdup(optarg);
+                if (append_uid(config, optarg) != 0) return false;
                 break;
             case 'l':
                 config->port = atoi(optarg);
@@ -57,6 +113,39 @@ bool e_tcp_server_config_parse(int argc, char **argv, tcp_server_config_t *confi
                 config->plugin_path = strdup(optarg);
                 config->plugin_enable = true;
                 break;
+            case 'B':
+                config->plugin_budget = strdup(optarg);
+                break;
+            case 'R':
+                config->plugin_routes = strdup(optarg);
+                break;
+            case 'G':
+                config->gateway_routes = strdup(optarg);
+                break;
+            case 'T':
+                config->gateway_timeout_ms = atoi(optarg);
+                if (config->gateway_timeout_ms <= 0) {
+                    fprintf(stderr, "Invalid timeout (>0)\n");
+                    return false;
+                }
+                break;
+            case 'g':
+                config->coalesce_gap = atoi(optarg);
+                if (config->coalesce_gap < -1) {
+                    fprintf(stderr, "Invalid coalesce gap (>=-1)\n");
+                    return false;
+                }
+                break;
+            case 'S':
+                config->coalesce_span = atoi(optarg);
+                if (config->coalesce_span < 0) {
+                    fprintf(stderr, "Invalid coalesce span (>=0)\n");
+                    return false;
+                }
+                break;
+            case 'c':
+                config->cache_spec = strdup(optarg);
+                break;
             case 'h':
                 e_tcp_server_config_usage(argv[0]);
                 exit(EXIT_SUCCESS);
@@ -65,7 +154,8 @@ bool e_tcp_server_config_parse(int argc, char **argv, tcp_server_config_t *confi
         }
     }
 
-    if (config->uid == NULL || config->port == 0) {
+    // 网关模式按路由表连接多个串口，不需要 -u
+    if ((config->uid == NULL && config->gateway_routes == NULL) || config->port == 0) {
         e_tcp_server_config_usage(argv[0]);
         return false;
     }
@@ -5,15 +5,29 @@
 
 /**
  * @brief TCP 服务器配置
- * @param uid 监听设备ID
+ * @param uid 监听设备ID，多个设备以逗号分隔
  * @param port 监听端口
  * @param plugin_path 插件路径
+ * @param plugin_budget lua 插件每次调用的 CPU 预算描述，NULL 表示不限制
+ * @param plugin_routes 按设备选择插件的路由规则（uid模式=插件路径），未匹配的设备使用 plugin_path
+ * @param gateway_routes Modbus TCP 网关路由（单元号=串口uid），NULL 表示透传模式
+ * @param gateway_timeout_ms 网关事务超时时间
+ * @param coalesce_gap 网关合并读请求允许跨过的最大地址空洞，-1 表示不合并
+ * @param coalesce_span 网关合并读取的最大数量，0 表示协议上限
+ * @param cache_spec 网关寄存器缓存 TTL 规则，NULL 表示不缓存
  */
 typedef struct {
     char *uid;
     int port;
     bool plugin_enable;
     char *plugin_path;
+    char *plugin_budget;
+    char *plugin_routes;
+    char *gateway_routes;
+    int gateway_timeout_ms;
+    int coalesce_gap;
+    int coalesce_span;
+    char *cache_spec;
 } tcp_server_config_t;
 
 /**
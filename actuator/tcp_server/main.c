@@ -1,5 +1,7 @@
 #include "e_tcp_server.h"
 #include "e_tcp_server_config.h"
+#include "e_modbus_gateway.h"
+#include "e_plugin_router.h"
 #include <ezmb/ezmb.h>
 #include <ezmb/e_queue.h>
 #include <ezmb/e_plugin_driver.h>
@@ -14,12 +16,15 @@
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <signal.h>
 
 static tcp_server_config_t g_config;
-static e_queue_t g_queue;
-static e_device_t *g_monitor = NULL;
-static e_plugin_context_t *g_plugin_ctx = NULL;
+static e_queue_t g_queue;                           // 监视器线程与事件循环写入，转发线程读取
+static pthread_mutex_t g_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_queue_cond = PTHREAD_COND_INITIALIZER;
+static e_plugin_router_t *g_router = NULL;
 static e_tcp_server_t *g_tcpser = NULL;
+static e_modbus_gateway_t *g_gateway = NULL;
 
 typedef enum {
     MESSAGE_TYPE_TO_SERVER = 0,
@@ -28,10 +33,20 @@ typedef enum {
 
 typedef struct {
     message_type_t type;
+    int id;             // 北向消息来源设备的主题 ID
     void *payload;
     size_t size;
 } message_queue_t;
 
+/* 转发的设备：-u 指定的每个 uid 一个监视器，下标为其在路由表中的主题 ID */
+typedef struct {
+    int id;
+    e_device_t *monitor;
+} relay_device_t;
+
+static relay_device_t g_devices[ROUTER_MAX_TOPICS];
+static int g_device_count = 0;
+
 static void hexdump(const char *data, size_t len) {
     for (size_t i = 0; i < len; i++) {
         if (i % 8 == 0) {
@@ -60,6 +75,14 @@ static void hexdump(const char *data, size_t len) {
     }
 }
 
+/* 放入转发队列并唤醒转发线程，可在任意线程调用 */
+static void queue_push(message_queue_t *msg) {
+    pthread_mutex_lock(&g_queue_lock);
+    e_queue_push(&g_queue, msg);
+    pthread_cond_signal(&g_queue_cond);
+    pthread_mutex_unlock(&g_queue_lock);
+}
+
 static void tcp_server_recv_callback(const void *payload, size_t size, void *data) {
     struct bufferevent *bev = (struct bufferevent *)data;
     struct sockaddr_storage addr;
@@ -85,75 +108,186 @@ static void tcp_server_recv_callback(const void *payload, size_t size, void *dat
     hexdump(payload, size);
     message_queue_t *msg = (message_queue_t *)malloc(sizeof(message_queue_t));
     msg->type = MESSAGE_TYPE_TO_MONITOR;
+    msg->id = -1;
     msg->payload = malloc(size);
     memcpy(msg->payload, payload, size);
     msg->size = size;
-    e_queue_push(&g_queue, msg);
+    queue_push(msg);
 }
 
 static void monitor_recv_callback(const char *topic, size_t topic_len, const  void *payload, size_t payload_len, void *data) {
-    (void)data;
+    relay_device_t *dev = (relay_device_t *)((e_device_t *)data)->arg;
     printf("[%.*s]monitor recv callback: \n", (int)topic_len, topic);
     hexdump(payload, payload_len);
     message_queue_t *msg = (message_queue_t *)malloc(sizeof(message_queue_t));
     msg->type = MESSAGE_TYPE_TO_SERVER;
+    msg->id = dev->id;
     msg->payload = malloc(payload_len);
     memcpy(msg->payload, payload, payload_len);
     msg->size = payload_len;
-    e_queue_push(&g_queue, msg);
+    queue_push(msg);
+}
+
+#define RELAY_BATCH_MAX 32     // 每次从队列取出的最大消息数
+
+/* 用设备的插件转换一组同方向的消息，北向发给 TCP 客户端，南向发给该设备；有插件时整组批量转换 */
+static void relay_messages(relay_device_t *dev, message_queue_t **msgs, size_t count, e_plugin_buf_t *bufs) {
+    e_plugin_dir_t dir = msgs[0]->type == MESSAGE_TYPE_TO_SERVER ? E_PLUGIN_NORTH : E_PLUGIN_SOUTH;
+    e_plugin_context_t *plugin = e_plugin_router_get(g_router, dev->id);
+    const char *name = dir == E_PLUGIN_NORTH ? "north" : "south";
+    const void *in[RELAY_BATCH_MAX];
+    size_t in_len[RELAY_BATCH_MAX];
+    int status[RELAY_BATCH_MAX];
+
+    for (size_t i = 0; i < count; i++) {
+        in[i] = msgs[i]->payload;
+        in_len[i] = msgs[i]->size;
+        status[i] = 0;
+    }
+    if (plugin) {
+        size_t ok = e_plugin_transform_batch_for(plugin, dir, dev->monitor->uid, in, in_len, bufs, status, count);
+        printf("%s transform done, %zu/%zu messages\n", name, ok, count);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const void *out = in[i];
+        size_t size = in_len[i];
+        if (plugin) {
+            if (status[i] != 0) {
+                // 多个设备时南向消息发给每个设备，插件转换失败表示消息不属于该设备
+                if (dir == E_PLUGIN_NORTH || g_device_count == 1) {
+                    fprintf(stderr, "%s transform failed, message dropped\n", name);
+                }
+                continue;
+            }
+            out = bufs[i].data;
+            size = bufs[i].len;
+            printf("%s transform output, size: %zu, payload: \n", name, size);
+            hexdump(out, size);
+        }
+        if (dir == E_PLUGIN_NORTH) {
+            e_tcp_server_broadcast(g_tcpser, out, size);
+        } else {
+            e_monitor_send(dev->monitor, out, size);
+        }
+    }
 }
 
 static void *app_main_thread(void *arg) {
     (void)arg;
-    e_plugin_driver_t *driver = (e_plugin_driver_t *)malloc(sizeof(e_plugin_driver_t));
-    if (g_config.plugin_enable) {
-        driver = e_plugin_load_driver(g_plugin_ctx);
-    }
+    // 输出缓冲在线程内复用，稳定后转换不再分配内存
+    static e_plugin_buf_t bufs[RELAY_BATCH_MAX];
+    message_queue_t *msgs[RELAY_BATCH_MAX];
     while (1) {
-        if (e_queue_size(&g_queue) > 0) {
-            message_queue_t *msg = (message_queue_t *)e_queue_pop(&g_queue);
-            printf("app_main_thread: %s, size: %zu, payload: \n", msg->type == MESSAGE_TYPE_TO_SERVER ? "to server" : "to monitor", msg->size);
-            hexdump(msg->payload, msg->size);
-            switch (msg->type) {
-                case MESSAGE_TYPE_TO_SERVER:
-                    if (driver->north_transform) {
-                        void *out = NULL;
-                        size_t out_size = 0;
-                        driver->north_transform(g_plugin_ctx, msg->payload, msg->size, (void **)&out, &out_size);
-                        printf("north transform done, size: %zu, payload: \n", out_size);
-                        hexdump(out, out_size);
-                        e_tcp_server_broadcast(g_tcpser, out, out_size);
-                        free(out);
-                    }else{
-                        e_tcp_server_broadcast(g_tcpser, msg->payload, msg->size);
-                    }
-                    break;
-                case MESSAGE_TYPE_TO_MONITOR:
-                    if (driver->south_transform) {
-                        void *out = NULL;
-                        size_t out_size = 0;
-                        driver->south_transform(g_plugin_ctx, msg->payload, msg->size, (void **)&out, &out_size);
-                        printf("south transform done, size: %zu, payload: \n", out_size);
-                        hexdump(out, out_size);
-                        e_monitor_send(g_monitor, out, out_size);
-                        free(out);
-                    }else{
-                        e_monitor_send(g_monitor, msg->payload, msg->size);
-                    }
-                    break;
+        // 一次取出队列中已有的消息，连续同方向的消息批量转换，保持原有顺序
+        size_t n = 0;
+        pthread_mutex_lock(&g_queue_lock);
+        while (e_queue_size(&g_queue) == 0) pthread_cond_wait(&g_queue_cond, &g_queue_lock);
+        while (n < RELAY_BATCH_MAX && e_queue_size(&g_queue) > 0) {
+            msgs[n++] = (message_queue_t *)e_queue_pop(&g_queue);
+        }
+        pthread_mutex_unlock(&g_queue_lock);
+
+        for (size_t i = 0; i < n; i++) {
+            printf("app_main_thread: %s, size: %zu, payload: \n", msgs[i]->type == MESSAGE_TYPE_TO_SERVER ? "to server" : "to monitor", msgs[i]->size);
+            hexdump(msgs[i]->payload, msgs[i]->size);
+        }
+
+        // 北向按来源设备分组；TCP 消息没有地址，南向交给每个设备的插件，只发给插件接受的设备
+        for (size_t i = 0; i < n; ) {
+            size_t j = i + 1;
+            while (j < n && msgs[j]->type == msgs[i]->type && msgs[j]->id == msgs[i]->id) j++;
+            if (msgs[i]->type == MESSAGE_TYPE_TO_SERVER) {
+                relay_messages(&g_devices[msgs[i]->id], msgs + i, j - i, bufs);
+            } else {
+                for (int d = 0; d < g_device_count; d++) relay_messages(&g_devices[d], msgs + i, j - i, bufs);
             }
-            free(msg->payload);
-            free(msg);
-        }else{
-            usleep(10000);
+            i = j;
+        }
+        for (size_t i = 0; i < n; i++) {
+            free(msgs[i]->payload);
+            free(msgs[i]);
         }
     }
-    if (driver) {
-        free(driver);
-    }
+    for (size_t i = 0; i < RELAY_BATCH_MAX; i++) e_plugin_buf_free(&bufs[i]);
     return NULL;
 }
 
+static void *plugin_reload_thread(void *arg) {
+    (void)arg;
+    e_plugin_router_reload(g_router);
+    return NULL;
+}
+
+static void plugin_stats_callback(evutil_socket_t sig, short events, void *arg) {
+    (void)sig;
+    (void)events;
+    (void)arg;
+    e_plugin_router_print_stats(g_router);
+}
+
+static void plugin_reload_callback(evutil_socket_t sig, short events, void *arg) {
+    (void)sig;
+    (void)events;
+    (void)arg;
+    // 在后台线程加载新插件，事件循环与转发线程不等待
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, plugin_reload_thread, NULL) == 0) {
+        pthread_detach(thread);
+    }
+}
+
+static void gateway_recv_callback(const void *payload, size_t size, void *data) {
+    e_modbus_gateway_on_recv(g_gateway, (struct bufferevent *)data, payload, size);
+}
+
+static void gateway_close_callback(void *data) {
+    e_modbus_gateway_on_close(g_gateway, (struct bufferevent *)data);
+}
+
+static void gateway_stats_callback(evutil_socket_t sig, short events, void *arg) {
+    (void)sig;
+    (void)events;
+    (void)arg;
+    e_modbus_gateway_print_stats(g_gateway);
+}
+
+/* Modbus TCP 网关模式：请求按单元号路由到各串口，总线间并行、总线内串行 */
+static int gateway_main(struct event_base *base) {
+    g_gateway = e_modbus_gateway_create(base, g_config.gateway_timeout_ms);
+    if (!g_gateway) {
+        fprintf(stderr, "Could not create gateway!\n");
+        return 1;
+    }
+    e_modbus_gateway_set_coalesce(g_gateway, g_config.coalesce_gap, g_config.coalesce_span);
+    if ((g_config.cache_spec && e_modbus_gateway_set_cache(g_gateway, g_config.cache_spec) != 0) ||
+        e_modbus_gateway_set_routes(g_gateway, g_config.gateway_routes) != 0 ||
+        e_modbus_gateway_start(g_gateway) != 0) {
+        e_modbus_gateway_destroy(g_gateway);
+        return 1;
+    }
+
+    g_tcpser = e_tcp_server_create(base, g_config.port, gateway_recv_callback);
+    if (!g_tcpser) {
+        fprintf(stderr, "Could not create server!\n");
+        e_modbus_gateway_destroy(g_gateway);
+        return 1;
+    }
+    e_tcp_server_set_close_callback(g_tcpser, gateway_close_callback);
+
+    // kill -USR1 <pid> 打印网关统计信息
+    struct event *stats_ev = evsignal_new(base, SIGUSR1, gateway_stats_callback, NULL);
+    event_add(stats_ev, NULL);
+
+    event_base_dispatch(base);
+
+    event_free(stats_ev);
+    evconnlistener_free(g_tcpser->listener);
+    free(g_tcpser->clients);
+    free(g_tcpser);
+    e_modbus_gateway_destroy(g_gateway);
+    return 0;
+}
 
 int main(int argc, char **argv) {
     if (!e_tcp_server_config_parse(argc, argv, &g_config)) {
@@ -166,6 +300,12 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (g_config.gateway_routes) {
+        int ret = gateway_main(base);
+        event_base_free(base);
+        return ret;
+    }
+
     e_queue_init(&g_queue, 0);
 
     g_tcpser = e_tcp_server_create(base, g_config.port, tcp_server_recv_callback);
@@ -175,33 +315,78 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    if (g_config.plugin_enable) {
-        g_plugin_ctx = e_plugin_create(g_config.plugin_path);
-        if (!g_plugin_ctx) {
-            printf("Failed to load Lua plugin\n");
+    g_router = e_plugin_router_create(g_config.plugin_routes, g_config.plugin_path);
+    if (!g_router) {
+        return 1;
+    }
+    if (g_config.plugin_budget) {
+        e_plugin_budget_t budget;
+        if (e_plugin_budget_parse(g_config.plugin_budget, &budget) != 0) {
+            fprintf(stderr, "Invalid plugin budget: %s\n", g_config.plugin_budget);
             return 1;
         }
+        e_plugin_router_set_budget(g_router, &budget);
     }
 
-    g_monitor = e_monitor_create_default(g_config.uid, monitor_recv_callback);
-    if (!g_monitor) {
-        fprintf(stderr, "Could not create monitor!\n");
-        event_base_free(base);
-        return 1;
+    // 每个 uid 在启动时匹配一次路由，转发时按主题 ID 取插件
+    char *saveptr = NULL;
+    for (char *uid = strtok_r(g_config.uid, ",", &saveptr); uid; uid = strtok_r(NULL, ",", &saveptr)) {
+        int id = e_plugin_router_intern(g_router, uid);
+        if (id < 0) {
+            printf("Failed to load plugin for %s\n", uid);
+            return 1;
+        }
+        if (id < g_device_count) continue;
+
+        relay_device_t *dev = &g_devices[g_device_count++];
+        dev->id = id;
+        dev->monitor = e_monitor_create_default(uid, monitor_recv_callback);
+        if (!dev->monitor) {
+            fprintf(stderr, "Could not create monitor for %s!\n", uid);
+            event_base_free(base);
+            return 1;
+        }
+        dev->monitor->arg = dev;
+        e_monitor_listen(dev->monitor);
+    }
+
+    // 透传的设备会收到发给其他设备的命令，转发多个设备时每个设备都要有插件
+    if (g_device_count > 1) {
+        for (int d = 0; d < g_device_count; d++) {
+            if (!e_plugin_router_get(g_router, g_devices[d].id)) {
+                fprintf(stderr, "Relaying to several devices needs a plugin for every uid (-p or -R), %s has none\n",
+                        g_devices[d].monitor->uid);
+                return 1;
+            }
+        }
     }
-    e_monitor_listen(g_monitor);
 
     pthread_t thread;
     pthread_create(&thread, NULL, app_main_thread, NULL);
     pthread_detach(thread);
 
+    // kill -HUP <pid> 重新加载插件，TCP 连接与排队中的消息不受影响
+    // kill -USR1 <pid> 打印插件统计信息
+    struct event *reload_ev = NULL;
+    struct event *stats_ev = NULL;
+    if (e_plugin_router_has_plugins(g_router)) {
+        reload_ev = evsignal_new(base, SIGHUP, plugin_reload_callback, NULL);
+        event_add(reload_ev, NULL);
+        stats_ev = evsignal_new(base, SIGUSR1, plugin_stats_callback, NULL);
+        event_add(stats_ev, NULL);
+    }
+
     event_base_dispatch(base);
 
+    if (reload_ev) event_free(reload_ev);
+    if (stats_ev) event_free(stats_ev);
+
     evconnlistener_free(g_tcpser->listener);
     free(g_tcpser->clients);
     free(g_tcpser);
     event_base_free(base);
-    e_monitor_destroy(g_monitor);
+    for (int d = 0; d < g_device_count; d++) e_monitor_destroy(g_devices[d].monitor);
+    e_plugin_router_destroy(g_router);
 
     printf("done\n");
     return 0;
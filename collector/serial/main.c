@@ -1,5 +1,9 @@
 #include <ezmb/e_serial_manager.h>
+#include <ezmb/e_bus.h>
+#include <ezmb/e_modbus_master.h>
+#include <ezmb/e_crc.h>
 #include <ezmb/ezmb.h>
+#include <json-c/json.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -9,11 +13,30 @@
 #include <fcntl.h>
 #include <sys/select.h>
 #include <sys/time.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
 
 #define MAX_THREAD_COUNT 10 // 最大线程数(暂定，后期修改使用线程池)
 
+/* 串口与北向设备、总线事务层、Modbus 主站的绑定 */
+typedef struct {
+    e_device_t *device;
+    e_bus_t *bus;               // 北向请求与轮询在总线上仲裁
+    int north;                  // 北向监视器在总线上的请求方编号
+    e_modbus_master_t *master;  // 未配置扫描表时为 NULL
+} port_binding_t;
+
 static e_queue_t g_device_queue;
 static serial_manager_t *g_manager;
+static port_binding_t g_bindings[MAX_THREAD_COUNT];
+static int g_binding_count;
+static volatile sig_atomic_t g_dump_stats = 0;
+
+static void on_sigusr1(int sig) {
+    (void)sig;
+    g_dump_stats = 1;
+}
 
 static void hexdump(const char *data, size_t len) {
     for (size_t i = 0; i < len; i++) {
@@ -45,20 +68,98 @@ static void hexdump(const char *data, size_t len) {
 
 static void recv_callback(void *ctx, const char *data, size_t len) {
     serial_context_t *port = (serial_context_t *)ctx;
-    e_device_t *device = (e_device_t *)port->data;
+    port_binding_t *binding = (port_binding_t *)port->data;
+    e_device_t *device = binding->device;
+
+    // 属于总线上当前事务的响应由事务完成回调处理，超出响应缓冲的部分按原始数据转发
+    size_t used = e_bus_feed(binding->bus, data, len);
+    if (used == len) {
+        return;
+    }
+    data += used;
+    len -= used;
 
     printf("[%s] Received %zu bytes:\n", port->ser.uid, len);
     hexdump(data, len);
     printf("send to north topic: %s, rc = %d\n", device->north_topic, e_collector_send(device, data, len));
 }
 
+/* 数据主题消息的公共字段：uid、从站、功能码、地址范围和时间戳 */
+static struct json_object *new_block_json(e_device_t *device, const e_modbus_request_t *req, const char *status) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    struct json_object *root = json_object_new_object();
+    json_object_object_add(root, "uid", json_object_new_string(device->uid));
+    json_object_object_add(root, "slave", json_object_new_int(req->slave));
+    json_object_object_add(root, "function", json_object_new_int(req->function));
+    json_object_object_add(root, "address", json_object_new_int(req->address));
+    json_object_object_add(root, "count", json_object_new_int(req->count));
+    json_object_object_add(root, "ts", json_object_new_int64((int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000));
+    json_object_object_add(root, "status", json_object_new_string(status));
+    return root;
+}
+
+static void publish_json(e_device_t *device, struct json_object *root) {
+    const char *str = json_object_to_json_string_ext(root, JSON_C_TO_STRING_PLAIN);
+    e_collector_publish(device, str, strlen(str));
+    json_object_put(root);
+}
+
+/* 轮询结果以 JSON 发布到数据主题 */
+static void on_scan_data(void *arg, const e_modbus_request_t *req, e_modbus_status_t status,
+                         uint8_t exception, const uint16_t *values) {
+    e_device_t *device = (e_device_t *)arg;
+    struct json_object *root = new_block_json(device, req, e_modbus_strerror(status));
+    if (status == E_MODBUS_OK) {
+        struct json_object *array = json_object_new_array();
+        for (int i = 0; i < req->count; i++) {
+            json_object_array_add(array, json_object_new_int(values[i]));
+        }
+        json_object_object_add(root, "values", array);
+    } else if (status == E_MODBUS_EXCEPTION) {
+        json_object_object_add(root, "exception", json_object_new_int(exception));
+    }
+    publish_json(device, root);
+}
+
+/* 北向下发的 Modbus 写请求发出后在数据主题上发布写通知（status 为 "write"），供订阅者使缓存失效 */
+static void publish_write_notice(e_device_t *device, const void *payload, size_t len) {
+    const uint8_t *frame = (const uint8_t *)payload;
+    if (len < 4 || !e_crc16_modbus_check(frame, len)) return;
+
+    e_modbus_request_t req = { .slave = frame[0] };
+    if (e_modbus_parse_request(frame + 1, len - 3, &req) != 0 || e_modbus_is_read(req.function)) return;
+    publish_json(device, new_block_json(device, &req, "write"));
+}
+
+/* 北向请求的总线事务完成（总线线程）：响应转发给北向，写请求成功后发布写通知 */
+static void on_north_done(void *arg, const uint8_t *frame, size_t frame_len, e_modbus_status_t status,
+                          const uint8_t *rsp, size_t rsp_len) {
+    port_binding_t *binding = (port_binding_t *)arg;
+    e_device_t *device = binding->device;
+
+    if (rsp_len > 0) {
+        printf("[%s] Response %zu bytes (%s):\n", device->uid, rsp_len, e_modbus_strerror(status));
+        hexdump((const char *)rsp, rsp_len);
+        printf("send to north topic: %s, rc = %d\n", device->north_topic, e_collector_send(device, (const char *)rsp, rsp_len));
+    } else if (status == E_MODBUS_TIMEOUT) {
+        printf("[%s] Request timed out\n", device->uid);
+    }
+    if (status == E_MODBUS_OK) {
+        publish_write_notice(device, frame, frame_len);
+    }
+}
+
 static void on_client_recv(const char *topic, size_t topic_len, const void *payload, size_t payload_len, void *data) {
     e_device_t *device = (e_device_t *)data;
+    port_binding_t *binding = (port_binding_t *)device->arg;
     printf("[CLIENT RECEIVED] uid: %s | Topic: %.*s | Payload: \n",
            device->uid, (int)topic_len, topic);
     hexdump(payload, payload_len);
-    e_serial_manager_write(g_manager, device->uid, payload, payload_len);
-    
+    if (e_bus_submit(binding->bus, binding->north, payload, payload_len, on_north_done, binding) != 0) {
+        fprintf(stderr, "[%s] Bus queue full, request dropped\n", device->uid);
+    }
 }
 
 static void *device_listen_thread(void *arg) {
@@ -94,8 +195,25 @@ int main(int argc, char **argv) {
     while (e_queue_size(&port_queue) > 0) {
         serial_config_t *config = (serial_config_t *)e_queue_pop(&port_queue);
         e_device_t *device = e_collector_create_default(config->uid, on_client_recv);
+        port_binding_t *binding = &g_bindings[g_binding_count++];
+        binding->device = device;
+        device->arg = binding;
+        binding->bus = e_bus_create(g_manager, config);
+        binding->north = binding->bus ? e_bus_add_requester(binding->bus, "north") : -1;
+        if (binding->north < 0) {
+            fprintf(stderr, "Failed to create bus for %s\n", config->uid);
+            exit(EXIT_FAILURE);
+        }
+        binding->master = NULL;
+        if (config->scan_count > 0) {
+            binding->master = e_modbus_master_create(binding->bus, config, on_scan_data, device);
+            if (!binding->master) {
+                fprintf(stderr, "Failed to create modbus master for %s\n", config->uid);
+                exit(EXIT_FAILURE);
+            }
+        }
         
-        if (e_serial_manager_add_port(g_manager, config, recv_callback, device) != 0) {
+        if (e_serial_manager_add_port(g_manager, config, recv_callback, binding) != 0) {
             fprintf(stderr, "Failed to add serial port %s\n", config->uid);
             e_serial_manager_destroy(g_manager);
             exit(EXIT_FAILURE);
@@ -115,10 +233,33 @@ int main(int argc, char **argv) {
 
     e_serial_manager_start(g_manager);
 
+    for (int i = 0; i < g_binding_count; i++) {
+        e_bus_start(g_bindings[i].bus);
+        if (g_bindings[i].master) e_modbus_master_start(g_bindings[i].master);
+    }
+
+    // kill -USR1 <pid> 打印串口统计信息
+    signal(SIGUSR1, on_sigusr1);
+
     while (1) {
         sleep(1);
+        if (g_dump_stats) {
+            g_dump_stats = 0;
+            e_serial_manager_print_stats(g_manager);
+            for (int i = 0; i < g_binding_count; i++) {
+                e_bus_print_stats(g_bindings[i].bus);
+                e_modbus_master_print_stats(g_bindings[i].master);
+            }
+        }
     }
 
+    // 主站等待的事务在总线停止时结束，总线停止后再销毁主站
+    for (int i = 0; i < g_binding_count; i++) {
+        e_modbus_master_stop(g_bindings[i].master);
+        e_bus_stop(g_bindings[i].bus);
+        e_modbus_master_destroy(g_bindings[i].master);
+        e_bus_destroy(g_bindings[i].bus);
+    }
     e_serial_manager_stop(g_manager);
     e_serial_manager_destroy(g_manager);
     return 0;
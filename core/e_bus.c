@@ -0,0 +1,289 @@
+#include "e_bus.h"
+#include "e_crc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* 等待到 until_us，返回 ETIMEDOUT 表示已到期，调用者需持有 mutex */
+static int wait_until(e_bus_t *bus, uint64_t until_us) {
+    struct timespec ts;
+    ts.tv_sec = until_us / 1000000ULL;
+    ts.tv_nsec = (until_us % 1000000ULL) * 1000;
+    return pthread_cond_timedwait(&bus->cond, &bus->mutex, &ts);
+}
+
+/* 从上次之后的下一个请求方开始轮询，取出第一个非空队列的队首事务 */
+static e_bus_txn_t *next_txn(e_bus_t *bus, e_bus_requester_t **owner) {
+    for (int i = 0; i < bus->requester_count; i++) {
+        int k = (bus->next_requester + i) % bus->requester_count;
+        if (!e_queue_empty(&bus->requesters[k].queue)) {
+            bus->next_requester = (k + 1) % bus->requester_count;
+            *owner = &bus->requesters[k];
+            return (e_bus_txn_t *)e_queue_pop(&bus->requesters[k].queue);
+        }
+    }
+    return NULL;
+}
+
+/* 发送事务并等待其结束，返回结果，调用者需持有 mutex */
+static e_modbus_status_t run_txn(e_bus_t *bus, e_bus_txn_t *txn) {
+    bus->current = txn;
+    bus->rx_len = 0;
+    bus->result = E_MODBUS_INCOMPLETE;
+
+    uint64_t start = monotonic_us();
+    pthread_mutex_unlock(&bus->mutex);
+    int rc = e_serial_manager_write(bus->manager, bus->ser.uid, txn->frame, txn->len);
+    pthread_mutex_lock(&bus->mutex);
+    if (rc < 0) return E_MODBUS_TIMEOUT;
+
+    // 广播不应答，保持周转时间后结束；其余等待线路时间 + 从站响应超时 + 发送间隔
+    int reply = !(txn->modbus && txn->req.slave == 0);
+    size_t rsp_len = txn->modbus ? (size_t)e_modbus_response_length(&txn->req) : 0;
+    uint64_t deadline = start + serial_wire_time_us(&bus->ser, txn->len + rsp_len);
+    deadline += reply ? (uint64_t)(bus->ser.timeout_ms + bus->ser.min_delay_ms) * 1000ULL : bus->turnaround_us;
+
+    while (bus->result == E_MODBUS_INCOMPLETE && bus->running) {
+        // 非 Modbus 请求无法判断响应长度，收到数据后静默一个间隔即视为响应结束
+        uint64_t until = deadline;
+        if (!txn->modbus && bus->rx_len > 0) until = bus->last_activity_us + bus->silent_us;
+        if (monotonic_us() >= until) break;
+        wait_until(bus, until);
+    }
+
+    if (bus->result != E_MODBUS_INCOMPLETE) return bus->result;
+    if (!reply || (!txn->modbus && bus->rx_len > 0)) return E_MODBUS_OK;
+    return E_MODBUS_TIMEOUT;
+}
+
+static void *bus_thread_func(void *arg) {
+    e_bus_t *bus = (e_bus_t *)arg;
+
+    pthread_mutex_lock(&bus->mutex);
+    while (bus->running) {
+        e_bus_requester_t *owner = NULL;
+        e_bus_txn_t *txn = next_txn(bus, &owner);
+        if (!txn) {
+            pthread_cond_wait(&bus->cond, &bus->mutex);
+            continue;
+        }
+
+        // 上一次收发之后保持静默间隔，期间收到的数据会顺延等待
+        while (bus->running) {
+            uint64_t ready = bus->last_activity_us + bus->silent_us;
+            if (monotonic_us() >= ready) break;
+            wait_until(bus, ready);
+        }
+        if (!bus->running) {
+            free(txn);
+            break;
+        }
+
+        uint64_t start = monotonic_us();
+        if (start - txn->enqueue_us > owner->wait_max_us) owner->wait_max_us = start - txn->enqueue_us;
+
+        e_modbus_status_t status = run_txn(bus, txn);
+        uint64_t end = monotonic_us();
+        bus->current = NULL;
+        bus->last_activity_us = end;
+        bus->stats.transactions++;
+        bus->stats.busy_us += end - start;
+        owner->transactions++;
+        switch (status) {
+            case E_MODBUS_OK:
+            case E_MODBUS_EXCEPTION:
+                if (bus->rx_len > 0) bus->stats.responses++;
+                break;
+            case E_MODBUS_TIMEOUT:
+                bus->stats.timeouts++;
+                break;
+            default:
+                bus->stats.errors++;
+                break;
+        }
+        size_t rx_len = bus->rx_len;
+        pthread_mutex_unlock(&bus->mutex);
+
+        // current 已清空，回调期间 e_bus_feed 不会修改 rx
+        if (txn->cb) txn->cb(txn->arg, txn->frame, txn->len, status, bus->rx, rx_len);
+        free(txn);
+
+        pthread_mutex_lock(&bus->mutex);
+    }
+    pthread_mutex_unlock(&bus->mutex);
+    return NULL;
+}
+
+e_bus_t *e_bus_create(serial_manager_t *manager, const serial_config_t *config) {
+    if (!manager || !config || !config->uid) return NULL;
+
+    e_bus_t *bus = calloc(1, sizeof(e_bus_t));
+    if (!bus) {
+        perror("Failed to allocate bus");
+        return NULL;
+    }
+
+    bus->manager = manager;
+    bus->ser = *config;
+    bus->ser.uid = strdup(config->uid);
+    bus->ser.device = NULL;
+    bus->ser.scan = NULL;
+    bus->ser.scan_count = 0;
+    bus->silent_us = config->silent_us > 0 ? (uint64_t)config->silent_us : serial_frame_gap_us(config);
+    bus->turnaround_us = (uint64_t)config->turnaround_ms * 1000ULL;
+    bus->rx_cap = config->maxlen > MODBUS_RTU_MAX_ADU ? (size_t)config->maxlen : MODBUS_RTU_MAX_ADU;
+    bus->rx = malloc(bus->rx_cap);
+    if (!bus->ser.uid || !bus->rx) {
+        free(bus->ser.uid);
+        free(bus->rx);
+        free(bus);
+        return NULL;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&bus->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&bus->mutex, NULL);
+    return bus;
+}
+
+int e_bus_add_requester(e_bus_t *bus, const char *name) {
+    if (!bus || bus->running || bus->requester_count >= E_BUS_MAX_REQUESTERS) return -1;
+
+    e_bus_requester_t *r = &bus->requesters[bus->requester_count];
+    r->name = strdup(name ? name : "?");
+    if (!r->name) return -1;
+    e_queue_init(&r->queue, 0);
+    return bus->requester_count++;
+}
+
+int e_bus_start(e_bus_t *bus) {
+    if (!bus || bus->running) return -1;
+
+    bus->running = 1;
+    if (pthread_create(&bus->tid, NULL, bus_thread_func, bus) != 0) {
+        perror("Failed to create bus thread");
+        bus->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void e_bus_stop(e_bus_t *bus) {
+    if (!bus || !bus->running) return;
+
+    pthread_mutex_lock(&bus->mutex);
+    bus->running = 0;
+    pthread_cond_broadcast(&bus->cond);
+    pthread_mutex_unlock(&bus->mutex);
+    pthread_join(bus->tid, NULL);
+}
+
+void e_bus_destroy(e_bus_t *bus) {
+    if (!bus) return;
+
+    e_bus_stop(bus);
+    for (int i = 0; i < bus->requester_count; i++) {
+        e_queue_destroy(&bus->requesters[i].queue);
+        free(bus->requesters[i].name);
+    }
+    pthread_mutex_destroy(&bus->mutex);
+    pthread_cond_destroy(&bus->cond);
+    free(bus->ser.uid);
+    free(bus->rx);
+    free(bus);
+}
+
+int e_bus_submit(e_bus_t *bus, int requester, const void *data, size_t len, e_bus_done_cb cb, void *arg) {
+    if (!bus || !data || len == 0 || requester < 0 || requester >= bus->requester_count) return -1;
+
+    e_bus_txn_t *txn = malloc(sizeof(e_bus_txn_t) + len);
+    if (!txn) return -1;
+    txn->cb = cb;
+    txn->arg = arg;
+    txn->enqueue_us = monotonic_us();
+    txn->len = len;
+    memcpy(txn->frame, data, len);
+
+    // CRC 正确且能解析出请求的按 Modbus 事务处理
+    txn->modbus = 0;
+    memset(&txn->req, 0, sizeof(txn->req));
+    if (len >= 4 && e_crc16_modbus_check(txn->frame, len)) {
+        txn->req.slave = txn->frame[0];
+        txn->modbus = e_modbus_parse_request(txn->frame + 1, len - 3, &txn->req) == 0;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    e_bus_requester_t *r = &bus->requesters[requester];
+    if (e_queue_size(&r->queue) >= E_BUS_QUEUE_MAX) {
+        r->dropped++;
+        pthread_mutex_unlock(&bus->mutex);
+        free(txn);
+        return -1;
+    }
+    e_queue_push(&r->queue, txn);
+    pthread_cond_broadcast(&bus->cond);
+    pthread_mutex_unlock(&bus->mutex);
+    return 0;
+}
+
+size_t e_bus_feed(e_bus_t *bus, const char *data, size_t len) {
+    if (!bus || !data) return 0;
+
+    pthread_mutex_lock(&bus->mutex);
+    bus->last_activity_us = monotonic_us();
+
+    e_bus_txn_t *txn = bus->current;
+    if (!txn || bus->result != E_MODBUS_INCOMPLETE || (txn->modbus && txn->req.slave == 0)) {
+        bus->stats.unsolicited++;
+        pthread_cond_broadcast(&bus->cond);
+        pthread_mutex_unlock(&bus->mutex);
+        return 0;
+    }
+
+    size_t room = bus->rx_cap - bus->rx_len;
+    if (len > room) len = room;
+    memcpy(bus->rx + bus->rx_len, data, len);
+    bus->rx_len += len;
+
+    if (txn->modbus) {
+        uint8_t exception;
+        e_modbus_status_t status = e_modbus_parse_response(&txn->req, bus->rx, bus->rx_len, NULL, &exception);
+        if (status == E_MODBUS_INCOMPLETE && bus->rx_len == bus->rx_cap) status = E_MODBUS_MISMATCH;
+        if (status != E_MODBUS_INCOMPLETE) bus->result = status;
+    } else if (bus->rx_len == bus->rx_cap) {
+        // 原始响应填满缓冲即结束事务，其余数据由调用者按原始数据转发
+        bus->result = E_MODBUS_OK;
+    }
+    pthread_cond_broadcast(&bus->cond);
+    pthread_mutex_unlock(&bus->mutex);
+    return len;
+}
+
+void e_bus_print_stats(e_bus_t *bus) {
+    if (!bus) return;
+
+    pthread_mutex_lock(&bus->mutex);
+    e_bus_stats_t s = bus->stats;
+    printf("[%s] bus: txn %llu rsp %llu timeout %llu err %llu unsolicited %llu, busy %llu ms, silent %llu us\n",
+           bus->ser.uid, (unsigned long long)s.transactions, (unsigned long long)s.responses,
+           (unsigned long long)s.timeouts, (unsigned long long)s.errors, (unsigned long long)s.unsolicited,
+           (unsigned long long)(s.busy_us / 1000), (unsigned long long)bus->silent_us);
+    for (int i = 0; i < bus->requester_count; i++) {
+        e_bus_requester_t *r = &bus->requesters[i];
+        printf("[%s]   %-8s: txn %llu dropped %llu queued %d, wait max %llu us\n",
+               bus->ser.uid, r->name, (unsigned long long)r->transactions, (unsigned long long)r->dropped,
+               e_queue_size(&r->queue), (unsigned long long)r->wait_max_us);
+    }
+    pthread_mutex_unlock(&bus->mutex);
+}
@@ -0,0 +1,143 @@
+#ifndef E_BUS_H
+#define E_BUS_H
+
+#include "e_modbus.h"
+#include "e_queue.h"
+#include "e_serial_manager.h"
+#include <pthread.h>
+#include <stdint.h>
+
+#define E_BUS_MAX_REQUESTERS    8       // 每条总线的最大请求方数
+#define E_BUS_QUEUE_MAX         64      // 每个请求方排队的最大事务数
+
+/**
+ * @brief 事务完成回调，在总线线程中调用
+ * @param arg 用户数据
+ * @param frame 发送的请求帧
+ * @param frame_len 请求帧长度
+ * @param status E_MODBUS_OK 收到响应；E_MODBUS_TIMEOUT 超时（不需要响应的请求在静默时间结束后也为 OK）；
+ *               Modbus 请求另有 EXCEPTION/BAD_CRC/MISMATCH
+ * @param rsp 响应数据
+ * @param rsp_len 响应长度
+ */
+typedef void (*e_bus_done_cb)(void *arg, const uint8_t *frame, size_t frame_len, e_modbus_status_t status,
+                              const uint8_t *rsp, size_t rsp_len);
+
+/* 一次总线事务 */
+typedef struct {
+    e_bus_done_cb cb;
+    void *arg;
+    uint64_t enqueue_us;            // 入队时间
+    int modbus;                     // 1 表示可解析的 Modbus RTU 请求，按期望长度判断响应完整
+    e_modbus_request_t req;         // modbus 为 1 时有效
+    size_t len;
+    uint8_t frame[];
+} e_bus_txn_t;
+
+/* 请求方 */
+typedef struct {
+    char *name;
+    e_queue_t queue;                // 排队中的事务（e_bus_txn_t*）
+    uint64_t transactions;          // 已完成事务数
+    uint64_t dropped;               // 队列满被拒绝的事务数
+    uint64_t wait_max_us;           // 入队到占用总线的最大等待时间
+} e_bus_requester_t;
+
+/* 总线统计 */
+typedef struct {
+    uint64_t transactions;          // 已完成事务数
+    uint64_t responses;             // 收到响应的事务数
+    uint64_t timeouts;              // 超时数
+    uint64_t errors;                // CRC/不匹配/发送失败数
+    uint64_t unsolicited;           // 总线空闲时收到的数据次数
+    uint64_t busy_us;               // 累计占用总线时间
+} e_bus_stats_t;
+
+/**
+ * @brief 半双工总线事务层：一个串口上同一时刻只有一个事务，请求占用总线直到响应完整或超时；
+ * 事务之间保持静默间隔，各请求方之间轮询调度
+ */
+typedef struct {
+    serial_manager_t *manager;      // 所属串口管理器
+    serial_config_t ser;            // 串口参数（uid 为拷贝）
+    uint64_t silent_us;             // 事务之间的最小静默间隔
+    uint64_t turnaround_us;         // 不需要响应的请求（广播）发出后的总线保持时间
+    e_bus_requester_t requesters[E_BUS_MAX_REQUESTERS];
+    int requester_count;
+    int next_requester;             // 轮询起点
+    pthread_t tid;                  // 总线线程
+    volatile int running;
+    pthread_mutex_t mutex;          // 保护以下所有字段
+    pthread_cond_t cond;            // 新事务/响应到达/停止通知（CLOCK_MONOTONIC）
+    e_bus_txn_t *current;           // 正在占用总线的事务
+    uint8_t *rx;                    // 响应缓冲
+    size_t rx_cap;
+    size_t rx_len;
+    e_modbus_status_t result;       // 当前事务结果，INCOMPLETE 表示等待中
+    uint64_t last_activity_us;      // 最近一次收发数据的时间，用于静默间隔
+    e_bus_stats_t stats;
+} e_bus_t;
+
+/**
+ * @brief 创建总线
+ * @param manager 串口管理器
+ * @param config 串口配置（使用其中的 uid、串口参数、超时、静默间隔与周转时间）
+ * @return 总线句柄，失败返回NULL
+ */
+e_bus_t *e_bus_create(serial_manager_t *manager, const serial_config_t *config);
+
+/**
+ * @brief 注册请求方，须在 e_bus_start 之前调用
+ * @param bus 总线句柄
+ * @param name 名称（用于统计输出）
+ * @return 请求方编号，-1失败
+ */
+int e_bus_add_requester(e_bus_t *bus, const char *name);
+
+/**
+ * @brief 启动总线线程
+ * @param bus 总线句柄
+ * @return 0成功，-1失败
+ */
+int e_bus_start(e_bus_t *bus);
+
+/**
+ * @brief 停止总线线程，未执行的事务丢弃且不回调
+ * @param bus 总线句柄
+ */
+void e_bus_stop(e_bus_t *bus);
+
+/**
+ * @brief 销毁总线
+ * @param bus 总线句柄
+ */
+void e_bus_destroy(e_bus_t *bus);
+
+/**
+ * @brief 提交事务，立即返回，完成后调用 cb
+ * @param bus 总线句柄
+ * @param requester 请求方编号
+ * @param data 请求帧
+ * @param len 请求帧长度
+ * @param cb 完成回调，可为 NULL
+ * @param arg 回调用户数据
+ * @return 0成功，-1失败（请求方不存在或队列已满）
+ */
+int e_bus_submit(e_bus_t *bus, int requester, const void *data, size_t len, e_bus_done_cb cb, void *arg);
+
+/**
+ * @brief 输入串口接收到的数据，在串口接收回调中调用
+ * @param bus 总线句柄
+ * @param data 数据
+ * @param len 数据长度
+ * @return 属于当前事务已被消费的字节数，其余数据（总线空闲或响应已结束）应按原始数据处理
+ */
+size_t e_bus_feed(e_bus_t *bus, const char *data, size_t len);
+
+/**
+ * @brief 打印总线统计信息
+ * @param bus 总线句柄
+ */
+void e_bus_print_stats(e_bus_t *bus);
+
+#endif // E_BUS_H
@@ -0,0 +1,459 @@
+#include "e_codec.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_SSSE3 1
+#include <immintrin.h>
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define CODEC_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* 字节重排：每组 width 字节，组内第 k 个输出字节取自输入的第 order[k] 个，order 按 16 字节展开 */
+typedef struct {
+    size_t width;
+    uint8_t order[16];
+} permute_t;
+
+static const permute_t perm_swap16 = { 2, { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 } };
+static const permute_t perm_swap32 = { 4, { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 } };
+static const permute_t perm_words = { 4, { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 } };
+
+static const char hex_digits[16] = "0123456789abcdef";
+static const char b64_alphabet[64] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const uint8_t bit_masks[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+
+#if CODEC_SSSE3
+static int g_ssse3;
+static pthread_once_t g_codec_once = PTHREAD_ONCE_INIT;
+
+static void codec_init(void) {
+    __builtin_cpu_init();
+    g_ssse3 = __builtin_cpu_supports("ssse3");
+}
+
+static int has_ssse3(void) {
+    pthread_once(&g_codec_once, codec_init);
+    return g_ssse3;
+}
+#endif
+
+const char *e_codec_simd(void) {
+#if CODEC_SSSE3
+    return has_ssse3() ? "ssse3" : "scalar";
+#elif CODEC_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+int e_codec_type_parse(const char *name, e_codec_type_t *type) {
+    static const char *const names[] = { "u16", "i16", "u32", "i32", "f32" };
+    if (!name || !type) return -1;
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *type = (e_codec_type_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+size_t e_codec_type_width(e_codec_type_t type) {
+    return (type == E_CODEC_U16 || type == E_CODEC_I16) ? 2 : 4;
+}
+
+/* ---------------- 逐元素实现，同时处理向量实现剩下的尾部 ---------------- */
+
+static void permute_scalar(uint8_t *dst, const uint8_t *src, size_t len, const permute_t *perm) {
+    size_t i = 0;
+    for (; i + perm->width <= len; i += perm->width) {
+        uint8_t group[4];
+        memcpy(group, src + i, perm->width);
+        for (size_t k = 0; k < perm->width; k++) dst[i + k] = group[perm->order[k]];
+    }
+    if (i < len && dst != src) memcpy(dst + i, src + i, len - i);
+}
+
+static float load_value(const uint8_t *p, e_codec_type_t type) {
+    uint32_t v;
+    float f;
+    switch (type) {
+        case E_CODEC_U16:
+            return (float)(uint16_t)((p[0] << 8) | p[1]);
+        case E_CODEC_I16:
+            return (float)(int16_t)((p[0] << 8) | p[1]);
+        default:
+            v = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+            if (type == E_CODEC_U32) return (float)v;
+            if (type == E_CODEC_I32) return (float)(int32_t)v;
+            memcpy(&f, &v, sizeof(f));
+            return f;
+    }
+}
+
+static void scale_scalar(float *dst, const uint8_t *src, size_t count, e_codec_type_t type, float scale,
+                         float offset) {
+    size_t width = e_codec_type_width(type);
+    for (size_t i = 0; i < count; i++) dst[i] = load_value(src + i * width, type) * scale + offset;
+}
+
+static void bits_scalar(uint8_t *dst, const uint8_t *src, size_t start, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        size_t bit = start + k;
+        dst[k] = (src[bit >> 3] >> (bit & 7)) & 1;
+    }
+}
+
+static void hex_scalar(char *dst, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i * 2] = hex_digits[src[i] >> 4];
+        dst[i * 2 + 1] = hex_digits[src[i] & 0x0F];
+    }
+}
+
+static void base64_scalar(char *dst, const uint8_t *src, size_t len) {
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3, dst += 4) {
+        uint32_t v = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        dst[0] = b64_alphabet[v >> 18];
+        dst[1] = b64_alphabet[(v >> 12) & 0x3F];
+        dst[2] = b64_alphabet[(v >> 6) & 0x3F];
+        dst[3] = b64_alphabet[v & 0x3F];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)src[i + 1] << 8;
+        dst[0] = b64_alphabet[v >> 18];
+        dst[1] = b64_alphabet[(v >> 12) & 0x3F];
+        dst[2] = i + 1 < len ? b64_alphabet[(v >> 6) & 0x3F] : '=';
+        dst[3] = '=';
+    }
+}
+
+/* ---------------- SSSE3，每轮 16 字节，返回已处理的长度 ---------------- */
+
+#if CODEC_SSSE3
+TARGET_SSSE3 static size_t permute_ssse3(uint8_t *dst, const uint8_t *src, size_t len, const permute_t *perm) {
+    const __m128i order = _mm_loadu_si128((const __m128i *)perm->order);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, order));
+    }
+    return i;
+}
+
+TARGET_SSSE3 static size_t scale_ssse3(float *dst, const uint8_t *src, size_t count, e_codec_type_t type,
+                                       float scale, float offset) {
+    const __m128i rev16 = _mm_loadu_si128((const __m128i *)perm_swap16.order);
+    const __m128i rev32 = _mm_loadu_si128((const __m128i *)perm_swap32.order);
+    const __m128 k = _mm_set1_ps(scale);
+    const __m128 b = _mm_set1_ps(offset);
+    size_t i = 0;
+
+    if (type == E_CODEC_U16 || type == E_CODEC_I16) {
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i * 2)), rev16);
+            __m128i lo, hi;
+            if (type == E_CODEC_I16) {
+                lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            } else {
+                lo = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+                hi = _mm_unpackhi_epi16(v, _mm_setzero_si128());
+            }
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), k), b));
+            _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), k), b));
+        }
+        return i;
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i * 4)), rev32);
+        __m128 f;
+        if (type == E_CODEC_I32) {
+            f = _mm_cvtepi32_ps(v);
+        } else if (type == E_CODEC_F32) {
+            f = _mm_castsi128_ps(v);
+        } else {
+            // 无符号转换拆成高低 16 位，高位乘 65536 是精确的，只在相加时舍入一次
+            __m128 h = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+            __m128 l = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xFFFF)));
+            f = _mm_add_ps(_mm_mul_ps(h, _mm_set1_ps(65536.0f)), l);
+        }
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(f, k), b));
+    }
+    return i;
+}
+
+/* src 按字节对齐，每 2 字节展开为 16 个输出 */
+TARGET_SSSE3 static size_t bits_ssse3(uint8_t *dst, const uint8_t *src, size_t count) {
+    const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m128i mask = _mm_loadu_si128((const __m128i *)bit_masks);
+    const __m128i one = _mm_set1_epi8(1);
+    size_t k = 0;
+    for (; k + 16 <= count; k += 16) {
+        __m128i v = _mm_cvtsi32_si128(src[k >> 3] | (src[(k >> 3) + 1] << 8));
+        v = _mm_and_si128(_mm_shuffle_epi8(v, spread), mask);
+        _mm_storeu_si128((__m128i *)(dst + k), _mm_and_si128(_mm_cmpeq_epi8(v, mask), one));
+    }
+    return k;
+}
+
+TARGET_SSSE3 static size_t hex_ssse3(char *dst, const uint8_t *src, size_t len) {
+    const __m128i digits = _mm_loadu_si128((const __m128i *)hex_digits);
+    const __m128i low = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), low));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, low));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+/* 每轮读取 16 字节、编码其中 12 字节为 16 个字符（W. Muła 的 pshufb 查表法） */
+TARGET_SSSE3 static size_t base64_ssse3(char *dst, const uint8_t *src, size_t len) {
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                            '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 12, dst += 16) {
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), shuffle);
+
+        // 每 32 位拆出 4 个 6 位索引，分别放在 4 个字节中
+        __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        __m128i idx = _mm_or_si128(t0, t1);
+
+        // 按索引所在区间取得到 ASCII 的偏移
+        __m128i range = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        _mm_storeu_si128((__m128i *)dst, _mm_add_epi8(_mm_shuffle_epi8(shift_lut, range), idx));
+    }
+    return i;
+}
+#endif
+
+/* ---------------- NEON ---------------- */
+
+#if CODEC_NEON
+static size_t permute_neon(uint8_t *dst, const uint8_t *src, size_t len, const permute_t *perm) {
+    size_t i = 0;
+    if (perm == &perm_swap16) {
+        for (; i + 16 <= len; i += 16) vst1q_u8(dst + i, vrev16q_u8(vld1q_u8(src + i)));
+    } else if (perm == &perm_swap32) {
+        for (; i + 16 <= len; i += 16) vst1q_u8(dst + i, vrev32q_u8(vld1q_u8(src + i)));
+    } else {
+        for (; i + 16 <= len; i += 16) {
+            uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i));
+            vst1q_u8(dst + i, vreinterpretq_u8_u16(vrev32q_u16(v)));
+        }
+    }
+    return i;
+}
+
+static size_t scale_neon(float *dst, const uint8_t *src, size_t count, e_codec_type_t type, float scale,
+                         float offset) {
+    const float32x4_t k = vdupq_n_f32(scale);
+    const float32x4_t b = vdupq_n_f32(offset);
+    size_t i = 0;
+
+    if (type == E_CODEC_U16 || type == E_CODEC_I16) {
+        for (; i + 8 <= count; i += 8) {
+            uint8x16_t v = vrev16q_u8(vld1q_u8(src + i * 2));
+            float32x4_t lo, hi;
+            if (type == E_CODEC_I16) {
+                int16x8_t s = vreinterpretq_s16_u8(v);
+                lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+                hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+            } else {
+                uint16x8_t u = vreinterpretq_u16_u8(v);
+                lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(u)));
+                hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(u)));
+            }
+            vst1q_f32(dst + i, vaddq_f32(vmulq_f32(lo, k), b));
+            vst1q_f32(dst + i + 4, vaddq_f32(vmulq_f32(hi, k), b));
+        }
+        return i;
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t v = vrev32q_u8(vld1q_u8(src + i * 4));
+        float32x4_t f;
+        if (type == E_CODEC_I32) {
+            f = vcvtq_f32_s32(vreinterpretq_s32_u8(v));
+        } else if (type == E_CODEC_F32) {
+            f = vreinterpretq_f32_u8(v);
+        } else {
+            f = vcvtq_f32_u32(vreinterpretq_u32_u8(v));
+        }
+        vst1q_f32(dst + i, vaddq_f32(vmulq_f32(f, k), b));
+    }
+    return i;
+}
+
+static size_t bits_neon(uint8_t *dst, const uint8_t *src, size_t count) {
+    const uint8x16_t mask = vld1q_u8(bit_masks);
+    const uint8x16_t one = vdupq_n_u8(1);
+    size_t k = 0;
+    for (; k + 16 <= count; k += 16) {
+        uint8x16_t v = vcombine_u8(vdup_n_u8(src[k >> 3]), vdup_n_u8(src[(k >> 3) + 1]));
+        vst1q_u8(dst + k, vandq_u8(vtstq_u8(v, mask), one));
+    }
+    return k;
+}
+
+#if defined(__aarch64__)
+static size_t hex_neon(char *dst, const uint8_t *src, size_t len) {
+    const uint8x16_t digits = vld1q_u8((const uint8_t *)hex_digits);
+    const uint8x16_t low = vdupq_n_u8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint8x16x2_t out;
+        out.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(v, 4));
+        out.val[1] = vqtbl1q_u8(digits, vandq_u8(v, low));
+        vst2q_u8((uint8_t *)dst + i * 2, out);
+    }
+    return i;
+}
+#endif
+#endif
+
+/* ---------------- 对外接口 ---------------- */
+
+static void permute(uint8_t *dst, const uint8_t *src, size_t len, const permute_t *perm) {
+    size_t done = 0;
+#if CODEC_SSSE3
+    if (has_ssse3()) done = permute_ssse3(dst, src, len, perm);
+#elif CODEC_NEON
+    done = permute_neon(dst, src, len, perm);
+#endif
+    permute_scalar(dst + done, src + done, len - done, perm);
+}
+
+void e_codec_swap16(uint8_t *dst, const uint8_t *src, size_t len) {
+    permute(dst, src, len, &perm_swap16);
+}
+
+void e_codec_swap32(uint8_t *dst, const uint8_t *src, size_t len) {
+    permute(dst, src, len, &perm_swap32);
+}
+
+void e_codec_swap_words(uint8_t *dst, const uint8_t *src, size_t len) {
+    permute(dst, src, len, &perm_words);
+}
+
+void e_codec_scale(float *dst, const uint8_t *src, size_t count, e_codec_type_t type, float scale, float offset) {
+    size_t done = 0;
+#if CODEC_SSSE3
+    if (has_ssse3()) done = scale_ssse3(dst, src, count, type, scale, offset);
+#elif CODEC_NEON
+    done = scale_neon(dst, src, count, type, scale, offset);
+#endif
+    scale_scalar(dst + done, src + done * e_codec_type_width(type), count - done, type, scale, offset);
+}
+
+void e_codec_bits(uint8_t *dst, const uint8_t *src, size_t start, size_t count) {
+    // 先逐位处理到字节边界，之后按字节展开
+    size_t head = (8 - (start & 7)) & 7;
+    if (head > count) head = count;
+    bits_scalar(dst, src, start, head);
+    dst += head;
+    src += (start + head) >> 3;
+    count -= head;
+
+    size_t done = 0;
+#if CODEC_SSSE3
+    if (has_ssse3()) done = bits_ssse3(dst, src, count);
+#elif CODEC_NEON
+    done = bits_neon(dst, src, count);
+#endif
+    bits_scalar(dst + done, src, done, count - done);
+}
+
+size_t e_codec_hex_encode(char *dst, const uint8_t *src, size_t len) {
+    size_t done = 0;
+#if CODEC_SSSE3
+    if (has_ssse3()) done = hex_ssse3(dst, src, len);
+#elif CODEC_NEON && defined(__aarch64__)
+    done = hex_neon(dst, src, len);
+#endif
+    hex_scalar(dst + done * 2, src + done, len - done);
+    return E_CODEC_HEX_LEN(len);
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+long e_codec_hex_decode(uint8_t *dst, const char *src, size_t len) {
+    if (len % 2) return -1;
+
+    for (size_t i = 0; i < len; i += 2) {
+        int hi = hex_value(src[i]);
+        int lo = hex_value(src[i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        dst[i / 2] = (uint8_t)((hi << 4) | lo);
+    }
+    return (long)(len / 2);
+}
+
+size_t e_codec_base64_encode(char *dst, const uint8_t *src, size_t len) {
+    size_t done = 0;
+#if CODEC_SSSE3
+    if (has_ssse3()) done = base64_ssse3(dst, src, len);
+#endif
+    base64_scalar(dst + done / 3 * 4, src + done, len - done);
+    return E_CODEC_BASE64_LEN(len);
+}
+
+static int b64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+long e_codec_base64_decode(uint8_t *dst, const char *src, size_t len) {
+    if (len > 0 && src[len - 1] == '=') len--;
+    if (len > 0 && src[len - 1] == '=') len--;
+    if (len % 4 == 1) return -1;
+
+    size_t out = 0;
+    uint32_t acc = 0;
+    for (size_t i = 0; i < len; i++) {
+        int v = b64_value(src[i]);
+        if (v < 0) return -1;
+        acc = (acc << 6) | (uint32_t)v;
+        if (i % 4 == 3) {
+            dst[out++] = (uint8_t)(acc >> 16);
+            dst[out++] = (uint8_t)(acc >> 8);
+            dst[out++] = (uint8_t)acc;
+            acc = 0;
+        }
+    }
+    // 末尾 2 或 3 个字符分别对应 1 或 2 字节
+    if (len % 4 == 2) {
+        dst[out++] = (uint8_t)(acc >> 4);
+    } else if (len % 4 == 3) {
+        dst[out++] = (uint8_t)(acc >> 10);
+        dst[out++] = (uint8_t)(acc >> 2);
+    }
+    return (long)out;
+}
@@ -0,0 +1,126 @@
+#ifndef E_CODEC_H
+#define E_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 常用的寄存器数据编解码：字节序交换、整数到浮点的线性换算、位展开、hex/base64。
+ * 寄存器数据按 Modbus 约定为大端序。x86 在运行时检测到 SSSE3 时使用向量实现，
+ * ARM 在编译时启用 NEON 时使用向量实现，否则逐元素处理。
+ * 字节序交换与 32 位类型的换算可以原地进行（dst 与 src 相同）。
+ */
+
+#define E_CODEC_HEX_LEN(n)      ((n) * 2)
+#define E_CODEC_BASE64_LEN(n)   (((n) + 2) / 3 * 4)
+
+/* 换算的输入类型（大端序） */
+typedef enum {
+    E_CODEC_U16,
+    E_CODEC_I16,
+    E_CODEC_U32,
+    E_CODEC_I32,
+    E_CODEC_F32,
+} e_codec_type_t;
+
+/**
+ * @brief 当前使用的向量实现
+ * @return "ssse3"、"neon" 或 "scalar"
+ */
+const char *e_codec_simd(void);
+
+/**
+ * @brief 按名称取得换算类型
+ * @param name "u16"/"i16"/"u32"/"i32"/"f32"
+ * @param type 输出类型
+ * @return 0成功，-1未知名称
+ */
+int e_codec_type_parse(const char *name, e_codec_type_t *type);
+
+/**
+ * @brief 换算类型的字节宽度
+ */
+size_t e_codec_type_width(e_codec_type_t type);
+
+/**
+ * @brief 每 2 字节交换（AB → BA），不足 2 字节的尾部原样拷贝
+ * @param dst 输出，长度 len
+ * @param src 输入
+ * @param len 数据长度
+ */
+void e_codec_swap16(uint8_t *dst, const uint8_t *src, size_t len);
+
+/**
+ * @brief 每 4 字节逆序（ABCD → DCBA），不足 4 字节的尾部原样拷贝
+ */
+void e_codec_swap32(uint8_t *dst, const uint8_t *src, size_t len);
+
+/**
+ * @brief 每 4 字节交换前后两个寄存器（ABCD → CDAB），用于低字在前的 32 位数据
+ */
+void e_codec_swap_words(uint8_t *dst, const uint8_t *src, size_t len);
+
+/**
+ * @brief 大端寄存器数据换算为浮点：dst[i] = value[i] * scale + offset
+ * @param dst 输出，count 个 float（dst 与 src 相同时类型宽度须为 4）
+ * @param src 输入，count * e_codec_type_width(type) 字节
+ * @param count 数值个数
+ * @param type 输入类型
+ * @param scale 系数
+ * @param offset 偏移
+ */
+void e_codec_scale(float *dst, const uint8_t *src, size_t count, e_codec_type_t type, float scale, float offset);
+
+/**
+ * @brief 位展开：按线圈响应的顺序（每字节低位在前）把 count 个位展开为 0/1 字节
+ * @param dst 输出，count 字节
+ * @param src 输入
+ * @param start 起始位序号（从 0 开始）
+ * @param count 位数，调用者保证 start + count 不超过 src 的位数
+ */
+void e_codec_bits(uint8_t *dst, const uint8_t *src, size_t start, size_t count);
+
+/**
+ * @brief 编码为小写 hex
+ * @param dst 输出，E_CODEC_HEX_LEN(len) 字节，不含结尾 0
+ * @param src 输入
+ * @param len 输入长度
+ * @return 输出长度
+ */
+size_t e_codec_hex_encode(char *dst, const uint8_t *src, size_t len);
+
+/**
+ * @brief hex 解码，大小写均可
+ * @param dst 输出，len / 2 字节
+ * @param src 输入
+ * @param len 输入长度
+ * @return 输出长度，-1 长度为奇数或含非 hex 字符
+ */
+long e_codec_hex_decode(uint8_t *dst, const char *src, size_t len);
+
+/**
+ * @brief 标准 base64 编码（带 = 填充）
+ * @param dst 输出，E_CODEC_BASE64_LEN(len) 字节，不含结尾 0
+ * @param src 输入
+ * @param len 输入长度
+ * @return 输出长度
+ */
+size_t e_codec_base64_encode(char *dst, const uint8_t *src, size_t len);
+
+/**
+ * @brief 标准 base64 解码，末尾填充可省略
+ * @param dst 输出，至少 len / 4 * 3 + 2 字节
+ * @param src 输入
+ * @param len 输入长度
+ * @return 输出长度，-1 含非法字符或长度不合法
+ */
+long e_codec_base64_decode(uint8_t *dst, const char *src, size_t len);
+
+struct lua_State;
+
+/**
+ * @brief lua 模块入口（require "ezmb.codec"），插件脚本中已预置，无需安装
+ */
+int luaopen_ezmb_codec(struct lua_State *L);
+
+#endif // E_CODEC_H
@@ -0,0 +1,191 @@
+#include "e_codec.h"
+#include <lua.h>
+#include <lauxlib.h>
+#include <string.h>
+
+#if !defined(LUA_VERSION_NUM) || LUA_VERSION_NUM < 502
+#define luaL_newlib(L, l) (lua_newtable(L), luaL_register(L, NULL, l))
+#endif
+
+/* 临时输出缓冲，由 lua 回收 */
+static void *scratch(lua_State *L, size_t size) {
+    return lua_newuserdata(L, size > 0 ? size : 1);
+}
+
+static e_codec_type_t check_type(lua_State *L, int arg) {
+    e_codec_type_t type;
+    const char *name = luaL_checkstring(L, arg);
+    if (e_codec_type_parse(name, &type) != 0) luaL_argerror(L, arg, "expected u16/i16/u32/i32/f32");
+    return type;
+}
+
+static int permute(lua_State *L, void (*fn)(uint8_t *, const uint8_t *, size_t)) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    uint8_t *out = scratch(L, len);
+    fn(out, (const uint8_t *)s, len);
+    lua_pushlstring(L, (const char *)out, len);
+    return 1;
+}
+
+/* codec.swap16(s) */
+static int l_swap16(lua_State *L) {
+    return permute(L, e_codec_swap16);
+}
+
+/* codec.swap32(s) */
+static int l_swap32(lua_State *L) {
+    return permute(L, e_codec_swap32);
+}
+
+/* codec.swap_words(s) */
+static int l_swap_words(lua_State *L) {
+    return permute(L, e_codec_swap_words);
+}
+
+/* codec.scale(s, type [, scale [, offset]]) -> { v1, v2, ... } */
+static int l_scale(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    e_codec_type_t type = check_type(L, 2);
+    float k = (float)luaL_optnumber(L, 3, 1.0);
+    float b = (float)luaL_optnumber(L, 4, 0.0);
+
+    size_t count = len / e_codec_type_width(type);
+    float *values = scratch(L, count * sizeof(float));
+    e_codec_scale(values, (const uint8_t *)s, count, type, k, b);
+
+    lua_createtable(L, (int)count, 0);
+    for (size_t i = 0; i < count; i++) {
+        lua_pushnumber(L, values[i]);
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+    return 1;
+}
+
+/* codec.read(s, type [, pos]) -> 第 pos 字节起的一个大端数值，越界返回 nil */
+static int l_read(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    e_codec_type_t type = check_type(L, 2);
+    lua_Integer pos = luaL_optinteger(L, 3, 1);
+
+    size_t width = e_codec_type_width(type);
+    if (pos < 1 || (size_t)pos - 1 + width > len) {
+        lua_pushnil(L);
+        return 1;
+    }
+    // 单个数值直接按 double 返回，32 位整数不经过 float 损失精度
+    const uint8_t *p = (const uint8_t *)s + pos - 1;
+    uint32_t v = width == 2 ? (uint32_t)((p[0] << 8) | p[1])
+                            : ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    float f;
+    switch (type) {
+        case E_CODEC_I16:
+            lua_pushnumber(L, (int16_t)v);
+            break;
+        case E_CODEC_I32:
+            lua_pushnumber(L, (int32_t)v);
+            break;
+        case E_CODEC_F32:
+            memcpy(&f, &v, sizeof(f));
+            lua_pushnumber(L, f);
+            break;
+        default:
+            lua_pushnumber(L, v);
+            break;
+    }
+    return 1;
+}
+
+/* codec.bits(s [, start [, count]]) -> { 0/1, ... }，start 为从 0 开始的位序号 */
+static int l_bits(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    lua_Integer start = luaL_optinteger(L, 2, 0);
+    size_t total = len * 8;
+    luaL_argcheck(L, start >= 0 && (size_t)start <= total, 2, "out of range");
+    lua_Integer count = luaL_optinteger(L, 3, (lua_Integer)(total - (size_t)start));
+    luaL_argcheck(L, count >= 0 && (size_t)count <= total - (size_t)start, 3, "out of range");
+
+    uint8_t *bits = scratch(L, (size_t)count);
+    e_codec_bits(bits, (const uint8_t *)s, (size_t)start, (size_t)count);
+
+    lua_createtable(L, (int)count, 0);
+    for (lua_Integer i = 0; i < count; i++) {
+        lua_pushinteger(L, bits[i]);
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+    return 1;
+}
+
+/* codec.hex(s) */
+static int l_hex(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    char *out = scratch(L, E_CODEC_HEX_LEN(len));
+    lua_pushlstring(L, out, e_codec_hex_encode(out, (const uint8_t *)s, len));
+    return 1;
+}
+
+/* codec.unhex(s) -> 数据，或 nil 与错误信息 */
+static int l_unhex(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    uint8_t *out = scratch(L, len / 2);
+    long n = e_codec_hex_decode(out, s, len);
+    if (n < 0) {
+        lua_pushnil(L);
+        lua_pushstring(L, "invalid hex string");
+        return 2;
+    }
+    lua_pushlstring(L, (const char *)out, (size_t)n);
+    return 1;
+}
+
+/* codec.base64(s) */
+static int l_base64(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    char *out = scratch(L, E_CODEC_BASE64_LEN(len));
+    lua_pushlstring(L, out, e_codec_base64_encode(out, (const uint8_t *)s, len));
+    return 1;
+}
+
+/* codec.unbase64(s) -> 数据，或 nil 与错误信息 */
+static int l_unbase64(lua_State *L) {
+    size_t len;
+    const char *s = luaL_checklstring(L, 1, &len);
+    uint8_t *out = scratch(L, len / 4 * 3 + 2);
+    long n = e_codec_base64_decode(out, s, len);
+    if (n < 0) {
+        lua_pushnil(L);
+        lua_pushstring(L, "invalid base64 string");
+        return 2;
+    }
+    lua_pushlstring(L, (const char *)out, (size_t)n);
+    return 1;
+}
+
+static const luaL_Reg e_codec_lib[] = {
+    {"swap16",     l_swap16},
+    {"swap32",     l_swap32},
+    {"swap_words", l_swap_words},
+    {"scale",      l_scale},
+    {"read",       l_read},
+    {"bits",       l_bits},
+    {"hex",        l_hex},
+    {"unhex",      l_unhex},
+    {"base64",     l_base64},
+    {"unbase64",   l_unbase64},
+    {NULL, NULL}
+};
+
+int luaopen_ezmb_codec(lua_State *L) {
+    luaL_newlib(L, e_codec_lib);
+
+    lua_pushstring(L, e_codec_simd());
+    lua_setfield(L, -2, "simd");
+
+    return 1;
+}
@@ -0,0 +1,72 @@
+#include "e_crc.h"
+#include <pthread.h>
+
+#define CRC16_MODBUS_POLY   0xA001
+#define SLICE8_MIN_LEN      8       // 不足一轮 8 字节时直接走单表
+
+static uint16_t crc_tables[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+/* tables[0] 为标准单字节表，tables[k][i] 为字节 i 之后再经过 k 个零字节的结果 */
+static void crc_tables_init(void) {
+    for (int i = 0; i < 256; i++) {
+        crc_tables[0][i] = e_crc16_modbus_bitwise(0, (const uint8_t[]){ (uint8_t)i }, 1);
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint16_t prev = crc_tables[k - 1][i];
+            crc_tables[k][i] = (prev >> 8) ^ crc_tables[0][prev & 0xFF];
+        }
+    }
+}
+
+uint16_t e_crc16_modbus_bitwise(uint16_t crc, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC16_MODBUS_POLY : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t e_crc16_modbus_table(uint16_t crc, const uint8_t *data, size_t len) {
+    pthread_once(&crc_once, crc_tables_init);
+    while (len--) {
+        crc = (crc >> 8) ^ crc_tables[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+uint16_t e_crc16_modbus_slice8(uint16_t crc, const uint8_t *data, size_t len) {
+    pthread_once(&crc_once, crc_tables_init);
+    while (len >= 8) {
+        // CRC 只有 16 位，只与前 2 字节异或，其余 6 字节直接查表
+        crc ^= (uint16_t)(data[0] | data[1] << 8);
+        crc = crc_tables[7][crc & 0xFF] ^ crc_tables[6][crc >> 8] ^
+              crc_tables[5][data[2]] ^ crc_tables[4][data[3]] ^
+              crc_tables[3][data[4]] ^ crc_tables[2][data[5]] ^
+              crc_tables[1][data[6]] ^ crc_tables[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = (crc >> 8) ^ crc_tables[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+uint16_t e_crc16_modbus_update(uint16_t crc, const uint8_t *data, size_t len) {
+    if (len >= SLICE8_MIN_LEN) return e_crc16_modbus_slice8(crc, data, len);
+    return e_crc16_modbus_table(crc, data, len);
+}
+
+uint16_t e_crc16_modbus(const uint8_t *data, size_t len) {
+    return e_crc16_modbus_update(E_CRC16_MODBUS_INIT, data, len);
+}
+
+int e_crc16_modbus_check(const uint8_t *frame, size_t len) {
+    if (len < 3) return 0;
+    uint16_t crc = e_crc16_modbus(frame, len - 2);
+    return frame[len - 2] == (crc & 0xFF) && frame[len - 1] == (crc >> 8);
+}
@@ -0,0 +1,58 @@
+#ifndef E_CRC_H
+#define E_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC-16/MODBUS（多项式 0x8005 反射即 0xA001，初值 0xFFFF），结果低字节先发送。
+ * 提供三种实现，结果一致：
+ *   bitwise  逐位计算，无表，用作参考
+ *   table    单表查表，每字节一次查表
+ *   slice8   8 张表，每 8 字节一轮，长帧最快
+ * e_crc16_modbus() 按长度自动选择。
+ */
+
+#define E_CRC16_MODBUS_INIT     0xFFFF
+
+/**
+ * @brief 计算 CRC-16/MODBUS（按长度选择最快实现）
+ * @param data 数据
+ * @param len 数据长度
+ * @return CRC 值
+ */
+uint16_t e_crc16_modbus(const uint8_t *data, size_t len);
+
+/**
+ * @brief 在已有 CRC 基础上继续计算（流式），首次传入 E_CRC16_MODBUS_INIT
+ * @param crc 当前 CRC
+ * @param data 数据
+ * @param len 数据长度
+ * @return 新的 CRC 值
+ */
+uint16_t e_crc16_modbus_update(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief 逐位实现
+ */
+uint16_t e_crc16_modbus_bitwise(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief 单表实现
+ */
+uint16_t e_crc16_modbus_table(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief slice-by-8 实现
+ */
+uint16_t e_crc16_modbus_slice8(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief 校验 RTU 帧末尾的 CRC
+ * @param frame 帧数据（含末尾 2 字节 CRC）
+ * @param len 帧长度
+ * @return 1校验通过，0失败
+ */
+int e_crc16_modbus_check(const uint8_t *frame, size_t len);
+
+#endif // E_CRC_H
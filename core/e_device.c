@@ -72,6 +72,9 @@ e_device_t *e_common_create(const char *uid, const char *south_url, const char *
     device->south_topic = strdup(topic_tmp);
     snprintf(topic_tmp, sizeof(topic_tmp), "%s_north_topic", uid);
     device->north_topic = strdup(topic_tmp);
+    snprintf(topic_tmp, sizeof(topic_tmp), "%s_data_topic", uid);
+    device->data_topic = strdup(topic_tmp);
+    pthread_mutex_init(&device->send_mutex, NULL);
 
     if(type == E_DEVICE_TYPE_COLLECTOR) {
         zmq_setsockopt(device->south_sock, ZMQ_SUBSCRIBE, device->south_topic, strlen(device->south_topic));
@@ -148,17 +151,32 @@ void e_device_listen(e_device_t *device) {
 int e_common_send(e_device_t *device, const char *msg, size_t size) {
     if (!device || !msg || size == 0) return -1;
     int rc = 0;
+    pthread_mutex_lock(&device->send_mutex);
     if(device->type == E_DEVICE_TYPE_COLLECTOR) {
         rc = zmq_send(device->north_sock, device->north_topic, strlen(device->north_topic), ZMQ_SNDMORE);
     } else if(device->type == E_DEVICE_TYPE_MONITOR) {
         rc = zmq_send(device->north_sock, device->south_topic, strlen(device->south_topic), ZMQ_SNDMORE);
     }
-    if(rc < 0) return -1;
-    rc = zmq_send(device->north_sock, msg, size, 0);
+    if(rc >= 0) rc = zmq_send(device->north_sock, msg, size, 0);
+    pthread_mutex_unlock(&device->send_mutex);
     if(rc < 0) return -1;
     return rc;
 }
 
+int e_common_publish(e_device_t *device, const char *msg, size_t size) {
+    if (!device || !msg || size == 0 || device->type != E_DEVICE_TYPE_COLLECTOR) return -1;
+    pthread_mutex_lock(&device->send_mutex);
+    int rc = zmq_send(device->north_sock, device->data_topic, strlen(device->data_topic), ZMQ_SNDMORE);
+    if (rc >= 0) rc = zmq_send(device->north_sock, msg, size, 0);
+    pthread_mutex_unlock(&device->send_mutex);
+    return rc < 0 ? -1 : rc;
+}
+
+int e_device_subscribe_data(e_device_t *device) {
+    if (!device || device->type != E_DEVICE_TYPE_MONITOR) return -1;
+    return zmq_setsockopt(device->south_sock, ZMQ_SUBSCRIBE, device->data_topic, strlen(device->data_topic));
+}
+
 void e_device_stop(e_device_t *device) {
     if (device) {
         device->running = false;
@@ -180,6 +198,9 @@ void e_device_destroy(e_device_t *device) {
         free((char *)device->south_topic);
     if(device->north_topic)
         free((char *)device->north_topic);
+    if(device->data_topic)
+        free((char *)device->data_topic);
+    pthread_mutex_destroy(&device->send_mutex);
 
 
     free(device);
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 /**
  * @brief 设备类型
@@ -46,6 +47,12 @@ typedef enum {
 #define e_collector_send     e_common_send  
 #define e_monitor_send   e_common_send  
 
+/**
+ * @brief 发布解码后的数据（数据主题）
+ * 
+*/
+#define e_collector_publish e_common_publish
+
 /**
  * @brief 监听设备
  * 
@@ -86,7 +93,10 @@ typedef struct {
     char *north_url;        //北向地址
     char *south_topic;      //南向主题
     char *north_topic;      //北向主题
+    char *data_topic;       //数据主题（采集器发布的解码数据）
+    pthread_mutex_t send_mutex; //保护北向socket（多个线程发送）
     e_device_recv_cb cb;    //回调函数
+    void *arg;              //用户数据（由使用者设置，设备本身不使用）
     bool running;//运行状态
 } e_device_t;
 
@@ -116,6 +126,22 @@ void e_device_listen(e_device_t *device);
  */
 int e_common_send(e_device_t *device, const char *msg, size_t size);
 
+/**
+ * @brief 在数据主题上发布消息（采集器发布解码后的数据）
+ * @param device 设备句柄
+ * @param msg 消息
+ * @param size 消息大小
+ * @return 发送的字节数，-1失败
+ */
+int e_common_publish(e_device_t *device, const char *msg, size_t size);
+
+/**
+ * @brief 监视器订阅设备的数据主题（默认只订阅北向主题）
+ * @param device 设备句柄
+ * @return 0成功，-1失败
+ */
+int e_device_subscribe_data(e_device_t *device);
+
 /**
  * @brief 停止设备
  * @param device 设备句柄
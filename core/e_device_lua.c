@@ -138,6 +138,22 @@ static int l_device_send(lua_State *L) {
     return 1;
 }
 
+static int l_device_publish(lua_State *L) {
+    lua_e_device_t *ud = (lua_e_device_t *)luaL_checkudata(L, 1, "e_device");
+    size_t len;
+    const char *msg = luaL_checklstring(L, 2, &len);
+
+    int ret = e_common_publish(ud->device, msg, len);
+    lua_pushboolean(L, ret >= 0);
+    return 1;
+}
+
+static int l_device_subscribe_data(lua_State *L) {
+    lua_e_device_t *ud = (lua_e_device_t *)luaL_checkudata(L, 1, "e_device");
+    lua_pushboolean(L, e_device_subscribe_data(ud->device) == 0);
+    return 1;
+}
+
 static int l_device_stop(lua_State *L) {
     lua_e_device_t *ud = (lua_e_device_t *)luaL_checkudata(L, 1, "e_device");
     e_device_stop(ud->device);
@@ -181,6 +197,9 @@ static int l_device_index(lua_State *L) {
     } else if (strcmp(key, "north_topic") == 0) {
         lua_pushstring(L, dev->north_topic ? dev->north_topic : "");
         return 1;
+    } else if (strcmp(key, "data_topic") == 0) {
+        lua_pushstring(L, dev->data_topic ? dev->data_topic : "");
+        return 1;
     } else if (strcmp(key, "running") == 0) {
         lua_pushboolean(L, dev->running);
         return 1;
@@ -195,6 +214,8 @@ static const luaL_Reg e_device_methods[] = {
     {"set_callback", l_device_set_callback},
     {"listen",       l_device_listen},
     {"send",         l_device_send},
+    {"publish",      l_device_publish},
+    {"subscribe_data", l_device_subscribe_data},
     {"stop",         l_device_stop},
     {"destroy",      l_device_destroy},
     {NULL, NULL}
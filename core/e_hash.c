@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+#include "e_hash.h"
+
+#define E_HASH_MIN_CAPACITY 16
+
+uint32_t e_hash_string(const char *key){
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    while (*key){
+        h ^= (unsigned char)*key++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int find_slot(e_hash_t *h, const char *key, uint32_t hash){
+    uint32_t mask = h->capacity - 1;
+    uint32_t i = hash & mask;
+    while (h->slots[i].key){
+        if (h->slots[i].hash == hash && strcmp(h->slots[i].key, key) == 0){
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1 - (int)i;  // 未找到时返回可插入位置的编码
+}
+
+static int resize(e_hash_t *h, int capacity){
+    e_hash_slot_t *slots = (e_hash_slot_t *)calloc(capacity, sizeof(e_hash_slot_t));
+    if (!slots){
+        return -1;
+    }
+    uint32_t mask = capacity - 1;
+    for (int i = 0; i < h->capacity; i++){
+        if (!h->slots[i].key){
+            continue;
+        }
+        uint32_t j = h->slots[i].hash & mask;
+        while (slots[j].key){
+            j = (j + 1) & mask;
+        }
+        slots[j] = h->slots[i];
+    }
+    free(h->slots);
+    h->slots = slots;
+    h->capacity = capacity;
+    return 0;
+}
+
+int e_hash_init(e_hash_t *h, int capacity){
+    int cap = E_HASH_MIN_CAPACITY;
+    while (cap < capacity * 2){
+        cap <<= 1;
+    }
+    h->slots = (e_hash_slot_t *)calloc(cap, sizeof(e_hash_slot_t));
+    if (!h->slots){
+        h->capacity = 0;
+        h->size = 0;
+        return -1;
+    }
+    h->capacity = cap;
+    h->size = 0;
+    return 0;
+}
+
+void e_hash_destroy(e_hash_t *h){
+    if (!h || !h->slots){
+        return;
+    }
+    for (int i = 0; i < h->capacity; i++){
+        free(h->slots[i].key);
+    }
+    free(h->slots);
+    h->slots = NULL;
+    h->capacity = 0;
+    h->size = 0;
+}
+
+int e_hash_size(e_hash_t *h){
+    return h->size;
+}
+
+void *e_hash_get(e_hash_t *h, const char *key){
+    if (!h || !h->slots || !key){
+        return NULL;
+    }
+    int i = find_slot(h, key, e_hash_string(key));
+    return i >= 0 ? h->slots[i].value : NULL;
+}
+
+/* 插入键值，键已存在返回1（不覆盖），失败返回-1 */
+int e_hash_put(e_hash_t *h, const char *key, void *value){
+    if (!h || !h->slots || !key){
+        return -1;
+    }
+    // 负载因子超过 3/4 时扩容
+    if ((h->size + 1) * 4 > h->capacity * 3 && resize(h, h->capacity * 2) != 0){
+        return -1;
+    }
+    uint32_t hash = e_hash_string(key);
+    int i = find_slot(h, key, hash);
+    if (i >= 0){
+        return 1;
+    }
+    i = -1 - i;
+    h->slots[i].key = strdup(key);
+    if (!h->slots[i].key){
+        return -1;
+    }
+    h->slots[i].hash = hash;
+    h->slots[i].value = value;
+    h->size++;
+    return 0;
+}
+
+/* 删除键并返回其值；使用后移删除，不留墓碑 */
+void *e_hash_remove(e_hash_t *h, const char *key){
+    if (!h || !h->slots || !key){
+        return NULL;
+    }
+    int found = find_slot(h, key, e_hash_string(key));
+    if (found < 0){
+        return NULL;
+    }
+    uint32_t mask = h->capacity - 1;
+    uint32_t i = found;
+    void *value = h->slots[i].value;
+    free(h->slots[i].key);
+
+    uint32_t j = i;
+    for (;;){
+        j = (j + 1) & mask;
+        if (!h->slots[j].key){
+            break;
+        }
+        // 槽 j 的理想位置不在 (i, j] 区间内时前移填补空洞
+        uint32_t home = h->slots[j].hash & mask;
+        if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))){
+            h->slots[i] = h->slots[j];
+            i = j;
+        }
+    }
+    h->slots[i].key = NULL;
+    h->slots[i].value = NULL;
+    h->size--;
+    return value;
+}
+
+void e_hash_foreach(e_hash_t *h, void *arg, e_hash_foreach_callback callback){
+    if (!h || !h->slots){
+        return;
+    }
+    for (int i = 0; i < h->capacity; i++){
+        if (h->slots[i].key){
+            callback(arg, h->slots[i].key, h->slots[i].value);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef __E_HASH_H__
+#define __E_HASH_H__
+
+#include <stdint.h>
+
+/* 开放寻址哈希表槽位 */
+typedef struct e_hash_slot{
+    char *key;          // 键（表内拷贝），NULL表示空槽
+    uint32_t hash;      // 键的哈希值
+    void *value;        // 值（表不负责释放）
+}e_hash_slot_t;
+
+/* 以字符串为键的开放寻址（线性探测）哈希表 */
+typedef struct e_hash{
+    e_hash_slot_t *slots;
+    int capacity;       // 槽位数，2的幂
+    int size;           // 已用槽位数
+}e_hash_t;
+
+typedef int (*e_hash_foreach_callback)(void *arg, const char *key, void *value);
+
+int e_hash_init(e_hash_t *h, int capacity);
+void e_hash_destroy(e_hash_t *h);
+int e_hash_size(e_hash_t *h);
+uint32_t e_hash_string(const char *key);
+void *e_hash_get(e_hash_t *h, const char *key);
+int e_hash_put(e_hash_t *h, const char *key, void *value);
+void *e_hash_remove(e_hash_t *h, const char *key);
+void e_hash_foreach(e_hash_t *h, void *arg, e_hash_foreach_callback callback);
+#endif
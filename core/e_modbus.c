@@ -0,0 +1,293 @@
+#include "e_modbus.h"
+#include "e_crc.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static int append_crc(uint8_t *buf, int len) {
+    uint16_t crc = e_crc16_modbus(buf, len);
+    buf[len++] = crc & 0xFF;
+    buf[len++] = crc >> 8;
+    return len;
+}
+
+int e_modbus_is_read(uint8_t function) {
+    return function >= MODBUS_FC_READ_COILS && function <= MODBUS_FC_READ_INPUT_REGISTERS;
+}
+
+int e_modbus_request_valid(const e_modbus_request_t *req) {
+    if (!req) return -1;
+
+    int max;
+    switch (req->function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            max = MODBUS_MAX_READ_BITS;
+            break;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            max = MODBUS_MAX_READ_REGISTERS;
+            break;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            max = 1;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            max = MODBUS_MAX_WRITE_BITS;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            max = MODBUS_MAX_WRITE_REGISTERS;
+            break;
+        default:
+            return -1;
+    }
+
+    if (req->count < 1 || req->count > max) return -1;
+    if ((uint32_t)req->address + req->count > 0x10000) return -1;
+    return 0;
+}
+
+int e_modbus_build_request(const e_modbus_request_t *req, const uint16_t *values, uint8_t *buf, size_t size) {
+    if (!buf || e_modbus_request_valid(req) != 0) return -1;
+    if (!e_modbus_is_read(req->function) && !values) return -1;
+
+    uint8_t tmp[MODBUS_RTU_MAX_ADU];
+    int len = 0;
+    tmp[len++] = req->slave;
+    tmp[len++] = req->function;
+    put_u16(tmp + len, req->address);
+    len += 2;
+
+    switch (req->function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            put_u16(tmp + len, req->count);
+            len += 2;
+            break;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+            put_u16(tmp + len, values[0] ? 0xFF00 : 0x0000);
+            len += 2;
+            break;
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            put_u16(tmp + len, values[0]);
+            len += 2;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS: {
+            int bytes = (req->count + 7) / 8;
+            put_u16(tmp + len, req->count);
+            len += 2;
+            tmp[len++] = bytes;
+            memset(tmp + len, 0, bytes);
+            for (int i = 0; i < req->count; i++) {
+                if (values[i]) tmp[len + i / 8] |= 1 << (i % 8);
+            }
+            len += bytes;
+            break;
+        }
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            put_u16(tmp + len, req->count);
+            len += 2;
+            tmp[len++] = req->count * 2;
+            for (int i = 0; i < req->count; i++) {
+                put_u16(tmp + len, values[i]);
+                len += 2;
+            }
+            break;
+    }
+
+    len = append_crc(tmp, len);
+    if ((size_t)len > size) return -1;
+    memcpy(buf, tmp, len);
+    return len;
+}
+
+int e_modbus_parse_request(const uint8_t *pdu, size_t len, e_modbus_request_t *req) {
+    if (!pdu || len < 1 || !req) return MODBUS_EXC_ILLEGAL_FUNCTION;
+
+    uint8_t function = pdu[0];
+    if (function < MODBUS_FC_READ_COILS || function > MODBUS_FC_WRITE_MULTIPLE_REGISTERS ||
+        (function > MODBUS_FC_WRITE_SINGLE_REGISTER && function < MODBUS_FC_WRITE_MULTIPLE_COILS)) {
+        return MODBUS_EXC_ILLEGAL_FUNCTION;
+    }
+    if (len < 5) return MODBUS_EXC_ILLEGAL_VALUE;
+
+    req->function = function;
+    req->address = get_u16(pdu + 1);
+    switch (function) {
+        case MODBUS_FC_WRITE_SINGLE_COIL: {
+            uint16_t value = get_u16(pdu + 3);
+            if (len != 5 || (value != 0xFF00 && value != 0x0000)) return MODBUS_EXC_ILLEGAL_VALUE;
+            req->count = 1;
+            break;
+        }
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            if (len != 5) return MODBUS_EXC_ILLEGAL_VALUE;
+            req->count = 1;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            req->count = get_u16(pdu + 3);
+            if (len < 6 || pdu[5] != (req->count + 7) / 8 || len != 6u + pdu[5]) return MODBUS_EXC_ILLEGAL_VALUE;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            req->count = get_u16(pdu + 3);
+            if (len < 6 || pdu[5] != req->count * 2 || len != 6u + pdu[5]) return MODBUS_EXC_ILLEGAL_VALUE;
+            break;
+        default:
+            if (len != 5) return MODBUS_EXC_ILLEGAL_VALUE;
+            req->count = get_u16(pdu + 3);
+            break;
+    }
+
+    // 数量越界优先报非法数据值，数量合法但地址越界报非法地址
+    if (e_modbus_request_valid(req) != 0) {
+        e_modbus_request_t probe = *req;
+        probe.address = 0;
+        return e_modbus_request_valid(&probe) != 0 ? MODBUS_EXC_ILLEGAL_VALUE : MODBUS_EXC_ILLEGAL_ADDRESS;
+    }
+    return 0;
+}
+
+int e_modbus_merge_reads(const e_modbus_request_t *a, const e_modbus_request_t *b, int max_gap, int max_span,
+                         e_modbus_request_t *merged) {
+    if (!a || !b || !merged) return 0;
+    if (a->slave != b->slave || a->function != b->function || !e_modbus_is_read(a->function)) return 0;
+    if (a->slave == 0 || max_gap < 0) return 0;
+
+    uint32_t a_end = (uint32_t)a->address + a->count;
+    uint32_t b_end = (uint32_t)b->address + b->count;
+    uint32_t first = a->address < b->address ? a->address : b->address;
+    uint32_t last = a_end > b_end ? a_end : b_end;
+
+    // 两段之间的空洞：后一段起始地址减去前一段结束地址，重叠时为负
+    int64_t gap = a->address < b->address ? (int64_t)b->address - a_end : (int64_t)a->address - b_end;
+    if (gap > max_gap) return 0;
+
+    int limit = (a->function == MODBUS_FC_READ_COILS || a->function == MODBUS_FC_READ_DISCRETE_INPUTS)
+                ? MODBUS_MAX_READ_BITS : MODBUS_MAX_READ_REGISTERS;
+    if (max_span > 0 && max_span < limit) limit = max_span;
+    if (last - first > (uint32_t)limit) return 0;
+
+    merged->slave = a->slave;
+    merged->function = a->function;
+    merged->address = (uint16_t)first;
+    merged->count = (uint16_t)(last - first);
+    return 1;
+}
+
+int e_modbus_build_read_pdu(const e_modbus_request_t *req, const e_modbus_request_t *whole, const uint16_t *values,
+                            uint8_t *pdu, size_t size) {
+    if (!req || !whole || !values || !pdu || !e_modbus_is_read(req->function)) return -1;
+    if (req->function != whole->function || req->address < whole->address ||
+        (uint32_t)req->address + req->count > (uint32_t)whole->address + whole->count) return -1;
+
+    // 响应帧去掉从站地址和 CRC 即为 PDU
+    int len = e_modbus_response_length(req) - 3;
+    if (len < 0 || (size_t)len > size) return -1;
+
+    const uint16_t *v = values + (req->address - whole->address);
+    pdu[0] = req->function;
+    pdu[1] = (uint8_t)(len - 2);
+    if (req->function == MODBUS_FC_READ_COILS || req->function == MODBUS_FC_READ_DISCRETE_INPUTS) {
+        memset(pdu + 2, 0, len - 2);
+        for (int i = 0; i < req->count; i++) {
+            if (v[i]) pdu[2 + i / 8] |= 1 << (i % 8);
+        }
+    } else {
+        for (int i = 0; i < req->count; i++) {
+            put_u16(pdu + 2 + i * 2, v[i]);
+        }
+    }
+    return len;
+}
+
+int e_modbus_response_length(const e_modbus_request_t *req) {
+    if (!req) return -1;
+
+    switch (req->function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            return 5 + (req->count + 7) / 8;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            return 5 + req->count * 2;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return 8;
+        default:
+            return -1;
+    }
+}
+
+e_modbus_status_t e_modbus_parse_response(const e_modbus_request_t *req, const uint8_t *rsp, size_t len,
+                                          uint16_t *values, uint8_t *exception) {
+    if (len < 2) return E_MODBUS_INCOMPLETE;
+    if (rsp[0] != req->slave) return E_MODBUS_MISMATCH;
+
+    // 异常响应：地址 + 功能码|0x80 + 异常码 + CRC
+    if (rsp[1] == (req->function | 0x80)) {
+        if (len < 5) return E_MODBUS_INCOMPLETE;
+        if (!e_crc16_modbus_check(rsp, 5)) return E_MODBUS_BAD_CRC;
+        if (exception) *exception = rsp[2];
+        return E_MODBUS_EXCEPTION;
+    }
+    if (rsp[1] != req->function) return E_MODBUS_MISMATCH;
+
+    int expect = e_modbus_response_length(req);
+    if (expect < 0) return E_MODBUS_MISMATCH;
+    if (len < (size_t)expect) return E_MODBUS_INCOMPLETE;
+    if (!e_crc16_modbus_check(rsp, expect)) return E_MODBUS_BAD_CRC;
+
+    switch (req->function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            if (rsp[2] != expect - 5) return E_MODBUS_MISMATCH;
+            if (values) {
+                for (int i = 0; i < req->count; i++) {
+                    values[i] = (rsp[3 + i / 8] >> (i % 8)) & 1;
+                }
+            }
+            break;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            if (rsp[2] != expect - 5) return E_MODBUS_MISMATCH;
+            if (values) {
+                for (int i = 0; i < req->count; i++) {
+                    values[i] = get_u16(rsp + 3 + i * 2);
+                }
+            }
+            break;
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+            if (get_u16(rsp + 2) != req->address) return E_MODBUS_MISMATCH;
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            if (get_u16(rsp + 2) != req->address || get_u16(rsp + 4) != req->count) return E_MODBUS_MISMATCH;
+            break;
+    }
+
+    return E_MODBUS_OK;
+}
+
+const char *e_modbus_strerror(e_modbus_status_t status) {
+    switch (status) {
+        case E_MODBUS_OK:           return "ok";
+        case E_MODBUS_INCOMPLETE:   return "incomplete";
+        case E_MODBUS_EXCEPTION:    return "exception";
+        case E_MODBUS_BAD_CRC:      return "bad crc";
+        case E_MODBUS_MISMATCH:     return "mismatch";
+        case E_MODBUS_TIMEOUT:      return "timeout";
+    }
+    return "unknown";
+}
@@ -0,0 +1,145 @@
+#ifndef E_MODBUS_H
+#define E_MODBUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MODBUS_RTU_MAX_ADU          256     // RTU 帧最大长度
+#define MODBUS_MAX_READ_BITS        2000    // 01/02 单次最多读取的线圈数
+#define MODBUS_MAX_READ_REGISTERS   125     // 03/04 单次最多读取的寄存器数
+#define MODBUS_MAX_WRITE_BITS       1968    // 15 单次最多写入的线圈数
+#define MODBUS_MAX_WRITE_REGISTERS  123     // 16 单次最多写入的寄存器数
+
+/* 功能码 */
+#define MODBUS_FC_READ_COILS                0x01
+#define MODBUS_FC_READ_DISCRETE_INPUTS      0x02
+#define MODBUS_FC_READ_HOLDING_REGISTERS    0x03
+#define MODBUS_FC_READ_INPUT_REGISTERS      0x04
+#define MODBUS_FC_WRITE_SINGLE_COIL         0x05
+#define MODBUS_FC_WRITE_SINGLE_REGISTER     0x06
+#define MODBUS_FC_WRITE_MULTIPLE_COILS      0x0F
+#define MODBUS_FC_WRITE_MULTIPLE_REGISTERS  0x10
+
+/* 异常码 */
+#define MODBUS_EXC_ILLEGAL_FUNCTION         0x01
+#define MODBUS_EXC_ILLEGAL_ADDRESS          0x02
+#define MODBUS_EXC_ILLEGAL_VALUE            0x03
+#define MODBUS_EXC_SLAVE_FAILURE            0x04
+#define MODBUS_EXC_SLAVE_BUSY               0x06
+#define MODBUS_EXC_GATEWAY_PATH_UNAVAILABLE 0x0A
+#define MODBUS_EXC_GATEWAY_TARGET_FAILED    0x0B
+
+/**
+ * @brief 响应解析结果
+ *
+ * @param E_MODBUS_OK: 响应有效
+ * @param E_MODBUS_INCOMPLETE: 响应尚未接收完整
+ * @param E_MODBUS_EXCEPTION: 从站返回异常响应
+ * @param E_MODBUS_BAD_CRC: CRC 校验失败
+ * @param E_MODBUS_MISMATCH: 从站地址、功能码或长度与请求不匹配
+ * @param E_MODBUS_TIMEOUT: 等待响应超时（由主站引擎使用）
+ */
+typedef enum {
+    E_MODBUS_OK = 0,
+    E_MODBUS_INCOMPLETE,
+    E_MODBUS_EXCEPTION,
+    E_MODBUS_BAD_CRC,
+    E_MODBUS_MISMATCH,
+    E_MODBUS_TIMEOUT,
+} e_modbus_status_t;
+
+/* 一次 Modbus 请求 */
+typedef struct {
+    uint8_t slave;          // 从站地址
+    uint8_t function;       // 功能码
+    uint16_t address;       // 起始地址
+    uint16_t count;         // 数量（05/06 固定为 1）
+} e_modbus_request_t;
+
+/* 扫描表中的一个轮询块 */
+typedef struct {
+    e_modbus_request_t req;
+    int period_ms;          // 轮询周期
+    int deadline_ms;        // 相对截止时间（0 表示等于周期）
+} e_modbus_scan_t;
+
+/**
+ * @brief 检查请求参数是否合法（功能码、数量范围、地址越界）
+ * @param req 请求
+ * @return 0合法，-1非法
+ */
+int e_modbus_request_valid(const e_modbus_request_t *req);
+
+/**
+ * @brief 构造 RTU 请求帧
+ * @param req 请求
+ * @param values 写入值：05/15 每个元素表示一个线圈（非0为ON），06/16 为寄存器值；读请求传 NULL
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 帧长度，-1失败
+ */
+int e_modbus_build_request(const e_modbus_request_t *req, const uint16_t *values, uint8_t *buf, size_t size);
+
+/**
+ * @brief 解析请求 PDU（功能码起始，不含从站地址和 CRC），用于网关/从站侧
+ * @param pdu PDU 数据
+ * @param len PDU 长度
+ * @param req 输出请求（slave 字段不修改）
+ * @return 0合法，否则为应答给主站的异常码
+ */
+int e_modbus_parse_request(const uint8_t *pdu, size_t len, e_modbus_request_t *req);
+
+/**
+ * @brief 尝试把两个读请求合并为一次总线读取
+ * @param a 请求一
+ * @param b 请求二
+ * @param max_gap 两段地址之间允许跨过的最大空洞（寄存器或线圈数），重叠或相邻为 0
+ * @param max_span 合并后允许的最大数量，0 表示协议上限
+ * @param merged 输出合并后的请求，可与 a 相同
+ * @return 1可合并，0不可合并（从站、功能码不同，非读请求，或超出空洞与跨度限制）
+ */
+int e_modbus_merge_reads(const e_modbus_request_t *a, const e_modbus_request_t *b, int max_gap, int max_span,
+                         e_modbus_request_t *merged);
+
+/**
+ * @brief 从合并读取的解码结果中截取子请求，构造其正常响应 PDU（功能码 + 字节数 + 数据）
+ * @param req 子请求（地址范围须包含在 whole 中）
+ * @param whole 实际发往总线的合并请求
+ * @param values whole 的解码结果
+ * @param pdu 输出缓冲区
+ * @param size 缓冲区大小
+ * @return PDU 长度，-1失败
+ */
+int e_modbus_build_read_pdu(const e_modbus_request_t *req, const e_modbus_request_t *whole, const uint16_t *values,
+                            uint8_t *pdu, size_t size);
+
+/**
+ * @brief 计算正常响应帧的期望长度（含 CRC）
+ * @param req 请求
+ * @return 响应长度，-1功能码不支持
+ */
+int e_modbus_response_length(const e_modbus_request_t *req);
+
+/**
+ * @brief 校验并解析响应帧
+ * @param req 对应的请求
+ * @param rsp 已接收的响应数据
+ * @param len 已接收的长度
+ * @param values 解码结果：01/02 每个元素为一个线圈(0/1)，03/04 为寄存器值，可为 NULL
+ * @param exception 异常响应时返回异常码，可为 NULL
+ * @return 解析结果
+ */
+e_modbus_status_t e_modbus_parse_response(const e_modbus_request_t *req, const uint8_t *rsp, size_t len,
+                                          uint16_t *values, uint8_t *exception);
+
+/**
+ * @brief 是否为读功能码
+ */
+int e_modbus_is_read(uint8_t function);
+
+/**
+ * @brief 解析结果描述
+ */
+const char *e_modbus_strerror(e_modbus_status_t status);
+
+#endif // E_MODBUS_H
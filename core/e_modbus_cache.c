@@ -0,0 +1,248 @@
+#include "e_modbus_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_MIN_CAPACITY  256
+
+/* 功能码映射到数据区，写功能码与对应的读功能码共用 */
+static int fc_table(uint8_t function) {
+    switch (function) {
+        case MODBUS_FC_READ_COILS:
+        case MODBUS_FC_WRITE_SINGLE_COIL:
+        case MODBUS_FC_WRITE_MULTIPLE_COILS:
+            return 1;
+        case MODBUS_FC_READ_DISCRETE_INPUTS:
+            return 2;
+        case MODBUS_FC_READ_HOLDING_REGISTERS:
+        case MODBUS_FC_WRITE_SINGLE_REGISTER:
+        case MODBUS_FC_WRITE_MULTIPLE_REGISTERS:
+            return 3;
+        case MODBUS_FC_READ_INPUT_REGISTERS:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t make_key(uint8_t slave, int table, uint16_t address) {
+    return (uint32_t)slave << 24 | (uint32_t)table << 16 | address;
+}
+
+static uint32_t hash_key(uint32_t key) {
+    return key * 2654435761u;
+}
+
+static e_modbus_cache_entry_t *find_slot(e_modbus_cache_t *cache, uint32_t key) {
+    uint32_t mask = cache->capacity - 1;
+    uint32_t i = hash_key(key) & mask;
+    while (cache->slots[i].key && cache->slots[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &cache->slots[i];
+}
+
+static int resize(e_modbus_cache_t *cache, int capacity) {
+    e_modbus_cache_entry_t *old = cache->slots;
+    int old_capacity = cache->capacity;
+
+    cache->slots = calloc(capacity, sizeof(e_modbus_cache_entry_t));
+    if (!cache->slots) {
+        cache->slots = old;
+        return -1;
+    }
+    cache->capacity = capacity;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].key) *find_slot(cache, old[i].key) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+static int ttl_for(const e_modbus_cache_t *cache, uint8_t slave, int table, uint16_t address) {
+    for (int i = 0; i < cache->rule_count; i++) {
+        const e_modbus_cache_rule_t *rule = &cache->rules[i];
+        if ((rule->slave < 0 || rule->slave == slave) && (rule->table == 0 || rule->table == table) &&
+            address >= rule->first && address <= rule->last) {
+            return rule->ttl_ms;
+        }
+    }
+    return cache->default_ttl_ms;
+}
+
+e_modbus_cache_t *e_modbus_cache_create(int ttl_ms) {
+    e_modbus_cache_t *cache = calloc(1, sizeof(e_modbus_cache_t));
+    if (!cache) {
+        perror("Failed to allocate modbus cache");
+        return NULL;
+    }
+    cache->slots = calloc(CACHE_MIN_CAPACITY, sizeof(e_modbus_cache_entry_t));
+    if (!cache->slots) {
+        perror("Failed to allocate modbus cache slots");
+        free(cache);
+        return NULL;
+    }
+    cache->capacity = CACHE_MIN_CAPACITY;
+    cache->default_ttl_ms = ttl_ms > 0 ? ttl_ms : 0;
+    return cache;
+}
+
+void e_modbus_cache_destroy(e_modbus_cache_t *cache) {
+    if (!cache) return;
+    free(cache->slots);
+    free(cache->rules);
+    free(cache);
+}
+
+/* 解析 "从站:功能码:地址[-地址]=TTL"，* 表示任意 */
+static int parse_rule(const char *text, e_modbus_cache_rule_t *rule) {
+    char buf[64];
+    char *fields[3];
+    if (strlen(text) >= sizeof(buf)) return -1;
+    strcpy(buf, text);
+
+    char *eq = strchr(buf, '=');
+    if (!eq) return -1;
+    *eq = '\0';
+
+    char *saveptr = NULL;
+    for (int i = 0; i < 3; i++) {
+        fields[i] = strtok_r(i == 0 ? buf : NULL, ":", &saveptr);
+        if (!fields[i]) return -1;
+    }
+
+    char *end;
+    rule->slave = -1;
+    if (strcmp(fields[0], "*") != 0) {
+        rule->slave = strtol(fields[0], &end, 10);
+        if (*end || rule->slave < 1 || rule->slave > 247) return -1;
+    }
+
+    rule->table = 0;
+    if (strcmp(fields[1], "*") != 0) {
+        rule->table = fc_table(strtol(fields[1], &end, 10));
+        if (*end || rule->table == 0) return -1;
+    }
+
+    rule->first = 0;
+    rule->last = 0xFFFF;
+    if (strcmp(fields[2], "*") != 0) {
+        long first = strtol(fields[2], &end, 10), last = first;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        if (*end || first < 0 || last > 0xFFFF || first > last) return -1;
+        rule->first = first;
+        rule->last = last;
+    }
+
+    rule->ttl_ms = strtol(eq + 1, &end, 10);
+    if (*end || eq[1] == '\0' || rule->ttl_ms < 0) return -1;
+    return 0;
+}
+
+int e_modbus_cache_set_ttl(e_modbus_cache_t *cache, const char *spec) {
+    if (!cache || !spec) return -1;
+
+    char *copy = strdup(spec);
+    if (!copy) return -1;
+
+    int ret = 0;
+    int first = 1;
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(copy, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        if (first && !strchr(tok, '=')) {
+            char *end;
+            long ttl = strtol(tok, &end, 10);
+            if (*end || ttl < 0) {
+                ret = -1;
+                break;
+            }
+            cache->default_ttl_ms = ttl;
+            first = 0;
+            continue;
+        }
+        first = 0;
+
+        e_modbus_cache_rule_t rule;
+        if (parse_rule(tok, &rule) != 0) {
+            fprintf(stderr, "Invalid cache rule '%s' (expected slave:function:address[-address]=ttl)\n", tok);
+            ret = -1;
+            break;
+        }
+
+        e_modbus_cache_rule_t *rules = realloc(cache->rules, sizeof(e_modbus_cache_rule_t) * (cache->rule_count + 1));
+        if (!rules) {
+            ret = -1;
+            break;
+        }
+        cache->rules = rules;
+        cache->rules[cache->rule_count++] = rule;
+    }
+    free(copy);
+    return ret;
+}
+
+int e_modbus_cache_lookup(e_modbus_cache_t *cache, const e_modbus_request_t *req, uint16_t *values, uint64_t now_us) {
+    if (!cache || !req || !values || !e_modbus_is_read(req->function)) return 0;
+
+    int table = fc_table(req->function);
+    for (int i = 0; i < req->count; i++) {
+        const e_modbus_cache_entry_t *entry = find_slot(cache, make_key(req->slave, table, req->address + i));
+        if (!entry->key || entry->expire_us <= now_us) {
+            cache->stats.misses++;
+            return 0;
+        }
+        values[i] = entry->value;
+    }
+    cache->stats.hits++;
+    return 1;
+}
+
+void e_modbus_cache_store(e_modbus_cache_t *cache, const e_modbus_request_t *req, const uint16_t *values,
+                          uint64_t now_us) {
+    if (!cache || !req || !values || !e_modbus_is_read(req->function) || req->slave == 0) return;
+
+    int table = fc_table(req->function);
+    for (int i = 0; i < req->count; i++) {
+        uint16_t address = req->address + i;
+        int ttl = ttl_for(cache, req->slave, table, address);
+        if (ttl <= 0) continue;
+
+        // 负载超过一半时扩容，保证线性探测总能找到空槽
+        if ((cache->size + 1) * 2 > cache->capacity && resize(cache, cache->capacity * 2) != 0) return;
+
+        e_modbus_cache_entry_t *entry = find_slot(cache, make_key(req->slave, table, address));
+        if (!entry->key) {
+            entry->key = make_key(req->slave, table, address);
+            cache->size++;
+        }
+        entry->value = values[i];
+        entry->expire_us = now_us + (uint64_t)ttl * 1000ULL;
+        cache->stats.stores++;
+    }
+}
+
+void e_modbus_cache_invalidate(e_modbus_cache_t *cache, const e_modbus_request_t *req) {
+    if (!cache || !req) return;
+
+    int table = fc_table(req->function);
+    if (table == 0) return;
+    cache->stats.invalidations++;
+
+    // 失效只清除过期时间，槽位保留，查找时无需处理删除标记
+    if (req->slave == 0) {
+        for (int i = 0; i < cache->capacity; i++) {
+            e_modbus_cache_entry_t *entry = &cache->slots[i];
+            uint16_t address = entry->key & 0xFFFF;
+            if (entry->key && (int)((entry->key >> 16) & 0xFF) == table &&
+                address >= req->address && (uint32_t)address < (uint32_t)req->address + req->count) {
+                entry->expire_us = 0;
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < req->count; i++) {
+        e_modbus_cache_entry_t *entry = find_slot(cache, make_key(req->slave, table, req->address + i));
+        if (entry->key) entry->expire_us = 0;
+    }
+}
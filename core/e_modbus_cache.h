@@ -0,0 +1,94 @@
+#ifndef E_MODBUS_CACHE_H
+#define E_MODBUS_CACHE_H
+
+#include "e_modbus.h"
+#include <stdint.h>
+
+/* 缓存中的一个点 */
+typedef struct {
+    uint32_t key;           // 从站地址 | 数据区 | 地址，0 表示空槽
+    uint16_t value;         // 寄存器值，线圈/离散输入为 0/1
+    uint64_t expire_us;     // 过期时间（单调时钟），0 表示已失效
+} e_modbus_cache_entry_t;
+
+/* 按地址范围设置的 TTL，slave 为 -1 或 table 为 0 表示任意 */
+typedef struct {
+    int slave;
+    int table;              // 数据区：1线圈 2离散输入 3保持寄存器 4输入寄存器
+    uint16_t first;
+    uint16_t last;
+    int ttl_ms;             // 0 表示不缓存
+} e_modbus_cache_rule_t;
+
+/* 缓存统计 */
+typedef struct {
+    uint64_t hits;          // 全部点命中、直接应答的读请求数
+    uint64_t misses;        // 未命中的读请求数
+    uint64_t stores;        // 写入的点数
+    uint64_t invalidations; // 写请求使失效的次数
+} e_modbus_cache_stats_t;
+
+/**
+ * @brief 一个串口 uid 的寄存器映像缓存，点以 (从站地址, 数据区, 地址) 为键；
+ * 写功能码 05/06/15/16 与对应读功能码 01/03 共用数据区。非线程安全，由使用者加锁
+ */
+typedef struct {
+    e_modbus_cache_entry_t *slots;
+    int capacity;           // 槽位数，2的幂
+    int size;               // 已用槽位数
+    int default_ttl_ms;     // 没有匹配规则时的 TTL
+    e_modbus_cache_rule_t *rules;
+    int rule_count;
+    e_modbus_cache_stats_t stats;
+} e_modbus_cache_t;
+
+/**
+ * @brief 创建缓存
+ * @param ttl_ms 默认 TTL
+ * @return 缓存句柄，失败返回NULL
+ */
+e_modbus_cache_t *e_modbus_cache_create(int ttl_ms);
+
+/**
+ * @brief 销毁缓存
+ * @param cache 缓存句柄
+ */
+void e_modbus_cache_destroy(e_modbus_cache_t *cache);
+
+/**
+ * @brief 按规则设置 TTL，如 "500,1:3:100-120=2000,*:4:*=0"
+ * 第一项为默认 TTL，其后为 从站:功能码:地址[-地址]=TTL，* 表示任意，先匹配的规则生效
+ * @param cache 缓存句柄
+ * @param spec 规则
+ * @return 0成功，-1失败
+ */
+int e_modbus_cache_set_ttl(e_modbus_cache_t *cache, const char *spec);
+
+/**
+ * @brief 读请求的所有点均未过期时从缓存取值
+ * @param cache 缓存句柄
+ * @param req 读请求
+ * @param values 输出值，格式同 e_modbus_parse_response
+ * @param now_us 当前时间（单调时钟）
+ * @return 1命中，0未命中
+ */
+int e_modbus_cache_lookup(e_modbus_cache_t *cache, const e_modbus_request_t *req, uint16_t *values, uint64_t now_us);
+
+/**
+ * @brief 写入一次读取的结果
+ * @param cache 缓存句柄
+ * @param req 读请求
+ * @param values 读取结果
+ * @param now_us 读取完成的时间
+ */
+void e_modbus_cache_store(e_modbus_cache_t *cache, const e_modbus_request_t *req, const uint16_t *values,
+                          uint64_t now_us);
+
+/**
+ * @brief 使写请求覆盖的点失效，广播（从站地址 0）使所有从站的对应点失效
+ * @param cache 缓存句柄
+ * @param req 写请求
+ */
+void e_modbus_cache_invalidate(e_modbus_cache_t *cache, const e_modbus_request_t *req);
+
+#endif // E_MODBUS_CACHE_H
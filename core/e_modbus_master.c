@@ -0,0 +1,246 @@
+#include "e_modbus_master.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void us_to_timespec(uint64_t us, struct timespec *ts) {
+    ts->tv_sec = us / 1000000ULL;
+    ts->tv_nsec = (us % 1000000ULL) * 1000;
+}
+
+/* 总线事务完成（总线线程）：解码响应并唤醒轮询线程 */
+static void on_bus_done(void *arg, const uint8_t *frame, size_t frame_len, e_modbus_status_t status,
+                        const uint8_t *rsp, size_t rsp_len) {
+    (void)frame;
+    (void)frame_len;
+    e_modbus_master_t *master = (e_modbus_master_t *)arg;
+
+    pthread_mutex_lock(&master->mutex);
+    if (master->pending && (status == E_MODBUS_OK || status == E_MODBUS_EXCEPTION)) {
+        status = e_modbus_parse_response(master->pending, rsp, rsp_len, master->values, &master->exception);
+    }
+    master->result = status;
+    pthread_cond_broadcast(&master->cond);
+    pthread_mutex_unlock(&master->mutex);
+}
+
+/* 提交一个请求并等待总线事务完成，返回解析结果 */
+static e_modbus_status_t transact(e_modbus_master_t *master, const e_modbus_request_t *req) {
+    uint8_t frame[MODBUS_RTU_MAX_ADU];
+    int len = e_modbus_build_request(req, NULL, frame, sizeof(frame));
+    if (len < 0) {
+        pthread_mutex_lock(&master->mutex);
+        master->stats.errors++;
+        pthread_mutex_unlock(&master->mutex);
+        return E_MODBUS_MISMATCH;
+    }
+
+    pthread_mutex_lock(&master->mutex);
+    master->pending = req;
+    master->result = E_MODBUS_INCOMPLETE;
+    master->stats.requests++;
+    pthread_mutex_unlock(&master->mutex);
+
+    uint64_t start = monotonic_us();
+    if (e_bus_submit(master->bus, master->requester, frame, len, on_bus_done, master) < 0) {
+        pthread_mutex_lock(&master->mutex);
+        master->pending = NULL;
+        master->stats.errors++;
+        pthread_mutex_unlock(&master->mutex);
+        return E_MODBUS_TIMEOUT;
+    }
+
+    // 超时由总线判定，这里只等待事务结束或主站停止
+    pthread_mutex_lock(&master->mutex);
+    while (master->result == E_MODBUS_INCOMPLETE && master->running) {
+        pthread_cond_wait(&master->cond, &master->mutex);
+    }
+
+    e_modbus_status_t status = master->result;
+    master->pending = NULL;
+    switch (status) {
+        case E_MODBUS_OK: {
+            uint64_t rtt = monotonic_us() - start;
+            master->stats.responses++;
+            master->stats.rtt_last_us = rtt;
+            if (rtt > master->stats.rtt_max_us) master->stats.rtt_max_us = rtt;
+            break;
+        }
+        case E_MODBUS_INCOMPLETE:
+        case E_MODBUS_TIMEOUT:
+            status = E_MODBUS_TIMEOUT;
+            master->stats.timeouts++;
+            break;
+        case E_MODBUS_EXCEPTION:
+            master->stats.exceptions++;
+            break;
+        default:
+            master->stats.errors++;
+            break;
+    }
+    pthread_mutex_unlock(&master->mutex);
+    return status;
+}
+
+static void *master_thread_func(void *arg) {
+    e_modbus_master_t *master = (e_modbus_master_t *)arg;
+
+    pthread_mutex_lock(&master->mutex);
+    e_scheduler_start(master->sched, monotonic_us());
+    pthread_mutex_unlock(&master->mutex);
+
+    while (master->running) {
+        // 选出已到期且截止时间最早的扫描块
+        uint64_t now = monotonic_us();
+        uint64_t wait = 0;
+        pthread_mutex_lock(&master->mutex);
+        int next = e_scheduler_next(master->sched, now, &wait);
+        if (next < 0) {
+            struct timespec ts;
+            us_to_timespec(now + wait, &ts);
+            if (master->running) {
+                pthread_cond_timedwait(&master->cond, &master->mutex, &ts);
+            }
+            pthread_mutex_unlock(&master->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&master->mutex);
+
+        const e_modbus_scan_t *scan = &master->scan[next];
+        e_modbus_status_t status = transact(master, &scan->req);
+        if (!master->running) break;
+
+        pthread_mutex_lock(&master->mutex);
+        e_scheduler_complete(master->sched, next, now, monotonic_us());
+        pthread_mutex_unlock(&master->mutex);
+
+        if (master->cb) {
+            master->cb(master->arg, &scan->req, status, master->exception, master->values);
+        }
+    }
+    return NULL;
+}
+
+/* 按扫描表建立调度任务，占用时间由线路时间、t3.5 间隔和发送间隔估算 */
+static e_scheduler_t *master_create_scheduler(const serial_config_t *ser, const e_modbus_scan_t *scan, int count) {
+    e_scheduler_t *sched = e_scheduler_create(count);
+    if (!sched) return NULL;
+
+    uint64_t turnaround = (uint64_t)ser->min_delay_ms * 1000ULL;
+    for (int i = 0; i < count; i++) {
+        // 读请求帧固定 8 字节
+        uint64_t cost = e_scheduler_bus_time_us(ser, 8, e_modbus_response_length(&scan[i].req), turnaround);
+        e_scheduler_add(sched, (uint64_t)scan[i].period_ms * 1000ULL, (uint64_t)scan[i].deadline_ms * 1000ULL, cost);
+    }
+
+    e_scheduler_stats_t stats;
+    e_scheduler_get_stats(sched, 0, &stats);
+    if (stats.demand > 1.0) {
+        fprintf(stderr, "[%s] Scan list needs %.0f%% of the bus, deadlines will be missed\n",
+                ser->uid, stats.demand * 100);
+    }
+    return sched;
+}
+
+e_modbus_master_t *e_modbus_master_create(e_bus_t *bus, const serial_config_t *config,
+                                          e_modbus_data_cb cb, void *arg) {
+    if (!bus || !config || !config->uid || config->scan_count <= 0) return NULL;
+
+    e_modbus_master_t *master = calloc(1, sizeof(e_modbus_master_t));
+    if (!master) {
+        perror("Failed to allocate modbus master");
+        return NULL;
+    }
+
+    master->bus = bus;
+    master->requester = e_bus_add_requester(bus, "scan");
+    master->ser = *config;
+    master->ser.uid = strdup(config->uid);
+    master->ser.device = NULL;
+    master->ser.scan = NULL;
+    master->scan_count = config->scan_count;
+    master->scan = malloc(sizeof(e_modbus_scan_t) * config->scan_count);
+    if (master->scan) {
+        memcpy(master->scan, config->scan, sizeof(e_modbus_scan_t) * config->scan_count);
+        master->sched = master_create_scheduler(&master->ser, master->scan, master->scan_count);
+    }
+    if (master->requester < 0 || !master->ser.uid || !master->scan || !master->sched) {
+        free(master->ser.uid);
+        free(master->scan);
+        e_scheduler_destroy(master->sched);
+        free(master);
+        return NULL;
+    }
+    master->cb = cb;
+    master->arg = arg;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&master->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&master->mutex, NULL);
+    return master;
+}
+
+int e_modbus_master_start(e_modbus_master_t *master) {
+    if (!master || master->running) return -1;
+
+    master->running = 1;
+    if (pthread_create(&master->tid, NULL, master_thread_func, master) != 0) {
+        perror("Failed to create modbus master thread");
+        master->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void e_modbus_master_stop(e_modbus_master_t *master) {
+    if (!master || !master->running) return;
+
+    pthread_mutex_lock(&master->mutex);
+    master->running = 0;
+    pthread_cond_broadcast(&master->cond);
+    pthread_mutex_unlock(&master->mutex);
+    pthread_join(master->tid, NULL);
+}
+
+void e_modbus_master_destroy(e_modbus_master_t *master) {
+    if (!master) return;
+
+    e_modbus_master_stop(master);
+    pthread_mutex_destroy(&master->mutex);
+    pthread_cond_destroy(&master->cond);
+    free(master->ser.uid);
+    free(master->scan);
+    e_scheduler_destroy(master->sched);
+    free(master);
+}
+
+void e_modbus_master_print_stats(e_modbus_master_t *master) {
+    if (!master) return;
+
+    pthread_mutex_lock(&master->mutex);
+    e_modbus_master_stats_t s = master->stats;
+    e_scheduler_stats_t sched;
+    e_scheduler_get_stats(master->sched, monotonic_us(), &sched);
+    pthread_mutex_unlock(&master->mutex);
+
+    printf("[%s] modbus: %d blocks, req %llu rsp %llu exc %llu timeout %llu err %llu, rtt last %llu us max %llu us\n",
+           master->ser.uid, master->scan_count,
+           (unsigned long long)s.requests, (unsigned long long)s.responses,
+           (unsigned long long)s.exceptions, (unsigned long long)s.timeouts,
+           (unsigned long long)s.errors, (unsigned long long)s.rtt_last_us,
+           (unsigned long long)s.rtt_max_us);
+    printf("[%s] schedule: demand %.1f%%, bus busy %.1f%%, runs %llu missed %llu skipped %llu, lateness max %llu us\n",
+           master->ser.uid, sched.demand * 100, sched.utilization * 100,
+           (unsigned long long)sched.runs, (unsigned long long)sched.missed,
+           (unsigned long long)sched.skipped, (unsigned long long)sched.lateness_max_us);
+}
@@ -0,0 +1,89 @@
+#ifndef E_MODBUS_MASTER_H
+#define E_MODBUS_MASTER_H
+
+#include "e_modbus.h"
+#include "e_bus.h"
+#include "e_scheduler.h"
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * @brief 轮询结果回调
+ * @param arg 用户数据
+ * @param req 本次请求
+ * @param status 解析结果
+ * @param exception 异常码（status 为 E_MODBUS_EXCEPTION 时有效）
+ * @param values 解码后的数据（status 为 E_MODBUS_OK 时有效）
+ */
+typedef void (*e_modbus_data_cb)(void *arg, const e_modbus_request_t *req, e_modbus_status_t status,
+                                 uint8_t exception, const uint16_t *values);
+
+/* 主站统计 */
+typedef struct {
+    uint64_t requests;          // 已发送请求数
+    uint64_t responses;         // 有效响应数
+    uint64_t exceptions;        // 异常响应数
+    uint64_t timeouts;          // 超时数
+    uint64_t errors;            // CRC/不匹配/发送失败数
+    uint64_t rtt_last_us;       // 最近一次请求到响应的耗时
+    uint64_t rtt_max_us;        // 最大耗时
+} e_modbus_master_stats_t;
+
+/* Modbus RTU 主站：按扫描表周期轮询一个串口，请求经总线事务层与其他请求方仲裁 */
+typedef struct {
+    e_bus_t *bus;               // 所属总线
+    int requester;              // 在总线上的请求方编号
+    serial_config_t ser;        // 串口参数（用于估算总线占用）
+    e_modbus_scan_t *scan;      // 扫描表
+    int scan_count;             // 扫描块数量
+    e_scheduler_t *sched;       // 按截止时间调度扫描块（受 mutex 保护）
+    e_modbus_data_cb cb;        // 轮询结果回调
+    void *arg;                  // 回调用户数据
+    pthread_t tid;              // 轮询线程
+    volatile int running;       // 运行标志
+    pthread_mutex_t mutex;      // 保护当前事务
+    pthread_cond_t cond;        // 事务完成/停止通知（CLOCK_MONOTONIC）
+    const e_modbus_request_t *pending; // 当前提交到总线的请求
+    e_modbus_status_t result;   // 当前事务结果，INCOMPLETE 表示尚未完成
+    uint8_t exception;          // 异常码
+    uint16_t values[MODBUS_MAX_READ_BITS]; // 解码结果
+    e_modbus_master_stats_t stats;
+} e_modbus_master_t;
+
+/**
+ * @brief 创建主站，在总线上注册名为 "scan" 的请求方，须在 e_bus_start 之前调用
+ * @param bus 总线
+ * @param config 串口配置（使用其中的 uid、串口参数和扫描表）
+ * @param cb 轮询结果回调，在轮询线程中调用
+ * @param arg 回调用户数据
+ * @return 主站句柄，失败返回NULL
+ */
+e_modbus_master_t *e_modbus_master_create(e_bus_t *bus, const serial_config_t *config,
+                                          e_modbus_data_cb cb, void *arg);
+
+/**
+ * @brief 启动轮询线程
+ * @param master 主站句柄
+ * @return 0成功，-1失败
+ */
+int e_modbus_master_start(e_modbus_master_t *master);
+
+/**
+ * @brief 停止轮询线程
+ * @param master 主站句柄
+ */
+void e_modbus_master_stop(e_modbus_master_t *master);
+
+/**
+ * @brief 销毁主站
+ * @param master 主站句柄
+ */
+void e_modbus_master_destroy(e_modbus_master_t *master);
+
+/**
+ * @brief 打印主站统计信息
+ * @param master 主站句柄
+ */
+void e_modbus_master_print_stats(e_modbus_master_t *master);
+
+#endif // E_MODBUS_MASTER_H
@@ -1,4 +1,6 @@
 #include "e_plugin_driver.h"
+#include "e_plugin_pipeline.h"
+#include "e_codec.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -7,16 +9,38 @@
 #include <lauxlib.h>
 #include <lualib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <fnmatch.h>
+#include <time.h>
 
 // 不放在头文件中，避免引用头文件需要加载lua库
 
 /**
- * @brief lua插件
+ * @brief lua状态，同一时刻只能被一个线程使用
  */
 typedef struct {
     lua_State *L;
     int north_ref;
     int south_ref;
+    int north_batch_ref;        // 可选的批量转换函数，LUA_NOREF 表示未注册
+    int south_batch_ref;
+    e_plugin_buf_t scratch;     // FFI 模式下非原地脚本遇到原地转换时的输入副本
+} lua_state_slot_t;
+
+/**
+ * @brief lua插件：由同一脚本加载的多个独立状态组成的状态池
+ */
+typedef struct {
+    lua_state_slot_t *states;
+    int count;
+    uint64_t busy;      // 占用位图，第 i 位为 1 表示 states[i] 已被取出（原子操作）
+    bool ffi;           // 转换函数按缓冲指针调用（注册表 ffi = true，需要 LuaJIT）
+    bool inplace;       // FFI 模式下脚本允许输入输出为同一缓冲（注册表 inplace = true）
 } lua_plugin_t;
 
 /**
@@ -24,14 +48,17 @@ typedef struct {
  */
 typedef struct {
     void *handle;
+    void **states;      // v3 插件的实例状态，首次被取出时由取出的线程创建，未填写 create_instance 时为 NULL
+    int count;
+    uint64_t busy;      // 占用位图，同 lua_plugin_t
 } elf_plugin_t;
 
 /**
- * @brief 插件上下文
+ * @brief 已加载的插件实例，热重载时整体替换
  */
-typedef struct e_plugin_context {
+typedef struct {
     e_plugin_type_t type;
-    e_plugin_driver_t driver;
+    e_plugin_driver_t driver;   // 插件填写的驱动
 
     /**
      * @brief 插件实现
@@ -39,9 +66,61 @@ typedef struct e_plugin_context {
     union {
         lua_plugin_t lua;
         elf_plugin_t elf;
+        e_plugin_pipeline_t *pipe;
     } impl;
+
+    char **identity;            // 插件声明为恒等变换的 uid 模式，对这些 uid 跳过转换
+    int identity_count;
+    bool disabled;              // 超出预算按 DISABLE 处理后停用，消息原样通过（原子访问）
+} plugin_instance_t;
+
+#define STATS_SHARDS        8       // 转换计数的分片数，各线程固定使用其中一片，避免争用同一缓存行
+
+/**
+ * @brief 一片转换与 lua 调用计数，独占缓存行
+ */
+typedef struct {
+    e_plugin_stats_t s;
+    uint64_t lua_calls;             // lua 调用计数，见 e_plugin_lua_stats
+    uint64_t lua_overruns;
+    uint64_t lua_timed;             // 计时的 lua 调用数
+    uint64_t lua_time_ns;           // 计时的 lua 调用的累计耗时
+    uint64_t lua_max_ns;
+} __attribute__((aligned(64))) stats_shard_t;
+
+/**
+ * @brief 插件上下文：对外的句柄，每次转换读取当前实例
+ *
+ * 读者按 epoch 的奇偶在 readers[] 的一侧计数，不加锁也不等待；重载时先发布新实例再翻转 epoch，
+ * 等旧一侧的计数归零（旧实例上的调用全部返回）后销毁旧实例。
+ */
+typedef struct e_plugin_context {
+    e_plugin_driver_t driver;       // e_plugin_load_driver 返回的驱动，v1 回调经适配层转换
+    plugin_instance_t *current;     // 当前实例（原子发布）
+    unsigned int epoch;             // 读者计数下标，每次重载加一
+    unsigned long readers[2];       // 两侧的读者计数
+    char *filename;                 // 插件文件名，重载默认使用
+    int pool_size;                  // lua 状态池大小
+    pthread_mutex_t reload_lock;    // 串行化重载
+    e_plugin_budget_t budget;       // lua 调用的 CPU 预算（各字段原子访问）
+    stats_shard_t stats[STATS_SHARDS];  // 转换与 lua 调用计数（原子访问），查询时求和
 } e_plugin_context_t;
 
+#define LUA_BUDGET_STEP     1000    // 预算检查的间隔（虚拟机指令数）
+
+/**
+ * @brief 一次受预算限制的lua调用，计数钩子通过线程变量访问
+ */
+typedef struct {
+    uint64_t start_ns;
+    uint64_t deadline_ns;       // 0 表示不限时
+    unsigned long steps;        // 剩余的检查次数，0 表示不限指令数
+    bool overrun;
+    bool timed;                 // 是否计时（限时或被抽样），否则 start_ns 无效
+} lua_budget_run_t;
+
+static __thread lua_budget_run_t *t_lua_run;
+
 /**
  * @brief 判断文件是否为elf文件
  * 
@@ -62,18 +141,29 @@ static bool file_is_elf(const char *filename) {
 }
 
 /**
- * @brief 调用lua引用
+ * @brief 判断文件是否为插件流水线配置（.json）
+ * 
+ * @param filename 文件名
+ * @return 是否为流水线配置
+ */
+static bool file_is_pipeline(const char *filename) {
+    size_t len = strlen(filename);
+    return len > 5 && strcmp(filename + len - 5, ".json") == 0;
+}
+
+/**
+ * @brief 调用lua引用，结果拷贝到输出缓冲
  * 
  * @param L lua状态
  * @param ref 引用
  * @param in_data 输入数据
  * @param in_size 输入数据大小
- * @param out_data 输出数据
- * @param out_size 输出数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败（脚本出错或未返回字符串）
  */
-static void call_lua_ref(lua_State *L, int ref,
-                         const void *in_data, size_t in_size,
-                         void **out_data, size_t *out_size) {
+static int call_lua_ref(lua_State *L, int ref,
+                        const void *in_data, size_t in_size,
+                        e_plugin_buf_t *out) {
     lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
     lua_pushlstring(L, (const char *)in_data, in_size);
     lua_pushinteger(L, in_size);
@@ -81,44 +171,280 @@ static void call_lua_ref(lua_State *L, int ref,
     if (lua_pcall(L, 2, 1, 0) != 0) {
         fprintf(stderr, "Lua error: %s\n", lua_tostring(L, -1));
         lua_pop(L, 1);
-        *out_data = NULL;
-        *out_size = 0;
-        return;
+        return -1;
     }
 
     size_t len = 0;
     const char *res = lua_tolstring(L, -1, &len);
-    if (!res) {
-        *out_data = NULL;
-        *out_size = 0;
+    if (!res || e_plugin_buf_reserve(out, len) != 0) {
         lua_pop(L, 1);
+        return -1;
+    }
+
+    memcpy(out->data, res, len);
+    out->len = len;
+    lua_pop(L, 1);
+    return 0;
+}
+
+/**
+ * @brief FFI 模式调用lua引用：传入输入/输出缓冲指针，脚本通过 ffi.cast 直接读写，不创建字符串
+ * 
+ * 脚本签名 fn(in, in_len, out, out_cap)，返回输出长度；大于 out_cap 表示所需容量（此时不得改写 out），
+ * 返回 nil 表示丢弃该消息。
+ * 
+ * @param L lua状态
+ * @param ref 引用
+ * @param in_data 输入数据（原地转换时与 out->data 相同）
+ * @param in_size 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int call_lua_ffi(lua_State *L, int ref,
+                        const void *in_data, size_t in_size,
+                        e_plugin_buf_t *out) {
+    int inplace = in_data && in_data == out->data;
+    if (e_plugin_buf_reserve(out, in_size) != 0) return -1;
+
+    for (int tries = 0; tries < 2; tries++) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+        lua_pushlightuserdata(L, (void *)in_data);
+        lua_pushinteger(L, in_size);
+        lua_pushlightuserdata(L, out->data);
+        lua_pushinteger(L, out->cap);
+
+        if (lua_pcall(L, 4, 1, 0) != 0) {
+            fprintf(stderr, "Lua error: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return -1;
+        }
+        if (!lua_isnumber(L, -1)) {
+            lua_pop(L, 1);
+            return -1;
+        }
+        lua_Integer n = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        if (n < 0) return -1;
+        if ((size_t)n <= out->cap) {
+            out->len = n;
+            return 0;
+        }
+        if (e_plugin_buf_reserve(out, n) != 0) return -1;
+        if (inplace) in_data = out->data;
+    }
+    return -1;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int g_stats_next_shard;
+static __thread int t_stats_shard = -1;
+static __thread uint32_t t_stats_rand;
+
+/**
+ * @brief 本线程使用的计数分片，首次调用时轮流分配
+ * 
+ * @param ctx 插件上下文
+ * @return 计数分片
+ */
+static stats_shard_t *stats_shard(e_plugin_context_t *ctx) {
+    if (t_stats_shard < 0) t_stats_shard = __atomic_fetch_add(&g_stats_next_shard, 1, __ATOMIC_RELAXED) % STATS_SHARDS;
+    return &ctx->stats[t_stats_shard];
+}
+
+/**
+ * @brief 单条转换是否计时，平均每 E_PLUGIN_STATS_SAMPLE 次一次
+ * 
+ * 用线程内的 xorshift 随机抽样，避免与交替的方向或流水线各级的调用顺序同步
+ */
+static bool stats_sample(void) {
+    uint32_t x = t_stats_rand ? t_stats_rand : (uint32_t)(uintptr_t)&t_stats_rand | 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    t_stats_rand = x;
+    return x % E_PLUGIN_STATS_SAMPLE == 0;
+}
+
+/**
+ * @brief 计数钩子：超出指令数或耗时后抛出错误中断脚本
+ * 
+ * @param L lua状态
+ * @param ar 调试信息
+ */
+static void lua_budget_hook(lua_State *L, lua_Debug *ar) {
+    (void)ar;
+    lua_budget_run_t *run = t_lua_run;
+    if (!run) return;
+
+    if (run->steps && --run->steps == 0) run->overrun = true;
+    if (run->deadline_ns && monotonic_ns() >= run->deadline_ns) run->overrun = true;
+    // 脚本用 pcall 捕获后继续执行时，之后每次检查都再次抛出
+    if (run->overrun) luaL_error(L, "plugin CPU budget exceeded");
+}
+
+/**
+ * @brief 开始一次lua调用：按上下文的预算设置计数钩子
+ * 
+ * @param ctx 插件上下文
+ * @param L lua状态
+ * @param run 本次调用
+ * @param scale 预算倍数（批量调用的消息数）
+ */
+static void lua_budget_begin(e_plugin_context_t *ctx, lua_State *L, lua_budget_run_t *run, size_t scale) {
+    unsigned long insn = __atomic_load_n(&ctx->budget.instructions, __ATOMIC_RELAXED);
+    unsigned long time_us = __atomic_load_n(&ctx->budget.time_us, __ATOMIC_RELAXED);
+
+    memset(run, 0, sizeof(*run));
+    // 只有限时或抽样时才读时钟
+    run->timed = time_us || stats_sample();
+    if (run->timed) run->start_ns = monotonic_ns();
+    if (!insn && !time_us) {
+        lua_sethook(L, NULL, 0, 0);
         return;
     }
 
-    *out_data = malloc(len);
-    memcpy(*out_data, res, len);
-    *out_size = len;
+    unsigned long step = LUA_BUDGET_STEP;
+    if (insn) {
+        unsigned long total = insn * scale;
+        if (total < step) step = total;
+        run->steps = (total + step - 1) / step;
+    }
+    if (time_us) run->deadline_ns = run->start_ns + (uint64_t)time_us * 1000ULL * scale;
+    t_lua_run = run;
+    lua_sethook(L, lua_budget_hook, LUA_MASKCOUNT, (int)step);
+}
+
+/**
+ * @brief 结束一次lua调用并计数
+ * 
+ * @param ctx 插件上下文
+ * @param run 本次调用
+ */
+static void lua_budget_end(e_plugin_context_t *ctx, lua_budget_run_t *run) {
+    t_lua_run = NULL;
+    stats_shard_t *shard = stats_shard(ctx);
+    __atomic_fetch_add(&shard->lua_calls, 1, __ATOMIC_RELAXED);
+    if (run->overrun) __atomic_fetch_add(&shard->lua_overruns, 1, __ATOMIC_RELAXED);
+    if (!run->timed) return;
+
+    uint64_t ns = monotonic_ns() - run->start_ns;
+    __atomic_fetch_add(&shard->lua_timed, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shard->lua_time_ns, ns, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&shard->lua_max_ns, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&shard->lua_max_ns, &max, ns, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief 在取出的lua状态上执行一次转换
+ * 
+ * @param lua lua插件
+ * @param slot lua状态
+ * @param north 是否北向
+ * @param in_data 输入数据
+ * @param in_size 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int lua_transform(lua_plugin_t *lua, lua_state_slot_t *slot, int north,
+                         const void *in_data, size_t in_size, e_plugin_buf_t *out) {
+    int ref = north ? slot->north_ref : slot->south_ref;
+    if (!lua->ffi) return call_lua_ref(slot->L, ref, in_data, in_size, out);
+
+    // 脚本未声明原地转换时，输入先拷贝到状态自带的缓冲
+    if (in_data && in_data == out->data && !lua->inplace) {
+        if (e_plugin_buf_reserve(&slot->scratch, in_size) != 0) return -1;
+        memcpy(slot->scratch.data, in_data, in_size);
+        in_data = slot->scratch.data;
+    }
+    return call_lua_ffi(slot->L, ref, in_data, in_size, out);
+}
+
+/**
+ * @brief 调用lua批量转换函数：fn(msgs, n)，msgs 为输入字符串数组，返回同样长度的结果数组（nil 表示丢弃）
+ * 
+ * @param L lua状态
+ * @param ref 引用
+ * @param in 输入数据数组
+ * @param in_len 输入数据大小数组
+ * @param out 输出缓冲数组
+ * @param status 每条消息的结果
+ * @param count 消息数
+ * @return 成功转换的消息数
+ */
+static size_t call_lua_batch(lua_State *L, int ref,
+                             const void *const *in, const size_t *in_len,
+                             e_plugin_buf_t *out, int *status, size_t count) {
+    for (size_t i = 0; i < count; i++) status[i] = -1;
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+    lua_createtable(L, (int)count, 0);
+    for (size_t i = 0; i < count; i++) {
+        lua_pushlstring(L, (const char *)in[i], in_len[i]);
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+    lua_pushinteger(L, count);
+
+    if (lua_pcall(L, 2, 1, 0) != 0) {
+        fprintf(stderr, "Lua error: %s\n", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return 0;
+    }
+    if (!lua_istable(L, -1)) {
+        fprintf(stderr, "Lua: batch transform did not return a table\n");
+        lua_pop(L, 1);
+        return 0;
+    }
+
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        lua_rawgeti(L, -1, (int)i + 1);
+        size_t len = 0;
+        const char *res = lua_tolstring(L, -1, &len);
+        if (res && e_plugin_buf_reserve(&out[i], len) == 0) {
+            memcpy(out[i].data, res, len);
+            out[i].len = len;
+            status[i] = 0;
+            ok++;
+        }
+        lua_pop(L, 1);
+    }
     lua_pop(L, 1);
+    return ok;
 }
 
 /**
- * @brief lua北向转换回调函数
+ * @brief v1 回调适配：通过 e_plugin_transform 转换，输出缓冲交给调用者释放
  * 
  * @param ctx 插件上下文
+ * @param dir 转换方向
  * @param in_data 输入数据
  * @param in_size 输入数据大小
  * @param out_data 输出数据
  * @param out_size 输出数据大小
  */
-static void lua_north_cb(void *ctx,
-                         const void *in_data, size_t in_size,
-                         void **out_data, size_t *out_size) {
-    e_plugin_context_t *plugin = (e_plugin_context_t *)ctx;
-    call_lua_ref(plugin->impl.lua.L, plugin->impl.lua.north_ref, in_data, in_size, out_data, out_size);
+static void compat_transform(void *ctx, e_plugin_dir_t dir,
+                             const void *in_data, size_t in_size,
+                             void **out_data, size_t *out_size) {
+    e_plugin_buf_t buf = {0};
+    if (e_plugin_transform((e_plugin_context_t *)ctx, dir, in_data, in_size, &buf) != 0) {
+        e_plugin_buf_free(&buf);
+        *out_data = NULL;
+        *out_size = 0;
+        return;
+    }
+    *out_data = buf.data;
+    *out_size = buf.len;
 }
 
 /**
- * @brief lua南向转换回调函数
+ * @brief 北向转换回调函数（v1 适配）
  * 
  * @param ctx 插件上下文
  * @param in_data 输入数据
@@ -126,91 +452,569 @@ static void lua_north_cb(void *ctx,
  * @param out_data 输出数据
  * @param out_size 输出数据大小
  */
-static void lua_south_cb(void *ctx,
-                         const void *in_data, size_t in_size,
-                         void **out_data, size_t *out_size) {
-    e_plugin_context_t *plugin = (e_plugin_context_t *)ctx;
-    call_lua_ref(plugin->impl.lua.L, plugin->impl.lua.south_ref, in_data, in_size, out_data, out_size);
+static void compat_north_cb(void *ctx,
+                            const void *in_data, size_t in_size,
+                            void **out_data, size_t *out_size) {
+    compat_transform(ctx, E_PLUGIN_NORTH, in_data, in_size, out_data, out_size);
 }
 
-e_plugin_context_t *e_plugin_load_from_lua_script(const char *filename) {
-    if (!filename) return NULL;
+/**
+ * @brief 南向转换回调函数（v1 适配）
+ * 
+ * @param ctx 插件上下文
+ * @param in_data 输入数据
+ * @param in_size 输入数据大小
+ * @param out_data 输出数据
+ * @param out_size 输出数据大小
+ */
+static void compat_south_cb(void *ctx,
+                            const void *in_data, size_t in_size,
+                            void **out_data, size_t *out_size) {
+    compat_transform(ctx, E_PLUGIN_SOUTH, in_data, in_size, out_data, out_size);
+}
 
-    e_plugin_context_t *ctx = calloc(1, sizeof(*ctx));
-    ctx->type = PLUGIN_NONE;
-    ctx->impl.lua.L = luaL_newstate();
-    luaL_openlibs(ctx->impl.lua.L);
+/**
+ * @brief 取得注册表中可选函数的引用
+ * 
+ * @param L lua状态（栈顶为注册表）
+ * @param name 字段名
+ * @return 引用，不是函数时返回 LUA_NOREF
+ */
+static int lua_optional_ref(lua_State *L, const char *name) {
+    lua_getfield(L, -1, name);
+    if (!lua_isfunction(L, -1)) {
+        lua_pop(L, 1);
+        return LUA_NOREF;
+    }
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
 
-    if (luaL_dofile(ctx->impl.lua.L, filename) != 0) {
-        fprintf(stderr, "Failed to load Lua script: %s\n", lua_tostring(ctx->impl.lua.L, -1));
-        lua_close(ctx->impl.lua.L);
-        free(ctx);
+/**
+ * @brief 追加一个恒等 uid 模式
+ * 
+ * @param list 模式数组
+ * @param count 模式数
+ * @param pattern uid 模式（fnmatch）
+ * @return 0成功，-1失败
+ */
+static int identity_add(char ***list, int *count, const char *pattern) {
+    char **grown = realloc(*list, (*count + 1) * sizeof(char *));
+    if (!grown) return -1;
+    *list = grown;
+    if (!(grown[*count] = strdup(pattern))) return -1;
+    (*count)++;
+    return 0;
+}
+
+/**
+ * @brief 释放恒等 uid 模式
+ * 
+ * @param list 模式数组
+ * @param count 模式数
+ */
+static void identity_free(char **list, int count) {
+    for (int i = 0; i < count; i++) free(list[i]);
+    free(list);
+}
+
+/**
+ * @brief 读取注册表中的 identity 字段（uid 模式数组）
+ * 
+ * @param L lua状态（栈顶为注册表）
+ * @param list 模式数组
+ * @param count 模式数
+ */
+static void lua_read_identity(lua_State *L, char ***list, int *count) {
+    lua_getfield(L, -1, "identity");
+    if (lua_istable(L, -1)) {
+        int n = (int)lua_objlen(L, -1);
+        for (int i = 1; i <= n; i++) {
+            lua_rawgeti(L, -1, i);
+            const char *pattern = lua_tostring(L, -1);
+            if (pattern) identity_add(list, count, pattern);
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);
+}
+
+#define LUA_CACHE_ENV       "EZMB_PLUGIN_CACHE_DIR"     // 字节码缓存目录，未设置时缓存在脚本旁（<脚本>c）
+#define LUA_CACHE_MAGIC     "EZMBLUAC"
+#ifdef EZMB_WITH_LUAJIT
+#define LUA_CACHE_VM        "LuaJIT " LUA_RELEASE
+#else
+#define LUA_CACHE_VM        LUA_RELEASE
+#endif
+
+/**
+ * @brief 字节码缓存文件头，与脚本的内容哈希、大小、修改时间及虚拟机版本全部一致时缓存有效
+ */
+typedef struct {
+    char magic[8];
+    uint64_t hash;          // 脚本内容的 FNV-1a 哈希
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    char vm[32];
+} lua_cache_header_t;
+
+static uint64_t fnv1a64(const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief 读入文件描述符的全部剩余内容
+ * 
+ * @param fd 文件描述符
+ * @param buf 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int read_fd(int fd, e_plugin_buf_t *buf) {
+    buf->len = 0;
+    for (;;) {
+        if (e_plugin_buf_reserve(buf, buf->len + 4096) != 0) return -1;
+        ssize_t n = read(fd, (char *)buf->data + buf->len, buf->cap - buf->len);
+        if (n <= 0) return n == 0 ? 0 : -1;
+        buf->len += n;
+    }
+}
+
+/**
+ * @brief 字节码不经校验直接执行，只信任本进程有效用户所有、组和其他用户不可写的文件或目录
+ * 
+ * @param st 文件或目录的状态
+ * @return true 可信
+ */
+static bool lua_cache_trusted(const struct stat *st) {
+    return st->st_uid == geteuid() && !(st->st_mode & (S_IWGRP | S_IWOTH));
+}
+
+/**
+ * @brief 读入整个文件
+ * 
+ * @param filename 文件名
+ * @param buf 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int read_file(const char *filename, e_plugin_buf_t *buf) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    int ret = read_fd(fd, buf);
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief 字节码缓存文件路径：缓存目录下的 <脚本名>.<路径哈希>.luac，或脚本旁的 <脚本>c
+ * 
+ * @param filename 脚本文件名
+ * @return 路径（调用者 free），NULL 失败
+ */
+static char *lua_cache_path(const char *filename) {
+    const char *dir = getenv(LUA_CACHE_ENV);
+    struct stat st;
+    if (dir && *dir && (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || !lua_cache_trusted(&st))) {
+        // 其他用户可写的目录（如 /tmp）中的缓存可能被替换，不使用缓存
+        fprintf(stderr, "Lua bytecode cache disabled: %s is not a directory writable only by its owner\n", dir);
         return NULL;
     }
+    if (!dir || !*dir) {
+        size_t len = strlen(filename);
+        char *path = malloc(len + 2);
+        if (path) snprintf(path, len + 2, "%sc", filename);
+        return path;
+    }
+
+    // 不同目录下的同名脚本使用不同的缓存文件
+    char *real = realpath(filename, NULL);
+    const char *name = real ? real : filename;
+    const char *base = strrchr(filename, '/');
+    base = base ? base + 1 : filename;
+    size_t len = strlen(dir) + strlen(base) + 32;
+    char *path = malloc(len);
+    if (path) snprintf(path, len, "%s/%s.%08x.luac", dir, base, (unsigned int)fnv1a64(name, strlen(name)));
+    free(real);
+    return path;
+}
+
+/**
+ * @brief 读取有效的字节码缓存
+ * 
+ * @param path 缓存文件路径
+ * @param key 期望的文件头
+ * @param chunk 输出字节码
+ * @return 0成功，-1缓存不存在或已失效
+ */
+static int lua_cache_read(const char *path, const lua_cache_header_t *key, e_plugin_buf_t *chunk) {
+    chunk->len = 0;
+    int fd = open(path, O_RDONLY | O_NOFOLLOW);
+    if (fd < 0) return -1;
+
+    // 其他用户创建或可修改的缓存不可信，按失效处理，重新编译后覆盖
+    struct stat st;
+    int ret = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && lua_cache_trusted(&st) ? read_fd(fd, chunk) : -1;
+    close(fd);
+    if (ret != 0 || chunk->len <= sizeof(*key) || memcmp(chunk->data, key, sizeof(*key)) != 0) {
+        chunk->len = 0;
+        return -1;
+    }
+    chunk->len -= sizeof(*key);
+    memmove(chunk->data, (char *)chunk->data + sizeof(*key), chunk->len);
+    return 0;
+}
+
+/**
+ * @brief 写入字节码缓存：先写临时文件再改名，并发启动的进程不会读到写了一半的缓存
+ * 
+ * @param path 缓存文件路径
+ * @param key 文件头
+ * @param chunk 字节码
+ */
+static void lua_cache_write(const char *path, const lua_cache_header_t *key, const e_plugin_buf_t *chunk) {
+    size_t len = strlen(path);
+    char *tmp = malloc(len + 8);
+    if (!tmp) return;
+    snprintf(tmp, len + 8, "%s.XXXXXX", path);
+
+    int fd = mkstemp(tmp);
+    if (fd < 0) {
+        // 目录不可写时只是不缓存
+        free(tmp);
+        return;
+    }
+    // 只有所有者可读写，见 lua_cache_trusted
+    fchmod(fd, S_IRUSR | S_IWUSR);
+    int ok = write(fd, key, sizeof(*key)) == (ssize_t)sizeof(*key) &&
+             write(fd, chunk->data, chunk->len) == (ssize_t)chunk->len;
+    if (close(fd) != 0) ok = 0;
+    if (!ok || rename(tmp, path) != 0) {
+        fprintf(stderr, "Failed to write Lua bytecode cache %s\n", path);
+        unlink(tmp);
+    }
+    free(tmp);
+}
+
+static int lua_chunk_writer(lua_State *L, const void *p, size_t sz, void *ud) {
+    (void)L;
+    e_plugin_buf_t *chunk = (e_plugin_buf_t *)ud;
+    if (e_plugin_buf_reserve(chunk, chunk->len + sz) != 0) return 1;
+    memcpy((char *)chunk->data + chunk->len, p, sz);
+    chunk->len += sz;
+    return 0;
+}
+
+/**
+ * @brief 取得脚本的字节码：缓存有效时直接读取，否则编译脚本并写入缓存
+ * 
+ * 同一实例的各状态从这份字节码加载，脚本只解析一次；缓存无法写入时不影响加载。
+ * 
+ * @param filename 脚本文件名
+ * @param chunk 输出字节码
+ * @return 0成功，-1失败（脚本无法读取或有语法错误）
+ */
+static int lua_chunk_load(const char *filename, e_plugin_buf_t *chunk) {
+    struct stat st;
+    e_plugin_buf_t src = {0};
+    if (stat(filename, &st) != 0 || read_file(filename, &src) != 0) {
+        fprintf(stderr, "Failed to load Lua script: cannot read %s\n", filename);
+        e_plugin_buf_free(&src);
+        return -1;
+    }
+
+    lua_cache_header_t key;
+    memset(&key, 0, sizeof(key));
+    memcpy(key.magic, LUA_CACHE_MAGIC, sizeof(key.magic));
+    key.hash = fnv1a64(src.data, src.len);
+    key.size = src.len;
+    key.mtime_sec = st.st_mtim.tv_sec;
+    key.mtime_nsec = st.st_mtim.tv_nsec;
+    snprintf(key.vm, sizeof(key.vm), "%s", LUA_CACHE_VM);
+
+    lua_State *L = luaL_newstate();
+    if (!L) {
+        fprintf(stderr, "Failed to create Lua state\n");
+        e_plugin_buf_free(&src);
+        return -1;
+    }
+
+    int ret = 0;
+    char *path = lua_cache_path(filename);
+    // 缓存由其他版本的虚拟机生成时加载失败，重新编译
+    if (!path || lua_cache_read(path, &key, chunk) != 0 || luaL_loadbuffer(L, chunk->data, chunk->len, filename) != 0) {
+        lua_settop(L, 0);
+        chunk->len = 0;
+        // 与 luaL_loadfile 一样跳过首行的 #!，保留换行使行号不变
+        char *text = (char *)src.data;
+        if (src.len > 0 && text[0] == '#') {
+            for (size_t i = 0; i < src.len && text[i] != '\n'; i++) text[i] = ' ';
+        }
+
+        const char *name = lua_pushfstring(L, "@%s", filename);
+        if (luaL_loadbuffer(L, src.data, src.len, name) != 0) {
+            fprintf(stderr, "Failed to load Lua script: %s\n", lua_tostring(L, -1));
+            ret = -1;
+        } else if (lua_dump(L, lua_chunk_writer, chunk) != 0) {
+            fprintf(stderr, "Failed to dump Lua bytecode: %s\n", filename);
+            ret = -1;
+        } else if (path) {
+            lua_cache_write(path, &key, chunk);
+        }
+    }
 
-    lua_getglobal(ctx->impl.lua.L, "register_plugin");
-    if (!lua_isfunction(ctx->impl.lua.L, -1)) {
+    lua_close(L);
+    free(path);
+    e_plugin_buf_free(&src);
+    return ret;
+}
+
+/**
+ * @brief 加载脚本到一个新的lua状态，并取得北向/南向转换函数引用与调用方式
+ * 
+ * @param inst 插件实例，第一个状态加载时同时读取 identity
+ * @param slot lua状态
+ * @param filename 脚本文件名
+ * @param chunk 脚本的字节码，见 lua_chunk_load
+ * @return 0成功，-1失败（失败时状态已关闭）
+ */
+static int lua_state_load(plugin_instance_t *inst, lua_state_slot_t *slot, const char *filename, const e_plugin_buf_t *chunk) {
+    lua_plugin_t *lua = &inst->impl.lua;
+    lua_State *L = luaL_newstate();
+    if (!L) {
+        fprintf(stderr, "Failed to create Lua state\n");
+        return -1;
+    }
+    luaL_openlibs(L);
+
+    // 预置 require "ezmb.codec"
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "preload");
+    lua_pushcfunction(L, luaopen_ezmb_codec);
+    lua_setfield(L, -2, "ezmb.codec");
+    lua_pop(L, 2);
+
+    if (luaL_loadbuffer(L, chunk->data, chunk->len, filename) != 0 || lua_pcall(L, 0, 0, 0) != 0) {
+        fprintf(stderr, "Failed to load Lua script: %s\n", lua_tostring(L, -1));
+        lua_close(L);
+        return -1;
+    }
+
+    lua_getglobal(L, "register_plugin");
+    if (!lua_isfunction(L, -1)) {
         fprintf(stderr, "register_plugin not found in Lua script\n");
-        lua_close(ctx->impl.lua.L);
-        free(ctx);
-        return NULL;
+        lua_close(L);
+        return -1;
     }
 
-    lua_newtable(ctx->impl.lua.L); 
+    lua_newtable(L); 
 
-    if (lua_pcall(ctx->impl.lua.L, 1, 1, 0) != 0) {
-        fprintf(stderr, "register_plugin() error: %s\n", lua_tostring(ctx->impl.lua.L, -1));
-        lua_close(ctx->impl.lua.L);
-        free(ctx);
-        return NULL;
+    if (lua_pcall(L, 1, 1, 0) != 0) {
+        fprintf(stderr, "register_plugin() error: %s\n", lua_tostring(L, -1));
+        lua_close(L);
+        return -1;
     }
 
-    if (!lua_istable(ctx->impl.lua.L, -1)) {
+    if (!lua_istable(L, -1)) {
         fprintf(stderr, "register_plugin() did not return a table\n");
-        lua_close(ctx->impl.lua.L);
-        free(ctx);
-        return NULL;
+        lua_close(L);
+        return -1;
     }
 
-    lua_getfield(ctx->impl.lua.L, -1, "north_transform");
-    if (!lua_isfunction(ctx->impl.lua.L, -1)) {
-        lua_pop(ctx->impl.lua.L, 2); 
+    lua_getfield(L, -1, "north_transform");
+    if (!lua_isfunction(L, -1)) {
         fprintf(stderr, "Lua: north_transform not function\n");
-        lua_close(ctx->impl.lua.L);
-        free(ctx);
-        return NULL;
+        lua_close(L);
+        return -1;
     }
-    ctx->impl.lua.north_ref = luaL_ref(ctx->impl.lua.L, LUA_REGISTRYINDEX); 
+    slot->north_ref = luaL_ref(L, LUA_REGISTRYINDEX); 
 
-    lua_getfield(ctx->impl.lua.L, -1, "south_transform");
-    if (!lua_isfunction(ctx->impl.lua.L, -1)) {
-        lua_pop(ctx->impl.lua.L, 1); 
+    lua_getfield(L, -1, "south_transform");
+    if (!lua_isfunction(L, -1)) {
         fprintf(stderr, "Lua: south_transform not function\n");
-        lua_close(ctx->impl.lua.L);
-        free(ctx);
+        lua_close(L);
+        return -1;
+    }
+    slot->south_ref = luaL_ref(L, LUA_REGISTRYINDEX); 
+
+    slot->north_batch_ref = lua_optional_ref(L, "north_transform_batch");
+    slot->south_batch_ref = lua_optional_ref(L, "south_transform_batch");
+    if (slot == &lua->states[0]) lua_read_identity(L, &inst->identity, &inst->identity_count);
+
+    lua_getfield(L, -1, "ffi");
+    bool ffi = lua_toboolean(L, -1);
+    lua_getfield(L, -2, "inplace");
+    bool inplace = lua_toboolean(L, -1);
+    lua_pop(L, 3);
+#ifndef EZMB_WITH_LUAJIT
+    if (ffi) {
+        fprintf(stderr, "Lua: ffi plugins require a LuaJIT build (EZMB_WITH_LUAJIT)\n");
+        lua_close(L);
+        return -1;
+    }
+#endif
+
+    slot->L = L;
+    lua->ffi = ffi;
+    lua->inplace = inplace;
+    return 0;
+}
+
+/**
+ * @brief 销毁插件实例
+ * 
+ * @param inst 插件实例
+ */
+static void instance_destroy(plugin_instance_t *inst) {
+    if (!inst) return;
+
+    if (inst->type == PLUGIN_LUA) {
+        for (int i = 0; i < inst->impl.lua.count; i++) {
+            lua_close(inst->impl.lua.states[i].L);
+            e_plugin_buf_free(&inst->impl.lua.states[i].scratch);
+        }
+        free(inst->impl.lua.states);
+    }
+
+    if (inst->type == PLUGIN_ELF && inst->impl.elf.states) {
+        for (int i = 0; i < inst->impl.elf.count; i++) {
+            if (inst->impl.elf.states[i] && inst->driver.destroy_instance) {
+                inst->driver.destroy_instance(inst->impl.elf.states[i]);
+            }
+        }
+        free(inst->impl.elf.states);
+    }
+
+    if (inst->type == PLUGIN_ELF && inst->impl.elf.handle) {
+        dlclose(inst->impl.elf.handle);
+    }
+
+    if (inst->type == PLUGIN_PIPELINE) {
+        e_plugin_pipeline_destroy(inst->impl.pipe);
+    }
+
+    identity_free(inst->identity, inst->identity_count);
+    free(inst);
+}
+
+/**
+ * @brief 从lua脚本加载包含 pool_size 个状态的插件实例
+ * 
+ * @param filename 插件文件名
+ * @param pool_size 状态数
+ * @return 插件实例
+ */
+static plugin_instance_t *load_lua_instance(const char *filename, int pool_size) {
+    plugin_instance_t *inst = calloc(1, sizeof(*inst));
+    if (!inst) return NULL;
+    inst->type = PLUGIN_NONE;
+    inst->impl.lua.states = calloc(pool_size, sizeof(lua_state_slot_t));
+    e_plugin_buf_t chunk = {0};
+    if (!inst->impl.lua.states || lua_chunk_load(filename, &chunk) != 0) {
+        e_plugin_buf_free(&chunk);
+        free(inst->impl.lua.states);
+        free(inst);
         return NULL;
     }
-    ctx->impl.lua.south_ref = luaL_ref(ctx->impl.lua.L, LUA_REGISTRYINDEX); 
 
-    lua_pop(ctx->impl.lua.L, 1);
+    for (int i = 0; i < pool_size; i++) {
+        if (lua_state_load(inst, &inst->impl.lua.states[i], filename, &chunk) != 0) {
+            for (int j = 0; j < i; j++) lua_close(inst->impl.lua.states[j].L);
+            e_plugin_buf_free(&chunk);
+            free(inst->impl.lua.states);
+            identity_free(inst->identity, inst->identity_count);
+            free(inst);
+            return NULL;
+        }
+    }
+    e_plugin_buf_free(&chunk);
+    inst->impl.lua.count = pool_size;
 
-    ctx->driver.north_transform = lua_north_cb;
-    ctx->driver.south_transform = lua_south_cb;
-    ctx->type = PLUGIN_LUA;
+    // 字符串模式的输入先压入lua栈，总是可以原地转换
+    if (!inst->impl.lua.ffi || inst->impl.lua.inplace) inst->driver.flags |= E_PLUGIN_F_INPLACE;
+    inst->type = PLUGIN_LUA;
 
-    return ctx;
+    return inst;
 }
 
+/**
+ * @brief 经临时副本打开 .so
+ * 
+ * 同一路径已被打开时 dlopen 返回已有句柄，重载替换后的新文件需要换一个路径加载
+ * 
+ * @param filename 插件文件名
+ * @return dlopen 句柄，失败返回NULL
+ */
+static void *elf_open_copy(const char *filename) {
+    char tmp[] = "/tmp/ezmb-plugin-XXXXXX";
+    int in = open(filename, O_RDONLY);
+    if (in < 0) {
+        perror("Failed to open plugin");
+        return NULL;
+    }
+    int out = mkstemp(tmp);
+    if (out < 0) {
+        perror("Failed to create plugin copy");
+        close(in);
+        return NULL;
+    }
 
+    char buf[4096];
+    ssize_t n;
+    int ok = 1;
+    while ((n = read(in, buf, sizeof(buf))) > 0) {
+        if (write(out, buf, n) != n) {
+            ok = 0;
+            break;
+        }
+    }
+    if (n < 0) ok = 0;
+    close(in);
+    close(out);
 
-e_plugin_context_t *e_plugin_load_from_elf(const char *filename) {
-    if (!filename) return NULL;
+    void *handle = ok ? dlopen(tmp, RTLD_NOW) : NULL;
+    if (ok && !handle) fprintf(stderr, "Failed to load .so plugin: %s\n", dlerror());
+    unlink(tmp);
+    return handle;
+}
 
-    e_plugin_context_t *ctx = calloc(1, sizeof(*ctx));
-    ctx->type = PLUGIN_NONE;
-    void *handle = dlopen(filename, RTLD_NOW);
+/**
+ * @brief 从.so文件加载插件实例
+ * 
+ * 同一路径已被加载（重载，或流水线中多处引用）时加载临时副本，各实例拥有独立的代码与全局变量
+ * 
+ * @param filename 插件文件名
+ * @param pool_size 实例状态数（v3 插件填写了 create_instance 时）
+ * @return 插件实例
+ */
+static plugin_instance_t *load_elf_instance(const char *filename, int pool_size) {
+    plugin_instance_t *inst = calloc(1, sizeof(*inst));
+    if (!inst) return NULL;
+    inst->type = PLUGIN_NONE;
+    void *handle = dlopen(filename, RTLD_NOW | RTLD_NOLOAD);
+    if (handle) {
+        dlclose(handle);
+        handle = elf_open_copy(filename);
+    } else {
+        handle = dlopen(filename, RTLD_NOW);
+        if (!handle) fprintf(stderr, "Failed to load .so plugin: %s\n", dlerror());
+    }
     if (!handle) {
-        fprintf(stderr, "Failed to load .so plugin: %s\n", dlerror());
+        free(inst);
+        return NULL;
+    }
+
+    // 未导出 plugin_abi_version 的为 v1 插件
+    const unsigned int *abi = (const unsigned int *)dlsym(handle, "plugin_abi_version");
+    unsigned int version = abi ? *abi : 1;
+    if (version < 1 || version > E_PLUGIN_ABI_VERSION) {
+        fprintf(stderr, "Unsupported plugin ABI version %u (host %d)\n", version, E_PLUGIN_ABI_VERSION);
+        dlclose(handle);
+        instance_destroy(inst);
         return NULL;
     }
 
@@ -219,45 +1023,253 @@ e_plugin_context_t *e_plugin_load_from_elf(const char *filename) {
     if (!reg) {
         fprintf(stderr, "No register_plugin found: %s\n", dlerror());
         dlclose(handle);
-        e_plugin_destroy(ctx);
+        instance_destroy(inst);
         return NULL;
     }
 
-    if (reg(&ctx->driver) != 0) {
+    if (reg(&inst->driver) != 0) {
         fprintf(stderr, "register_plugin failed.\n");
         dlclose(handle);
-        e_plugin_destroy(ctx);
+        instance_destroy(inst);
         return NULL;
     }
 
-    ctx->impl.elf.handle = handle;
-    ctx->type = PLUGIN_ELF;
+    if (version >= 2) {
+        if (!inst->driver.north || !inst->driver.south) {
+            fprintf(stderr, "register_plugin did not set north/south\n");
+            dlclose(handle);
+            instance_destroy(inst);
+            return NULL;
+        }
+    } else {
+        inst->driver.north = NULL;
+        inst->driver.south = NULL;
+        inst->driver.flags = 0;
+        inst->driver.north_batch = NULL;
+        inst->driver.south_batch = NULL;
+    }
+    // 低版本插件的驱动结构中没有这两个字段
+    if (version < 3) {
+        inst->driver.create_instance = NULL;
+        inst->driver.destroy_instance = NULL;
+    }
+    if (inst->driver.create_instance) {
+        inst->impl.elf.states = calloc(pool_size, sizeof(void *));
+        if (!inst->impl.elf.states) {
+            dlclose(handle);
+            instance_destroy(inst);
+            return NULL;
+        }
+        inst->impl.elf.count = pool_size;
+    }
+
+    // 可选导出 const char *const plugin_identity[] = { "uid 模式", ..., NULL };
+    const char *const *ids = (const char *const *)dlsym(handle, "plugin_identity");
+    for (int i = 0; ids && ids[i]; i++) identity_add(&inst->identity, &inst->identity_count, ids[i]);
+
+    inst->impl.elf.handle = handle;
+    inst->type = PLUGIN_ELF;
+    return inst;
+}
+
+/**
+ * @brief 按文件类型加载插件实例
+ * 
+ * @param filename 插件文件名
+ * @param pool_size lua状态数
+ * @return 插件实例
+ */
+static plugin_instance_t *load_instance(const char *filename, int pool_size) {
+    // elf 插件的转换函数可重入，只有 v3 插件的实例状态使用状态池
+    if (file_is_elf(filename)) {
+        return load_elf_instance(filename, pool_size);
+    }
+    if (file_is_pipeline(filename)) {
+        plugin_instance_t *inst = calloc(1, sizeof(*inst));
+        if (!inst) return NULL;
+        if (!(inst->impl.pipe = e_plugin_pipeline_load(filename, pool_size))) {
+            free(inst);
+            return NULL;
+        }
+        inst->type = PLUGIN_PIPELINE;
+        return inst;
+    }
+    return load_lua_instance(filename, pool_size);
+}
+
+/**
+ * @brief 判断实例是否声明对 uid 为恒等变换
+ * 
+ * @param inst 插件实例
+ * @param uid 设备uid
+ * @return 是否跳过转换
+ */
+static bool instance_is_identity(plugin_instance_t *inst, const char *uid) {
+    if (!uid) return false;
+    for (int i = 0; i < inst->identity_count; i++) {
+        if (fnmatch(inst->identity[i], uid, 0) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 恒等变换：输入拷贝到输出缓冲
+ * 
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int copy_through(const void *in, size_t in_len, e_plugin_buf_t *out) {
+    if (in && in == out->data) {
+        out->len = in_len;
+        return 0;
+    }
+    if (e_plugin_buf_reserve(out, in_len) != 0) return -1;
+    if (in_len > 0) memcpy(out->data, in, in_len);
+    out->len = in_len;
+    return 0;
+}
+
+/**
+ * @brief 用已加载的实例创建插件上下文，失败时销毁实例
+ * 
+ * @param inst 插件实例
+ * @param filename 插件文件名
+ * @param pool_size lua状态数
+ * @return 插件上下文
+ */
+static e_plugin_context_t *context_create(plugin_instance_t *inst, const char *filename, int pool_size) {
+    if (!inst) return NULL;
+
+    // 计数分片按缓存行对齐
+    e_plugin_context_t *ctx = NULL;
+    if (posix_memalign((void **)&ctx, 64, sizeof(*ctx)) != 0) ctx = NULL;
+    if (ctx) memset(ctx, 0, sizeof(*ctx));
+    if (!ctx || !(ctx->filename = strdup(filename))) {
+        free(ctx);
+        instance_destroy(inst);
+        return NULL;
+    }
+    // 通过 e_plugin_load_driver 调用 v1 回调的使用者由适配层转换，不受重载影响
+    ctx->driver.north_transform = compat_north_cb;
+    ctx->driver.south_transform = compat_south_cb;
+    ctx->driver.flags = inst->driver.flags;
+    ctx->current = inst;
+    ctx->pool_size = pool_size;
+    pthread_mutex_init(&ctx->reload_lock, NULL);
     return ctx;
 }
 
+/**
+ * @brief 进入读侧，返回当前实例
+ * 
+ * @param ctx 插件上下文
+ * @param side 读者计数的一侧，退出时传给 read_unlock
+ * @return 当前实例
+ */
+static plugin_instance_t *read_lock(e_plugin_context_t *ctx, unsigned int *side) {
+    for (;;) {
+        unsigned int i = __atomic_load_n(&ctx->epoch, __ATOMIC_SEQ_CST) & 1;
+        __atomic_fetch_add(&ctx->readers[i], 1, __ATOMIC_SEQ_CST);
+        // 计数期间 epoch 被翻转则重试，保证计数落在重载等待的一侧
+        if ((__atomic_load_n(&ctx->epoch, __ATOMIC_SEQ_CST) & 1) == i) {
+            *side = i;
+            return __atomic_load_n(&ctx->current, __ATOMIC_SEQ_CST);
+        }
+        __atomic_fetch_sub(&ctx->readers[i], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * @brief 退出读侧
+ * 
+ * @param ctx 插件上下文
+ * @param side read_lock 返回的一侧
+ */
+static void read_unlock(e_plugin_context_t *ctx, unsigned int side) {
+    __atomic_fetch_sub(&ctx->readers[side], 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 读取上下文的预算
+ * 
+ * @param ctx 插件上下文
+ * @param budget 输出预算
+ */
+static void budget_load(e_plugin_context_t *ctx, e_plugin_budget_t *budget) {
+    budget->instructions = __atomic_load_n(&ctx->budget.instructions, __ATOMIC_RELAXED);
+    budget->time_us = __atomic_load_n(&ctx->budget.time_us, __ATOMIC_RELAXED);
+    budget->on_overrun = __atomic_load_n(&ctx->budget.on_overrun, __ATOMIC_RELAXED);
+}
+
+e_plugin_context_t *e_plugin_load_from_lua_script(const char *filename) {
+    if (!filename) return NULL;
+    return context_create(load_lua_instance(filename, 1), filename, 1);
+}
+
+e_plugin_context_t *e_plugin_load_from_elf(const char *filename) {
+    if (!filename) return NULL;
+    return context_create(load_elf_instance(filename, 1), filename, 1);
+}
+
 e_plugin_context_t *e_plugin_create(const char *filename) {
+    return e_plugin_create_ex(filename, 1);
+}
+
+e_plugin_context_t *e_plugin_create_ex(const char *filename, int pool_size) {
     if (!filename) return NULL;
-    e_plugin_context_t *ctx = calloc(1, sizeof(*ctx));
-    ctx->type = PLUGIN_NONE;
-    if (file_is_elf(filename)) {
-        ctx = e_plugin_load_from_elf(filename);
-    } else {
-        ctx = e_plugin_load_from_lua_script(filename);
+    if (pool_size < 1 || pool_size > E_PLUGIN_POOL_MAX) {
+        fprintf(stderr, "Invalid plugin pool size %d (1-%d)\n", pool_size, E_PLUGIN_POOL_MAX);
+        return NULL;
     }
-    return ctx;
+    return context_create(load_instance(filename, pool_size), filename, pool_size);
 }
 
-void e_plugin_destroy(e_plugin_context_t *ctx) {
-    if (!ctx) return;
+int e_plugin_reload(e_plugin_context_t *ctx, const char *filename) {
+    if (!ctx) return -1;
+
+    pthread_mutex_lock(&ctx->reload_lock);
+    const char *path = filename ? filename : ctx->filename;
+    plugin_instance_t *old = ctx->current;
 
-    if (ctx->type == PLUGIN_LUA && ctx->impl.lua.L) {
-        lua_close(ctx->impl.lua.L);
+    // 新实例在调用者线程中加载并校验，期间转换继续使用旧实例
+    plugin_instance_t *inst = load_instance(path, ctx->pool_size);
+    char *name = inst ? strdup(path) : NULL;
+    if (!inst || !name) {
+        fprintf(stderr, "Failed to reload plugin %s, keeping current one\n", path);
+        instance_destroy(inst);
+        pthread_mutex_unlock(&ctx->reload_lock);
+        return -1;
     }
+    free(ctx->filename);
+    ctx->filename = name;
+    if (inst->type == PLUGIN_PIPELINE) {
+        e_plugin_budget_t budget;
+        budget_load(ctx, &budget);
+        e_plugin_pipeline_set_budget(inst->impl.pipe, &budget);
+    }
+
+    __atomic_store_n(&ctx->driver.flags, inst->driver.flags, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->current, inst, __ATOMIC_SEQ_CST);
+    unsigned int side = __atomic_fetch_add(&ctx->epoch, 1, __ATOMIC_SEQ_CST) & 1;
 
-    if (ctx->type == PLUGIN_ELF && ctx->impl.elf.handle) {
-        dlclose(ctx->impl.elf.handle);
+    // 之后进入的调用都落在另一侧并使用新实例，等待旧一侧的调用返回
+    while (__atomic_load_n(&ctx->readers[side], __ATOMIC_SEQ_CST) != 0) {
+        usleep(100);
     }
+    instance_destroy(old);
 
+    pthread_mutex_unlock(&ctx->reload_lock);
+    return 0;
+}
+
+void e_plugin_destroy(e_plugin_context_t *ctx) {
+    if (!ctx) return;
+
+    instance_destroy(ctx->current);
+    pthread_mutex_destroy(&ctx->reload_lock);
+    free(ctx->filename);
     free(ctx);
 }
 
@@ -268,5 +1280,596 @@ e_plugin_driver_t *e_plugin_load_driver(e_plugin_context_t *ctx) {
 
 e_plugin_type_t e_plugin_type(e_plugin_context_t *ctx) {
     if (!ctx) return PLUGIN_NONE;
-    return ctx->type;
-}
\ No newline at end of file
+
+    unsigned int side;
+    plugin_instance_t *inst = read_lock(ctx, &side);
+    e_plugin_type_t type = inst->type;
+    read_unlock(ctx, side);
+    return type;
+}
+
+int e_plugin_set_budget(e_plugin_context_t *ctx, const e_plugin_budget_t *budget) {
+    if (!ctx) return -1;
+
+    e_plugin_budget_t b = {0};
+    if (budget) b = *budget;
+    __atomic_store_n(&ctx->budget.instructions, b.instructions, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->budget.time_us, b.time_us, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->budget.on_overrun, b.on_overrun, __ATOMIC_RELAXED);
+
+    // 流水线的各级是独立的上下文，预算逐级下发；持有重载锁期间当前实例不会被替换
+    pthread_mutex_lock(&ctx->reload_lock);
+    if (ctx->current->type == PLUGIN_PIPELINE) e_plugin_pipeline_set_budget(ctx->current->impl.pipe, &b);
+    pthread_mutex_unlock(&ctx->reload_lock);
+    return 0;
+}
+
+int e_plugin_budget_parse(const char *spec, e_plugin_budget_t *budget) {
+    if (!spec || !budget) return -1;
+
+    char *end;
+    memset(budget, 0, sizeof(*budget));
+    budget->time_us = strtoul(spec, &end, 10);
+    if (end == spec) return -1;
+    if (*end == ',') {
+        const char *p = end + 1;
+        budget->instructions = strtoul(p, &end, 10);
+        if (end == p) return -1;
+    }
+    if (*end == ':') {
+        end++;
+        if (strcmp(end, "drop") == 0) {
+            budget->on_overrun = E_PLUGIN_OVERRUN_DROP;
+        } else if (strcmp(end, "pass") == 0) {
+            budget->on_overrun = E_PLUGIN_OVERRUN_PASS;
+        } else if (strcmp(end, "disable") == 0) {
+            budget->on_overrun = E_PLUGIN_OVERRUN_DISABLE;
+        } else {
+            return -1;
+        }
+    } else if (*end != '\0') {
+        return -1;
+    }
+    return 0;
+}
+
+int e_plugin_lua_stats(e_plugin_context_t *ctx, e_plugin_lua_stats_t *stats) {
+    if (!ctx || !stats) return -1;
+
+    uint64_t timed = 0, time_ns = 0, max_ns = 0;
+    memset(stats, 0, sizeof(*stats));
+    for (int k = 0; k < STATS_SHARDS; k++) {
+        const stats_shard_t *shard = &ctx->stats[k];
+        stats->calls += __atomic_load_n(&shard->lua_calls, __ATOMIC_RELAXED);
+        stats->overruns += __atomic_load_n(&shard->lua_overruns, __ATOMIC_RELAXED);
+        timed += __atomic_load_n(&shard->lua_timed, __ATOMIC_RELAXED);
+        time_ns += __atomic_load_n(&shard->lua_time_ns, __ATOMIC_RELAXED);
+        uint64_t ns = __atomic_load_n(&shard->lua_max_ns, __ATOMIC_RELAXED);
+        if (ns > max_ns) max_ns = ns;
+    }
+    // 未限时的调用抽样计时，累计耗时按计时调用的平均值推算
+    stats->time_us = timed ? time_ns / timed * stats->calls / 1000 : 0;
+    stats->max_us = max_ns / 1000;
+
+    unsigned int side;
+    plugin_instance_t *inst = read_lock(ctx, &side);
+    stats->disabled = __atomic_load_n(&inst->disabled, __ATOMIC_RELAXED);
+    if (inst->type == PLUGIN_PIPELINE) e_plugin_pipeline_lua_stats(inst->impl.pipe, stats);
+    read_unlock(ctx, side);
+    return 0;
+}
+
+int e_plugin_stats(e_plugin_context_t *ctx, e_plugin_stats_t *stats) {
+    if (!ctx || !stats) return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    for (int k = 0; k < STATS_SHARDS; k++) {
+        for (int d = 0; d < 2; d++) {
+            const e_plugin_dir_stats_t *src = &ctx->stats[k].s.dir[d];
+            e_plugin_dir_stats_t *dst = &stats->dir[d];
+            dst->calls += __atomic_load_n(&src->calls, __ATOMIC_RELAXED);
+            dst->errors += __atomic_load_n(&src->errors, __ATOMIC_RELAXED);
+            dst->bytes_in += __atomic_load_n(&src->bytes_in, __ATOMIC_RELAXED);
+            dst->bytes_out += __atomic_load_n(&src->bytes_out, __ATOMIC_RELAXED);
+            dst->samples += __atomic_load_n(&src->samples, __ATOMIC_RELAXED);
+            dst->time_ns += __atomic_load_n(&src->time_ns, __ATOMIC_RELAXED);
+            for (int b = 0; b < E_PLUGIN_HIST_BUCKETS; b++) {
+                dst->hist[b] += __atomic_load_n(&src->hist[b], __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return 0;
+}
+
+uint64_t e_plugin_stats_percentile(const e_plugin_dir_stats_t *stats, double p) {
+    if (!stats || stats->samples == 0) return 0;
+
+    uint64_t rank = (uint64_t)(p * stats->samples);
+    uint64_t seen = 0;
+    for (int b = 0; b < E_PLUGIN_HIST_BUCKETS; b++) {
+        seen += stats->hist[b];
+        if (seen > rank) return 1ULL << b;
+    }
+    return 1ULL << (E_PLUGIN_HIST_BUCKETS - 1);
+}
+
+void e_plugin_print_stats(e_plugin_context_t *ctx) {
+    if (!ctx) return;
+
+    static const char *const dir_names[2] = { "north", "south" };
+    e_plugin_stats_t st;
+    e_plugin_lua_stats_t lua;
+    e_plugin_stats(ctx, &st);
+    e_plugin_lua_stats(ctx, &lua);
+
+    // 持有重载锁，文件名与当前实例在打印期间不会被替换
+    pthread_mutex_lock(&ctx->reload_lock);
+    for (int d = 0; d < 2; d++) {
+        const e_plugin_dir_stats_t *s = &st.dir[d];
+        if (s->calls == 0) continue;
+        printf("[%s] %s: calls %llu err %llu, in %llu B out %llu B, avg %llu us p50 <%llu us p99 <%llu us\n",
+               ctx->filename, dir_names[d], (unsigned long long)s->calls, (unsigned long long)s->errors,
+               (unsigned long long)s->bytes_in, (unsigned long long)s->bytes_out,
+               (unsigned long long)(s->samples ? s->time_ns / s->samples / 1000 : 0),
+               (unsigned long long)e_plugin_stats_percentile(s, 0.5),
+               (unsigned long long)e_plugin_stats_percentile(s, 0.99));
+    }
+    if (ctx->current->type == PLUGIN_LUA) {
+        printf("[%s] lua: calls %llu overruns %llu, time %llu ms, max %llu us%s\n",
+               ctx->filename, (unsigned long long)lua.calls, (unsigned long long)lua.overruns,
+               (unsigned long long)(lua.time_us / 1000), (unsigned long long)lua.max_us,
+               lua.disabled ? ", disabled" : "");
+    }
+    if (ctx->current->type == PLUGIN_PIPELINE) e_plugin_pipeline_print_stats(ctx->current->impl.pipe);
+    pthread_mutex_unlock(&ctx->reload_lock);
+}
+
+int e_plugin_buf_reserve(e_plugin_buf_t *buf, size_t size) {
+    if (!buf) return -1;
+    if (size <= buf->cap) return 0;
+
+    size_t cap = buf->cap ? buf->cap : 64;
+    while (cap < size) cap *= 2;
+    void *data = realloc(buf->data, cap);
+    if (!data) {
+        perror("Failed to grow plugin buffer");
+        return -1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+void e_plugin_buf_free(e_plugin_buf_t *buf) {
+    if (!buf) return;
+    free(buf->data);
+    buf->data = NULL;
+    buf->cap = 0;
+    buf->len = 0;
+}
+
+/* 线程上次使用的状态序号，优先取回同一个状态以保持缓存局部性 */
+static __thread int t_pool_hint;
+
+/**
+ * @brief 无锁从状态池取出一个空闲状态，全部被占用时让出CPU后重试
+ * 
+ * @param busy_map 占用位图
+ * @param count 状态数
+ * @return 状态序号
+ */
+static int pool_checkout(uint64_t *busy_map, int count) {
+    uint64_t all = count == 64 ? ~0ULL : (1ULL << count) - 1;
+    uint64_t busy = __atomic_load_n(busy_map, __ATOMIC_RELAXED);
+    for (;;) {
+        uint64_t idle = ~busy & all;
+        if (!idle) {
+            sched_yield();
+            busy = __atomic_load_n(busy_map, __ATOMIC_RELAXED);
+            continue;
+        }
+        int hint = t_pool_hint < count ? t_pool_hint : 0;
+        int i = (idle >> hint) & 1 ? hint : __builtin_ctzll(idle);
+        // 失败时 busy 被更新为当前值
+        if (__atomic_compare_exchange_n(busy_map, &busy, busy | (1ULL << i), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            t_pool_hint = i;
+            return i;
+        }
+    }
+}
+
+/**
+ * @brief 归还状态
+ * 
+ * @param busy_map 占用位图
+ * @param i 状态序号
+ */
+static void pool_checkin(uint64_t *busy_map, int i) {
+    __atomic_fetch_and(busy_map, ~(1ULL << i), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 取出一个lua状态
+ */
+static int lua_checkout(lua_plugin_t *lua) {
+    return pool_checkout(&lua->busy, lua->count);
+}
+
+/**
+ * @brief 归还lua状态
+ */
+static void lua_checkin(lua_plugin_t *lua, int i) {
+    pool_checkin(&lua->busy, i);
+}
+
+/**
+ * @brief 取出 v3 elf 插件的一个实例状态，首次取出时在当前线程中创建
+ * 
+ * @param elf elf插件
+ * @param driver 插件驱动
+ * @param state 输出实例状态
+ * @return 状态序号，-1 创建失败（已归还）
+ */
+static int elf_checkout(elf_plugin_t *elf, const e_plugin_driver_t *driver, void **state) {
+    int i = pool_checkout(&elf->busy, elf->count);
+    if (!elf->states[i] && !(elf->states[i] = driver->create_instance())) {
+        fprintf(stderr, "Plugin create_instance failed\n");
+        pool_checkin(&elf->busy, i);
+        return -1;
+    }
+    *state = elf->states[i];
+    return i;
+}
+
+/**
+ * @brief 记录一次转换
+ * 
+ * @param ctx 插件上下文
+ * @param dir 转换方向
+ * @param msgs 消息数
+ * @param errors 失败的消息数
+ * @param bytes_in 输入字节数
+ * @param bytes_out 输出字节数
+ * @param timed 是否计时
+ * @param elapsed_ns 耗时（timed 为 true 时有效）
+ */
+static void stats_record(e_plugin_context_t *ctx, e_plugin_dir_t dir, size_t msgs, size_t errors,
+                         uint64_t bytes_in, uint64_t bytes_out, bool timed, uint64_t elapsed_ns) {
+    e_plugin_dir_stats_t *st = &stats_shard(ctx)->s.dir[dir == E_PLUGIN_NORTH ? 0 : 1];
+    __atomic_fetch_add(&st->calls, msgs, __ATOMIC_RELAXED);
+    if (errors) __atomic_fetch_add(&st->errors, errors, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&st->bytes_in, bytes_in, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&st->bytes_out, bytes_out, __ATOMIC_RELAXED);
+    if (!timed || msgs == 0) return;
+
+    uint64_t us = elapsed_ns / msgs / 1000;
+    int bucket = us ? 64 - __builtin_clzll(us) : 0;
+    if (bucket >= E_PLUGIN_HIST_BUCKETS) bucket = E_PLUGIN_HIST_BUCKETS - 1;
+    __atomic_fetch_add(&st->samples, msgs, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&st->time_ns, elapsed_ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&st->hist[bucket], msgs, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 按预算的处理方式处理超出预算的消息
+ * 
+ * @param ctx 插件上下文
+ * @param inst 插件实例
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @return 0原样输出，-1丢弃
+ */
+static int lua_overrun(e_plugin_context_t *ctx, plugin_instance_t *inst,
+                       const void *in, size_t in_len, e_plugin_buf_t *out) {
+    switch (__atomic_load_n(&ctx->budget.on_overrun, __ATOMIC_RELAXED)) {
+        case E_PLUGIN_OVERRUN_PASS:
+            return copy_through(in, in_len, out);
+        case E_PLUGIN_OVERRUN_DISABLE:
+            if (!__atomic_exchange_n(&inst->disabled, true, __ATOMIC_RELAXED)) {
+                fprintf(stderr, "Lua plugin exceeded its CPU budget, disabled until reload\n");
+            }
+            return -1;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief 在预算限制下执行一次lua转换
+ * 
+ * @param ctx 插件上下文
+ * @param inst 插件实例
+ * @param slot 取出的lua状态
+ * @param north 是否北向
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int lua_guarded_transform(e_plugin_context_t *ctx, plugin_instance_t *inst, lua_state_slot_t *slot, int north,
+                                 const void *in, size_t in_len, e_plugin_buf_t *out) {
+    lua_budget_run_t run;
+    lua_budget_begin(ctx, slot->L, &run, 1);
+    int ret = lua_transform(&inst->impl.lua, slot, north, in, in_len, out);
+    lua_budget_end(ctx, &run);
+    return run.overrun ? lua_overrun(ctx, inst, in, in_len, out) : ret;
+}
+
+/**
+ * @brief 调用 v2 转换，容量不足时扩容并重试一次
+ * 
+ * @param ud 传给插件的 ctx：插件上下文，或 v3 插件的实例状态
+ * @param inst 插件实例
+ * @param fn 转换函数
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int call_transform_fn(void *ud, plugin_instance_t *inst, e_plugin_transform_fn fn,
+                             const void *in, size_t in_len, e_plugin_buf_t *out) {
+    int inplace = in && in == out->data;
+    if (inplace && !(inst->driver.flags & E_PLUGIN_F_INPLACE)) {
+        fprintf(stderr, "Plugin does not support in-place transform\n");
+        return -1;
+    }
+
+    for (int tries = 0; tries < 2; tries++) {
+        size_t len = 0;
+        int rc = fn(ud, in, in_len, out->data, out->cap, &len);
+        if (rc == E_PLUGIN_OK && len <= out->cap) {
+            out->len = len;
+            return 0;
+        }
+        if (rc != E_PLUGIN_NEED_SPACE || len <= out->cap) break;
+        if (e_plugin_buf_reserve(out, len) != 0) break;
+        // 扩容可能移动缓冲，原地转换的输入随之移动
+        if (inplace) in = out->data;
+    }
+    return -1;
+}
+
+/**
+ * @brief 在指定实例上转换一条消息
+ * 
+ * @param ctx 插件上下文
+ * @param inst 插件实例
+ * @param dir 转换方向
+ * @param uid 消息来源/去向的设备uid，可为NULL
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败
+ */
+static int instance_transform(e_plugin_context_t *ctx, plugin_instance_t *inst, e_plugin_dir_t dir, const char *uid,
+                              const void *in, size_t in_len, e_plugin_buf_t *out) {
+    if (instance_is_identity(inst, uid) || __atomic_load_n(&inst->disabled, __ATOMIC_RELAXED)) {
+        return copy_through(in, in_len, out);
+    }
+
+    int north = dir == E_PLUGIN_NORTH;
+    switch (inst->type) {
+        case PLUGIN_PIPELINE:
+            return e_plugin_pipeline_transform(inst->impl.pipe, dir, uid, in, in_len, out);
+        case PLUGIN_LUA: {
+            int i = lua_checkout(&inst->impl.lua);
+            lua_state_slot_t *slot = &inst->impl.lua.states[i];
+            int ret = lua_guarded_transform(ctx, inst, slot, north, in, in_len, out);
+            lua_checkin(&inst->impl.lua, i);
+            return ret;
+        }
+        case PLUGIN_ELF: {
+            e_plugin_transform_fn fn = north ? inst->driver.north : inst->driver.south;
+            if (fn && inst->impl.elf.states) {
+                void *state;
+                int i = elf_checkout(&inst->impl.elf, &inst->driver, &state);
+                if (i < 0) return -1;
+                int ret = call_transform_fn(state, inst, fn, in, in_len, out);
+                pool_checkin(&inst->impl.elf.busy, i);
+                return ret;
+            }
+            if (fn) return call_transform_fn(ctx, inst, fn, in, in_len, out);
+
+            // v1 插件自行分配输出，拷贝后释放
+            e_plugin_message_transform_callback cb = north ? inst->driver.north_transform : inst->driver.south_transform;
+            if (!cb) return -1;
+            void *data = NULL;
+            size_t len = 0;
+            cb(ctx, in, in_len, &data, &len);
+            int ret = -1;
+            if (data && e_plugin_buf_reserve(out, len) == 0) {
+                memcpy(out->data, data, len);
+                out->len = len;
+                ret = 0;
+            }
+            free(data);
+            return ret;
+        }
+        default:
+            return -1;
+    }
+}
+
+int e_plugin_transform(e_plugin_context_t *ctx, e_plugin_dir_t dir, const void *in, size_t in_len, e_plugin_buf_t *out) {
+    return e_plugin_transform_for(ctx, dir, NULL, in, in_len, out);
+}
+
+int e_plugin_transform_for(e_plugin_context_t *ctx, e_plugin_dir_t dir, const char *uid,
+                           const void *in, size_t in_len, e_plugin_buf_t *out) {
+    if (!ctx || !out || (!in && in_len > 0)) return -1;
+
+    bool timed = stats_sample();
+    uint64_t start = timed ? monotonic_ns() : 0;
+
+    unsigned int side;
+    plugin_instance_t *inst = read_lock(ctx, &side);
+    int ret = instance_transform(ctx, inst, dir, uid, in, in_len, out);
+    read_unlock(ctx, side);
+
+    stats_record(ctx, dir, 1, ret != 0, in_len, ret == 0 ? out->len : 0, timed, timed ? monotonic_ns() - start : 0);
+    return ret;
+}
+
+bool e_plugin_is_identity(e_plugin_context_t *ctx, const char *uid) {
+    if (!ctx || !uid) return false;
+
+    unsigned int side;
+    plugin_instance_t *inst = read_lock(ctx, &side);
+    bool identity = instance_is_identity(inst, uid);
+    read_unlock(ctx, side);
+    return identity;
+}
+
+/**
+ * @brief 调用 elf 批量转换，每次最多 E_PLUGIN_BATCH_MAX 条，容量不足的消息扩容后单条重试
+ * 
+ * @param ud 传给插件的 ctx：插件上下文，或 v3 插件的实例状态
+ * @param inst 插件实例
+ * @param bfn 批量转换函数
+ * @param fn 单条转换函数
+ * @param in 输入数据数组
+ * @param in_len 输入数据大小数组
+ * @param out 输出缓冲数组
+ * @param status 每条消息的结果
+ * @param count 消息数
+ * @return 成功转换的消息数
+ */
+static size_t call_batch_fn(void *ud, plugin_instance_t *inst, e_plugin_transform_batch_fn bfn, e_plugin_transform_fn fn,
+                            const void *const *in, const size_t *in_len,
+                            e_plugin_buf_t *out, int *status, size_t count) {
+    e_plugin_batch_item_t items[E_PLUGIN_BATCH_MAX];
+    size_t map[E_PLUGIN_BATCH_MAX];
+    size_t ok = 0;
+
+    for (size_t base = 0; base < count; base += E_PLUGIN_BATCH_MAX) {
+        size_t n = count - base < E_PLUGIN_BATCH_MAX ? count - base : E_PLUGIN_BATCH_MAX;
+        size_t m = 0;
+        for (size_t k = 0; k < n; k++) {
+            size_t i = base + k;
+            status[i] = -1;
+            if ((!in[i] && in_len[i] > 0) ||
+                (in[i] && in[i] == out[i].data && !(inst->driver.flags & E_PLUGIN_F_INPLACE))) {
+                continue;
+            }
+            items[m].in = in[i];
+            items[m].in_len = in_len[i];
+            items[m].out = out[i].data;
+            items[m].out_cap = out[i].cap;
+            items[m].out_len = 0;
+            items[m].status = E_PLUGIN_ERROR;
+            map[m++] = i;
+        }
+        if (m == 0) continue;
+
+        bfn(ud, items, m);
+
+        for (size_t k = 0; k < m; k++) {
+            size_t i = map[k];
+            if (items[k].status == E_PLUGIN_OK && items[k].out_len <= out[i].cap) {
+                out[i].len = items[k].out_len;
+                status[i] = 0;
+            } else if (items[k].status == E_PLUGIN_NEED_SPACE) {
+                status[i] = call_transform_fn(ud, inst, fn, in[i], in_len[i], &out[i]);
+            }
+            if (status[i] == 0) ok++;
+        }
+    }
+    return ok;
+}
+
+size_t e_plugin_transform_batch(e_plugin_context_t *ctx, e_plugin_dir_t dir, const void *const *in, const size_t *in_len,
+                                e_plugin_buf_t *out, int *status, size_t count) {
+    return e_plugin_transform_batch_for(ctx, dir, NULL, in, in_len, out, status, count);
+}
+
+/**
+ * @brief 在当前实例上批量转换，参见 e_plugin_transform_batch_for
+ */
+static size_t batch_transform(e_plugin_context_t *ctx, e_plugin_dir_t dir, const char *uid,
+                              const void *const *in, const size_t *in_len,
+                              e_plugin_buf_t *out, int *status, size_t count) {
+    int north = dir == E_PLUGIN_NORTH;
+    size_t ok = 0;
+    unsigned int side;
+    plugin_instance_t *inst = read_lock(ctx, &side);
+    // 恒等的 uid、已停用的插件与流水线逐条处理
+    bool bypass = instance_is_identity(inst, uid) || __atomic_load_n(&inst->disabled, __ATOMIC_RELAXED);
+    switch (bypass ? PLUGIN_NONE : inst->type) {
+        case PLUGIN_LUA: {
+            // 整批只取出一次状态
+            int k = lua_checkout(&inst->impl.lua);
+            lua_state_slot_t *slot = &inst->impl.lua.states[k];
+            int ref = north ? slot->north_batch_ref : slot->south_batch_ref;
+            if (!inst->impl.lua.ffi && ref != LUA_NOREF && count > 0) {
+                lua_budget_run_t run;
+                lua_budget_begin(ctx, slot->L, &run, count);
+                ok = call_lua_batch(slot->L, ref, in, in_len, out, status, count);
+                lua_budget_end(ctx, &run);
+                if (run.overrun) {
+                    // 超出预算时整批按同一方式处理
+                    ok = 0;
+                    for (size_t i = 0; i < count; i++) {
+                        status[i] = (!in[i] && in_len[i] > 0) ? -1 : lua_overrun(ctx, inst, in[i], in_len[i], &out[i]);
+                        if (status[i] == 0) ok++;
+                    }
+                }
+            } else {
+                for (size_t i = 0; i < count; i++) {
+                    status[i] = (!in[i] && in_len[i] > 0) ? -1 :
+                                lua_guarded_transform(ctx, inst, slot, north, in[i], in_len[i], &out[i]);
+                    if (status[i] == 0) ok++;
+                }
+            }
+            lua_checkin(&inst->impl.lua, k);
+            read_unlock(ctx, side);
+            return ok;
+        }
+        case PLUGIN_ELF: {
+            e_plugin_transform_batch_fn bfn = north ? inst->driver.north_batch : inst->driver.south_batch;
+            e_plugin_transform_fn fn = north ? inst->driver.north : inst->driver.south;
+            if (bfn && fn) {
+                // 整批只取出一次实例状态
+                void *ud = ctx;
+                int k = -1;
+                if (inst->impl.elf.states && (k = elf_checkout(&inst->impl.elf, &inst->driver, &ud)) < 0) {
+                    for (size_t i = 0; i < count; i++) status[i] = -1;
+                } else {
+                    ok = call_batch_fn(ud, inst, bfn, fn, in, in_len, out, status, count);
+                }
+                if (k >= 0) pool_checkin(&inst->impl.elf.busy, k);
+                read_unlock(ctx, side);
+                return ok;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        status[i] = (!in[i] && in_len[i] > 0) ? -1 : instance_transform(ctx, inst, dir, uid, in[i], in_len[i], &out[i]);
+        if (status[i] == 0) ok++;
+    }
+    read_unlock(ctx, side);
+    return ok;
+}
+
+size_t e_plugin_transform_batch_for(e_plugin_context_t *ctx, e_plugin_dir_t dir, const char *uid,
+                                    const void *const *in, const size_t *in_len,
+                                    e_plugin_buf_t *out, int *status, size_t count) {
+    if (!ctx || !in || !in_len || !out || !status) return 0;
+
+    uint64_t start = monotonic_ns();
+    size_t ok = batch_transform(ctx, dir, uid, in, in_len, out, status, count);
+    uint64_t elapsed = monotonic_ns() - start;
+
+    uint64_t bytes_in = 0, bytes_out = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes_in += in_len[i];
+        if (status[i] == 0) bytes_out += out[i].len;
+    }
+    stats_record(ctx, dir, count, count - ok, bytes_in, bytes_out, true, elapsed);
+    return ok;
+}
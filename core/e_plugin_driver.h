@@ -3,6 +3,24 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief 插件 ABI 版本
+ *
+ * v1: 只导出 register_plugin，填写 north_transform/south_transform，输出由插件 malloc、调用者 free
+ * v2: 另导出 plugin_abi_version（值为 E_PLUGIN_ABI_VERSION），填写 north/south，输出写入调用者提供的缓冲
+ * v3: 可另外填写 create_instance/destroy_instance，转换函数的 ctx 为调用线程独占的实例状态
+ */
+#define E_PLUGIN_ABI_VERSION    3
+
+/* 插件标志 */
+#define E_PLUGIN_F_INPLACE      0x01    // v2 转换允许 out 与 in 为同一缓冲（原地转换）
+
+#define E_PLUGIN_POOL_MAX       64      // lua 插件状态池（v3 elf 插件实例状态）的最大状态数
+#define E_PLUGIN_BATCH_MAX      64      // 一次调用 elf 批量转换的最大消息数
+#define E_PLUGIN_HIST_BUCKETS   20      // 转换延迟直方图的桶数
+#define E_PLUGIN_STATS_SAMPLE   8       // 单条转换平均每 8 次计时一次
 
 /**
  * @brief 插件类型
@@ -10,11 +28,13 @@
  * @param PLUGIN_NONE: 无类型
  * @param PLUGIN_LUA: lua脚本
  * @param PLUGIN_ELF: 动态链接库
+ * @param PLUGIN_PIPELINE: 插件流水线（.json 配置）
  */
 typedef enum {
     PLUGIN_NONE,
     PLUGIN_LUA,
-    PLUGIN_ELF
+    PLUGIN_ELF,
+    PLUGIN_PIPELINE
 } e_plugin_type_t;
 
 
@@ -35,17 +55,183 @@ typedef void (*e_plugin_message_transform_callback)(
     size_t *out_data_size
 );
 
+/**
+ * @brief v2 转换返回值
+ */
+typedef enum {
+    E_PLUGIN_ERROR = -1,        // 转换失败，丢弃该消息
+    E_PLUGIN_OK = 0,            // 成功，*out_len 为输出长度
+    E_PLUGIN_NEED_SPACE = 1,    // out_cap 不足，*out_len 为所需字节数，调用者扩容后重试（此时不得改写 out）
+} e_plugin_status_t;
+
+/**
+ * @brief v2 数据转换回调函数，输出写入调用者提供的缓冲，不分配内存
+ * 
+ * @param ctx 插件上下文；v3 插件填写了 create_instance 时为其返回的实例状态
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲（声明 E_PLUGIN_F_INPLACE 时可能与 in 相同）
+ * @param out_cap 输出缓冲容量
+ * @param out_len 输出数据大小，返回 E_PLUGIN_NEED_SPACE 时为所需容量
+ * @return e_plugin_status_t
+ */
+typedef int (*e_plugin_transform_fn)(
+    void *ctx,
+    const void *in,
+    size_t in_len,
+    void *out,
+    size_t out_cap,
+    size_t *out_len
+);
+
+/**
+ * @brief 批量转换中的一条消息
+ * 
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲（声明 E_PLUGIN_F_INPLACE 时可能与 in 相同）
+ * @param out_cap 输出缓冲容量
+ * @param out_len 输出数据大小，status 为 E_PLUGIN_NEED_SPACE 时为所需容量
+ * @param status 由插件填写 e_plugin_status_t
+ */
+typedef struct {
+    const void *in;
+    size_t in_len;
+    void *out;
+    size_t out_cap;
+    size_t out_len;
+    int status;
+} e_plugin_batch_item_t;
+
+/**
+ * @brief v2 批量数据转换回调函数（可选），一次转换 count 条消息
+ * 
+ * @param ctx 插件上下文；v3 插件填写了 create_instance 时为其返回的实例状态
+ * @param items 消息数组
+ * @param count 消息数（不超过 E_PLUGIN_BATCH_MAX）
+ */
+typedef void (*e_plugin_transform_batch_fn)(
+    void *ctx,
+    e_plugin_batch_item_t *items,
+    size_t count
+);
+
 /**
  * @brief 插件驱动
  * 
- * @param north_transform 北向转换回调函数
- * @param south_transform 南向转换回调函数
+ * @param north_transform 北向转换回调函数（v1）
+ * @param south_transform 南向转换回调函数（v1）
+ * @param north 北向转换回调函数（v2）
+ * @param south 南向转换回调函数（v2）
+ * @param flags 插件标志 E_PLUGIN_F_*
+ * @param north_batch 北向批量转换回调函数（v2，可选）
+ * @param south_batch 南向批量转换回调函数（v2，可选）
+ * @param create_instance 创建实例状态（v3，可选），返回 NULL 表示失败
+ * @param destroy_instance 销毁实例状态（v3，可选）
+ * 
+ * PS: 填写 create_instance 时，宿主为每个并发转换的线程（最多为状态池大小）在该线程中各创建一个实例状态，
+ *     同一时刻一个实例状态只被一个线程使用，插件可以在其中保存查找表、工作缓冲等而不加锁；
+ *     线程优先取回上次使用的实例状态，插件卸载或重载后销毁。
  */
 typedef struct {
     e_plugin_message_transform_callback north_transform;
     e_plugin_message_transform_callback south_transform;
+    e_plugin_transform_fn north;
+    e_plugin_transform_fn south;
+    unsigned int flags;
+    e_plugin_transform_batch_fn north_batch;
+    e_plugin_transform_batch_fn south_batch;
+    void *(*create_instance)(void);
+    void (*destroy_instance)(void *state);
 } e_plugin_driver_t;
 
+/**
+ * @brief 转换方向
+ */
+typedef enum {
+    E_PLUGIN_NORTH,
+    E_PLUGIN_SOUTH
+} e_plugin_dir_t;
+
+/**
+ * @brief 可复用的输出缓冲，容量只增不减，稳定后转换不再分配内存
+ */
+typedef struct {
+    void *data;
+    size_t cap;
+    size_t len;
+} e_plugin_buf_t;
+
+/**
+ * @brief lua 插件超出 CPU 预算时的处理
+ */
+typedef enum {
+    E_PLUGIN_OVERRUN_DROP = 0,      // 丢弃该消息
+    E_PLUGIN_OVERRUN_PASS,          // 原样输出未转换的输入
+    E_PLUGIN_OVERRUN_DISABLE,       // 丢弃该消息并停用插件，之后的消息原样通过，重载后恢复
+} e_plugin_overrun_t;
+
+/**
+ * @brief lua 插件每次调用的 CPU 预算，超出时中断脚本
+ * 
+ * @param instructions 虚拟机指令数上限，0 表示不限制
+ * @param time_us 耗时上限（微秒），0 表示不限制
+ * @param on_overrun 超出时的处理
+ */
+typedef struct {
+    unsigned long instructions;
+    unsigned long time_us;
+    e_plugin_overrun_t on_overrun;
+} e_plugin_budget_t;
+
+/**
+ * @brief lua 调用计数
+ * 
+ * @param calls 调用次数（批量调用计一次）
+ * @param overruns 超出预算的次数
+ * @param time_us 累计耗时，未设置时间预算的调用按 E_PLUGIN_STATS_SAMPLE 抽样计时后推算
+ * @param max_us 计时调用中的单次最长耗时
+ * @param disabled 当前实例已因超出预算停用
+ */
+typedef struct {
+    uint64_t calls;
+    uint64_t overruns;
+    uint64_t time_us;
+    uint64_t max_us;
+    bool disabled;
+} e_plugin_lua_stats_t;
+
+/**
+ * @brief 一个方向的转换计数
+ * 
+ * 延迟直方图按 2 的幂划分：hist[0] 为不足 1 us，hist[i] 为 [2^(i-1), 2^i) us，最后一桶包含更长的调用。
+ * 单条转换按 E_PLUGIN_STATS_SAMPLE 随机抽样计时，批量转换每批计时并按每条的平均耗时计入。
+ * 
+ * @param calls 转换的消息数
+ * @param errors 失败的消息数
+ * @param bytes_in 输入字节数
+ * @param bytes_out 成功转换的输出字节数
+ * @param samples 计入直方图的消息数
+ * @param time_ns 计入直方图的消息的累计耗时
+ * @param hist 延迟直方图
+ */
+typedef struct {
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t samples;
+    uint64_t time_ns;
+    uint64_t hist[E_PLUGIN_HIST_BUCKETS];
+} e_plugin_dir_stats_t;
+
+/**
+ * @brief 插件的转换计数，按 e_plugin_dir_t 索引
+ */
+typedef struct {
+    e_plugin_dir_stats_t dir[2];
+} e_plugin_stats_t;
+
 /**
  * @brief 插件上下文
  */
@@ -54,13 +240,39 @@ typedef struct e_plugin_context e_plugin_context_t;
 /**
  * @brief 创建插件上下文
  * 
- * @param filename 插件文件名 支持lua脚本和.so文件
+ * @param filename 插件文件名 支持lua脚本、.so文件和流水线配置（.json，见 e_plugin_pipeline.h）
  * @return 插件上下文
  */
 e_plugin_context_t *e_plugin_create(const char *filename);
 
 /**
- * @brief 销毁插件上下文
+ * @brief 创建插件上下文，lua 插件由同一脚本加载 pool_size 个独立状态
+ * 
+ * 每次 e_plugin_transform 无锁取出一个空闲状态（优先取回本线程上次使用的状态），
+ * 多个线程可并行转换；状态全部被占用时调用者让出CPU等待，pool_size 应不小于工作线程数。
+ * v3 elf 插件最多创建 pool_size 个实例状态，其他 elf 插件忽略 pool_size。
+ * 
+ * @param filename 插件文件名 支持lua脚本和.so文件
+ * @param pool_size lua状态数（1-E_PLUGIN_POOL_MAX）
+ * @return 插件上下文
+ */
+e_plugin_context_t *e_plugin_create_ex(const char *filename, int pool_size);
+
+/**
+ * @brief 热重载插件：加载并校验新的 lua 脚本或 .so，成功后原子替换当前插件
+ * 
+ * 新插件在调用者线程中加载，期间转换继续使用旧插件；替换后新进入的调用使用新插件，
+ * 旧插件上的调用全部返回后再销毁旧插件。转换不会等待重载，消息不会丢失。
+ * 加载失败时保留当前插件。lua 插件沿用创建时的状态池大小。
+ * 
+ * @param ctx 插件上下文
+ * @param filename 新插件文件名，NULL 表示重新加载当前文件
+ * @return 0成功，-1失败
+ */
+int e_plugin_reload(e_plugin_context_t *ctx, const char *filename);
+
+/**
+ * @brief 销毁插件上下文，调用前须确保没有正在进行的转换
  * 
  * @param ctx 插件上下文
  */
@@ -97,4 +309,153 @@ e_plugin_driver_t *e_plugin_load_driver(e_plugin_context_t *ctx);
  * @return 插件类型
  */
 e_plugin_type_t e_plugin_type(e_plugin_context_t *ctx);
+
+/**
+ * @brief 转换一条消息，结果写入 out（容量不足时自动扩容）
+ * 
+ * v2 插件与 lua 插件直接写入 out；v1 插件的输出拷贝到 out 后释放。
+ * 可在多个线程中并发调用（lua 插件各线程使用状态池中不同的状态）。
+ * in 可以指向 out->data（原地转换），v2 插件须声明 E_PLUGIN_F_INPLACE。
+ * 
+ * @param ctx 插件上下文
+ * @param dir 转换方向
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲，out->len 为输出长度
+ * @return 0成功，-1失败
+ */
+int e_plugin_transform(e_plugin_context_t *ctx, e_plugin_dir_t dir, const void *in, size_t in_len, e_plugin_buf_t *out);
+
+/**
+ * @brief 转换一条来自/发往设备 uid 的消息
+ * 
+ * 插件声明对 uid 为恒等变换时（lua 注册表 identity、.so 导出 plugin_identity，均为 fnmatch 模式）
+ * 跳过转换，输入原样写入 out；流水线按 uid 跳过声明为恒等的各级。
+ * 
+ * @param ctx 插件上下文
+ * @param dir 转换方向
+ * @param uid 设备uid，NULL 等同于 e_plugin_transform
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲，out->len 为输出长度
+ * @return 0成功，-1失败
+ */
+int e_plugin_transform_for(e_plugin_context_t *ctx, e_plugin_dir_t dir, const char *uid,
+                           const void *in, size_t in_len, e_plugin_buf_t *out);
+
+/**
+ * @brief 插件是否声明对 uid 为恒等变换
+ * 
+ * @param ctx 插件上下文
+ * @param uid 设备uid
+ * @return 是否跳过转换
+ */
+bool e_plugin_is_identity(e_plugin_context_t *ctx, const char *uid);
+
+/**
+ * @brief 批量转换 count 条消息，结果依次写入 out[i]
+ * 
+ * elf 插件提供 north_batch/south_batch 时每 E_PLUGIN_BATCH_MAX 条调用一次，容量不足的消息扩容后单条重试；
+ * lua 插件整批只取出一次状态，脚本注册了 north_transform_batch/south_transform_batch 时整批只进入一次脚本。
+ * 没有批量入口时逐条转换。in[i] 只能与 out[i].data 相同（原地转换），不能指向其他消息的输出缓冲。
+ * 
+ * @param ctx 插件上下文
+ * @param dir 转换方向
+ * @param in 输入数据数组
+ * @param in_len 输入数据大小数组
+ * @param out 输出缓冲数组
+ * @param status 每条消息的结果，0成功，-1失败
+ * @param count 消息数
+ * @return 成功转换的消息数
+ */
+size_t e_plugin_transform_batch(e_plugin_context_t *ctx, e_plugin_dir_t dir, const void *const *in, const size_t *in_len,
+                                e_plugin_buf_t *out, int *status, size_t count);
+
+/**
+ * @brief 批量转换来自/发往设备 uid 的消息，参见 e_plugin_transform_batch 与 e_plugin_transform_for
+ * 
+ * @param ctx 插件上下文
+ * @param dir 转换方向
+ * @param uid 设备uid，可为NULL
+ * @param in 输入数据数组
+ * @param in_len 输入数据大小数组
+ * @param out 输出缓冲数组
+ * @param status 每条消息的结果，0成功，-1失败
+ * @param count 消息数
+ * @return 成功转换的消息数
+ */
+size_t e_plugin_transform_batch_for(e_plugin_context_t *ctx, e_plugin_dir_t dir, const char *uid,
+                                    const void *const *in, const size_t *in_len,
+                                    e_plugin_buf_t *out, int *status, size_t count);
+
+/**
+ * @brief 设置 lua 插件的 CPU 预算，重载后保持；流水线中的各个 lua 插件分别按此预算限制
+ * 
+ * 每执行一段指令检查一次指令数与耗时，超出后中断脚本并按 on_overrun 处理；
+ * 批量调用的预算为单条预算乘以消息数。LuaJIT 编译后的代码不调用计数钩子，预算只能尽力保证。
+ * 
+ * @param ctx 插件上下文
+ * @param budget 预算，NULL 表示不限制
+ * @return 0成功，-1失败
+ */
+int e_plugin_set_budget(e_plugin_context_t *ctx, const e_plugin_budget_t *budget);
+
+/**
+ * @brief 解析预算描述：<time_us>[,<instructions>][:drop|pass|disable]，如 "5000:pass"、"0,1000000:disable"
+ * 
+ * @param spec 预算描述
+ * @param budget 输出预算
+ * @return 0成功，-1格式错误
+ */
+int e_plugin_budget_parse(const char *spec, e_plugin_budget_t *budget);
+
+/**
+ * @brief 取得 lua 调用计数，流水线为各级之和（重载后从零开始）
+ * 
+ * @param ctx 插件上下文
+ * @param stats 输出计数
+ * @return 0成功，-1失败
+ */
+int e_plugin_lua_stats(e_plugin_context_t *ctx, e_plugin_lua_stats_t *stats);
+
+/**
+ * @brief 取得转换计数（重载后累计）
+ * 
+ * @param ctx 插件上下文
+ * @param stats 输出计数
+ * @return 0成功，-1失败
+ */
+int e_plugin_stats(e_plugin_context_t *ctx, e_plugin_stats_t *stats);
+
+/**
+ * @brief 由延迟直方图估计分位数
+ * 
+ * @param stats 一个方向的计数
+ * @param p 分位（0-1，如 0.99）
+ * @return 分位数所在桶的上界（us），没有样本时为 0
+ */
+uint64_t e_plugin_stats_percentile(const e_plugin_dir_stats_t *stats, double p);
+
+/**
+ * @brief 打印转换计数与 lua 调用计数，流水线同时打印各级插件
+ * 
+ * @param ctx 插件上下文
+ */
+void e_plugin_print_stats(e_plugin_context_t *ctx);
+
+/**
+ * @brief 保证输出缓冲容量不小于 size
+ * 
+ * @param buf 输出缓冲
+ * @param size 所需容量
+ * @return 0成功，-1失败
+ */
+int e_plugin_buf_reserve(e_plugin_buf_t *buf, size_t size);
+
+/**
+ * @brief 释放输出缓冲
+ * 
+ * @param buf 输出缓冲
+ */
+void e_plugin_buf_free(e_plugin_buf_t *buf);
 #endif
@@ -0,0 +1,449 @@
+#include "e_plugin_pipeline.h"
+#include "e_codec.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fnmatch.h>
+#include <math.h>
+#include <pthread.h>
+#include <json-c/json.h>
+
+typedef enum {
+    CODEC_SWAP16,
+    CODEC_SWAP32,
+    CODEC_SWAP_WORDS,
+    CODEC_SCALE,
+    CODEC_BITS,
+    CODEC_HEX,
+    CODEC_UNHEX,
+    CODEC_BASE64,
+    CODEC_UNBASE64,
+} codec_op_t;
+
+static const char *const codec_names[] = {
+    "swap16", "swap32", "swap_words", "scale", "bits", "hex", "unhex", "base64", "unbase64",
+};
+
+/* 内置编解码级的参数 */
+typedef struct {
+    codec_op_t op;
+    e_codec_type_t type;    // scale
+    float scale;            // scale
+    float offset;           // scale
+    size_t start;           // bits
+    long count;             // bits，-1 表示到数据末尾
+    bool json;              // scale/bits 输出 JSON 数组文本
+} codec_stage_t;
+
+/* 流水线中的一级 */
+typedef struct {
+    e_plugin_context_t *plugin;     // NULL 表示内置编解码级
+    codec_stage_t codec;
+    char **identity;        // 配置中对该级声明为恒等变换的 uid 模式
+    int identity_count;
+} pipeline_stage_t;
+
+struct e_plugin_pipeline {
+    pipeline_stage_t *stages[2];    // 按 e_plugin_dir_t 索引
+    int count[2];
+};
+
+static pthread_key_t g_scratch_key;
+static pthread_once_t g_scratch_once = PTHREAD_ONCE_INIT;
+
+static void scratch_free(void *buf) {
+    e_plugin_buf_free((e_plugin_buf_t *)buf);
+    free(buf);
+}
+
+static void scratch_key_create(void) {
+    pthread_key_create(&g_scratch_key, scratch_free);
+}
+
+/* 线程内的暂存缓冲，与调用者的输出缓冲交替使用，线程退出时释放 */
+static e_plugin_buf_t *thread_scratch(void) {
+    pthread_once(&g_scratch_once, scratch_key_create);
+    e_plugin_buf_t *buf = pthread_getspecific(g_scratch_key);
+    if (!buf) {
+        buf = calloc(1, sizeof(e_plugin_buf_t));
+        if (buf && pthread_setspecific(g_scratch_key, buf) != 0) {
+            free(buf);
+            buf = NULL;
+        }
+    }
+    return buf;
+}
+
+static void stage_clear(pipeline_stage_t *stage) {
+    e_plugin_destroy(stage->plugin);
+    for (int i = 0; i < stage->identity_count; i++) free(stage->identity[i]);
+    free(stage->identity);
+}
+
+/* 相对路径按配置文件所在目录解析 */
+static char *resolve_path(const char *config, const char *path) {
+    const char *slash = strrchr(config, '/');
+    if (path[0] == '/' || !slash) return strdup(path);
+
+    size_t dir_len = slash - config + 1;
+    char *full = malloc(dir_len + strlen(path) + 1);
+    if (!full) return NULL;
+    memcpy(full, config, dir_len);
+    strcpy(full + dir_len, path);
+    return full;
+}
+
+/* 读取一级的 identity 数组 */
+static int stage_identity_load(pipeline_stage_t *stage, struct json_object *item) {
+    struct json_object *j_val;
+    if (!json_object_is_type(item, json_type_object) || !json_object_object_get_ex(item, "identity", &j_val) ||
+        !json_object_is_type(j_val, json_type_array)) {
+        return 0;
+    }
+
+    int n = json_object_array_length(j_val);
+    stage->identity = calloc(n > 0 ? n : 1, sizeof(char *));
+    if (!stage->identity) return -1;
+    for (int i = 0; i < n; i++) {
+        const char *pattern = json_object_get_string(json_object_array_get_idx(j_val, i));
+        if (pattern && (stage->identity[stage->identity_count] = strdup(pattern))) stage->identity_count++;
+    }
+    return 0;
+}
+
+static int codec_load(codec_stage_t *codec, struct json_object *item, const char *config) {
+    struct json_object *j_val;
+    const char *name = NULL;
+    if (json_object_object_get_ex(item, "codec", &j_val)) name = json_object_get_string(j_val);
+
+    size_t op = sizeof(codec_names) / sizeof(codec_names[0]);
+    for (size_t i = 0; name && i < sizeof(codec_names) / sizeof(codec_names[0]); i++) {
+        if (strcmp(name, codec_names[i]) == 0) op = i;
+    }
+    if (op == sizeof(codec_names) / sizeof(codec_names[0])) {
+        fprintf(stderr, "Pipeline %s: unknown codec %s\n", config, name ? name : "(null)");
+        return -1;
+    }
+    codec->op = (codec_op_t)op;
+    codec->type = E_CODEC_U16;
+    codec->scale = 1.0f;
+    codec->count = -1;
+
+    if (json_object_object_get_ex(item, "type", &j_val) &&
+        e_codec_type_parse(json_object_get_string(j_val), &codec->type) != 0) {
+        fprintf(stderr, "Pipeline %s: unknown codec type %s\n", config, json_object_get_string(j_val));
+        return -1;
+    }
+    if (json_object_object_get_ex(item, "scale", &j_val)) codec->scale = (float)json_object_get_double(j_val);
+    if (json_object_object_get_ex(item, "offset", &j_val)) codec->offset = (float)json_object_get_double(j_val);
+    if (json_object_object_get_ex(item, "start", &j_val)) codec->start = (size_t)json_object_get_int(j_val);
+    if (json_object_object_get_ex(item, "count", &j_val)) codec->count = json_object_get_int(j_val);
+    if (json_object_object_get_ex(item, "format", &j_val)) {
+        codec->json = strcmp(json_object_get_string(j_val), "json") == 0;
+    }
+    return 0;
+}
+
+static int stage_load(pipeline_stage_t *stage, struct json_object *item, const char *config, int pool_size) {
+    struct json_object *j_val;
+    const char *path = NULL;
+    memset(stage, 0, sizeof(*stage));
+
+    if (json_object_is_type(item, json_type_object) && json_object_object_get_ex(item, "codec", NULL)) {
+        if (codec_load(&stage->codec, item, config) != 0) return -1;
+        return stage_identity_load(stage, item);
+    }
+
+    if (json_object_is_type(item, json_type_string)) {
+        path = json_object_get_string(item);
+    } else if (json_object_is_type(item, json_type_object) && json_object_object_get_ex(item, "plugin", &j_val)) {
+        path = json_object_get_string(j_val);
+    }
+    if (!path || !*path) {
+        fprintf(stderr, "Pipeline %s: stage without plugin\n", config);
+        return -1;
+    }
+
+    char *full = resolve_path(config, path);
+    if (!full) return -1;
+    size_t len = strlen(full);
+    if (len > 5 && strcmp(full + len - 5, ".json") == 0) {
+        fprintf(stderr, "Pipeline %s: nested pipeline %s not supported\n", config, full);
+        free(full);
+        return -1;
+    }
+    stage->plugin = e_plugin_create_ex(full, pool_size);
+    if (!stage->plugin) {
+        fprintf(stderr, "Pipeline %s: failed to load %s\n", config, full);
+        free(full);
+        return -1;
+    }
+    free(full);
+    return stage_identity_load(stage, item);
+}
+
+e_plugin_pipeline_t *e_plugin_pipeline_load(const char *filename, int pool_size) {
+    if (!filename) return NULL;
+
+    struct json_object *root = json_object_from_file(filename);
+    if (!root) {
+        fprintf(stderr, "Failed to parse pipeline config %s\n", filename);
+        return NULL;
+    }
+
+    e_plugin_pipeline_t *pipe = calloc(1, sizeof(e_plugin_pipeline_t));
+    if (!pipe) {
+        json_object_put(root);
+        return NULL;
+    }
+
+    static const char *const keys[2] = { "north", "south" };
+    for (int d = 0; d < 2; d++) {
+        struct json_object *array;
+        if (!json_object_object_get_ex(root, keys[d], &array)) continue;
+        if (!json_object_is_type(array, json_type_array)) {
+            fprintf(stderr, "Pipeline %s: \"%s\" is not an array\n", filename, keys[d]);
+            goto fail;
+        }
+        int n = json_object_array_length(array);
+        if (n == 0) continue;
+        pipe->stages[d] = calloc(n, sizeof(pipeline_stage_t));
+        if (!pipe->stages[d]) goto fail;
+        for (int i = 0; i < n; i++) {
+            if (stage_load(&pipe->stages[d][i], json_object_array_get_idx(array, i), filename, pool_size) != 0) {
+                stage_clear(&pipe->stages[d][i]);
+                goto fail;
+            }
+            pipe->count[d]++;
+        }
+    }
+
+    json_object_put(root);
+    return pipe;
+
+fail:
+    json_object_put(root);
+    e_plugin_pipeline_destroy(pipe);
+    return NULL;
+}
+
+void e_plugin_pipeline_destroy(e_plugin_pipeline_t *pipe) {
+    if (!pipe) return;
+
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < pipe->count[d]; i++) stage_clear(&pipe->stages[d][i]);
+        free(pipe->stages[d]);
+    }
+    free(pipe);
+}
+
+static int stage_is_identity(const pipeline_stage_t *stage, const char *uid) {
+    if (!uid) return 0;
+    for (int i = 0; i < stage->identity_count; i++) {
+        if (fnmatch(stage->identity[i], uid, 0) == 0) return 1;
+    }
+    return e_plugin_is_identity(stage->plugin, uid);
+}
+
+/* 内置编解码级中只有字节序交换可以原地进行 */
+static bool stage_inplace(const pipeline_stage_t *stage) {
+    if (!stage->plugin) return stage->codec.op <= CODEC_SWAP_WORDS;
+    return (e_plugin_load_driver(stage->plugin)->flags & E_PLUGIN_F_INPLACE) != 0;
+}
+
+#define JSON_NUMBER_MAX     16      // 逗号加 "%.7g" 的最长输出（如 -1.234568e+38）
+
+static int codec_scale(const codec_stage_t *codec, const uint8_t *in, size_t len, e_plugin_buf_t *out) {
+    size_t count = len / e_codec_type_width(codec->type);
+    if (!codec->json) {
+        if (e_plugin_buf_reserve(out, count * sizeof(float)) != 0) return -1;
+        e_codec_scale((float *)out->data, in, count, codec->type, codec->scale, codec->offset);
+        out->len = count * sizeof(float);
+        return 0;
+    }
+
+    // 数值先换算到文本区之后，再从头写出文本，文本不会追上数值
+    size_t text = (count * JSON_NUMBER_MAX + 2 + 3) & ~(size_t)3;
+    if (e_plugin_buf_reserve(out, text + count * sizeof(float)) != 0) return -1;
+    float *values = (float *)((char *)out->data + text);
+    e_codec_scale(values, in, count, codec->type, codec->scale, codec->offset);
+
+    char *p = (char *)out->data;
+    *p++ = '[';
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) *p++ = ',';
+        if (isfinite(values[i])) {
+            p += snprintf(p, JSON_NUMBER_MAX, "%.7g", values[i]);
+        } else {
+            memcpy(p, "null", 4);
+            p += 4;
+        }
+    }
+    *p++ = ']';
+    out->len = p - (char *)out->data;
+    return 0;
+}
+
+static int codec_bits(const codec_stage_t *codec, const uint8_t *in, size_t len, e_plugin_buf_t *out) {
+    size_t total = len * 8;
+    if (codec->start > total) return -1;
+    size_t count = codec->count < 0 ? total - codec->start : (size_t)codec->count;
+    if (count > total - codec->start) return -1;
+
+    if (!codec->json) {
+        if (e_plugin_buf_reserve(out, count) != 0) return -1;
+        e_codec_bits((uint8_t *)out->data, in, codec->start, count);
+        out->len = count;
+        return 0;
+    }
+
+    size_t text = count * 2 + 2;
+    if (e_plugin_buf_reserve(out, text + count) != 0) return -1;
+    uint8_t *bits = (uint8_t *)out->data + text;
+    e_codec_bits(bits, in, codec->start, count);
+
+    char *p = (char *)out->data;
+    *p++ = '[';
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) *p++ = ',';
+        *p++ = (char)('0' + bits[i]);
+    }
+    *p++ = ']';
+    out->len = p - (char *)out->data;
+    return 0;
+}
+
+/* 执行内置编解码级，输入不合法时返回 -1 */
+static int codec_transform(const codec_stage_t *codec, const void *in, size_t len, e_plugin_buf_t *out) {
+    const uint8_t *src = (const uint8_t *)in;
+    long n = 0;
+
+    switch (codec->op) {
+        case CODEC_SWAP16:
+        case CODEC_SWAP32:
+        case CODEC_SWAP_WORDS:
+            if (e_plugin_buf_reserve(out, len) != 0) return -1;
+            if (codec->op == CODEC_SWAP16) {
+                e_codec_swap16((uint8_t *)out->data, src, len);
+            } else if (codec->op == CODEC_SWAP32) {
+                e_codec_swap32((uint8_t *)out->data, src, len);
+            } else {
+                e_codec_swap_words((uint8_t *)out->data, src, len);
+            }
+            n = (long)len;
+            break;
+        case CODEC_SCALE:
+            return codec_scale(codec, src, len, out);
+        case CODEC_BITS:
+            return codec_bits(codec, src, len, out);
+        case CODEC_HEX:
+            if (e_plugin_buf_reserve(out, E_CODEC_HEX_LEN(len)) != 0) return -1;
+            n = (long)e_codec_hex_encode((char *)out->data, src, len);
+            break;
+        case CODEC_UNHEX:
+            if (e_plugin_buf_reserve(out, len / 2) != 0) return -1;
+            n = e_codec_hex_decode((uint8_t *)out->data, (const char *)src, len);
+            break;
+        case CODEC_BASE64:
+            if (e_plugin_buf_reserve(out, E_CODEC_BASE64_LEN(len)) != 0) return -1;
+            n = (long)e_codec_base64_encode((char *)out->data, src, len);
+            break;
+        case CODEC_UNBASE64:
+            if (e_plugin_buf_reserve(out, len / 4 * 3 + 2) != 0) return -1;
+            n = e_codec_base64_decode((uint8_t *)out->data, (const char *)src, len);
+            break;
+    }
+    if (n < 0) return -1;
+    out->len = (size_t)n;
+    return 0;
+}
+
+int e_plugin_pipeline_transform(e_plugin_pipeline_t *pipe, e_plugin_dir_t dir, const char *uid,
+                                const void *in, size_t in_len, e_plugin_buf_t *out) {
+    if (!pipe || !out || (!in && in_len > 0)) return -1;
+
+    int d = dir == E_PLUGIN_NORTH ? 0 : 1;
+    e_plugin_buf_t *scratch = NULL;
+
+    // cur 为当前数据，所在的缓冲为 cur_buf（NULL 表示调用者的输入）
+    const void *cur = in;
+    size_t cur_len = in_len;
+    e_plugin_buf_t *cur_buf = (in && in == out->data) ? out : NULL;
+    int ran = 0;
+
+    for (int i = 0; i < pipe->count[d]; i++) {
+        pipeline_stage_t *stage = &pipe->stages[d][i];
+        if (stage_is_identity(stage, uid)) continue;
+
+        // 支持原地转换的一级直接改写当前缓冲，否则写入另一个缓冲
+        e_plugin_buf_t *target;
+        if (cur_buf && stage_inplace(stage)) {
+            target = cur_buf;
+        } else if (cur_buf == out) {
+            if (!scratch && !(scratch = thread_scratch())) return -1;
+            target = scratch;
+        } else {
+            target = out;
+        }
+
+        int rc = stage->plugin ? e_plugin_transform_for(stage->plugin, dir, uid, cur, cur_len, target)
+                               : codec_transform(&stage->codec, cur, cur_len, target);
+        if (rc != 0) return -1;
+        cur_buf = target;
+        cur = target->data;
+        cur_len = target->len;
+        ran = 1;
+    }
+
+    if (!ran) {
+        // 所有级都被跳过，输入原样输出
+        if (!cur_buf) {
+            if (e_plugin_buf_reserve(out, in_len) != 0) return -1;
+            if (in_len > 0) memcpy(out->data, in, in_len);
+        }
+        out->len = in_len;
+    } else if (cur_buf == scratch) {
+        // 结果在暂存缓冲中，交换两者的存储即可，不拷贝
+        e_plugin_buf_t tmp = *out;
+        *out = *scratch;
+        *scratch = tmp;
+    }
+    return 0;
+}
+
+void e_plugin_pipeline_set_budget(e_plugin_pipeline_t *pipe, const e_plugin_budget_t *budget) {
+    if (!pipe) return;
+
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < pipe->count[d]; i++) {
+            if (pipe->stages[d][i].plugin) e_plugin_set_budget(pipe->stages[d][i].plugin, budget);
+        }
+    }
+}
+
+void e_plugin_pipeline_lua_stats(e_plugin_pipeline_t *pipe, e_plugin_lua_stats_t *stats) {
+    if (!pipe || !stats) return;
+
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < pipe->count[d]; i++) {
+            e_plugin_lua_stats_t s;
+            if (!pipe->stages[d][i].plugin || e_plugin_lua_stats(pipe->stages[d][i].plugin, &s) != 0) continue;
+            stats->calls += s.calls;
+            stats->overruns += s.overruns;
+            stats->time_us += s.time_us;
+            if (s.max_us > stats->max_us) stats->max_us = s.max_us;
+            stats->disabled |= s.disabled;
+        }
+    }
+}
+
+void e_plugin_pipeline_print_stats(e_plugin_pipeline_t *pipe) {
+    if (!pipe) return;
+
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < pipe->count[d]; i++) {
+            if (pipe->stages[d][i].plugin) e_plugin_print_stats(pipe->stages[d][i].plugin);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef E_PLUGIN_PIPELINE_H
+#define E_PLUGIN_PIPELINE_H
+
+#include "e_plugin_driver.h"
+
+/**
+ * @brief 插件流水线：每个方向依次执行多个插件（lua/elf 可混用）
+ *
+ * 配置为 JSON 文件，由 e_plugin_create 按 .json 扩展名识别，可通过 e_plugin_reload 整体重载：
+ *
+ *     {
+ *       "north": [ "decode.lua", { "plugin": "scale.so", "identity": ["port3", "rtu*"] } ],
+ *       "south": [ "encode.lua" ]
+ *     }
+ *
+ * 每一级为插件路径（相对路径相对于配置文件所在目录），或带 identity 的对象：
+ * identity 为 fnmatch 模式，对匹配的 uid 跳过该级；插件自身声明的 identity 同样生效。
+ *
+ * 以 "codec" 代替 "plugin" 的一级为内置编解码（见 e_codec.h），不需要插件：
+ *
+ *     { "codec": "swap16" }                    // 也可为 swap32、swap_words
+ *     { "codec": "scale", "type": "i16", "scale": 0.1, "offset": 0, "format": "json" }
+ *     { "codec": "bits", "start": 0, "count": 16, "format": "json" }
+ *     { "codec": "hex" }                       // 也可为 unhex、base64、unbase64
+ *
+ * scale 输出 float 数组（本机字节序），bits 每位输出一个 0/1 字节；format 为 "json" 时输出 JSON 数组文本。
+ *
+ * 相邻两级在调用者的输出缓冲与线程内的暂存缓冲之间交替读写，声明 E_PLUGIN_F_INPLACE 的一级
+ * 直接在当前缓冲上原地转换，稳定后各级之间不分配内存也不额外拷贝。
+ */
+typedef struct e_plugin_pipeline e_plugin_pipeline_t;
+
+/**
+ * @brief 加载流水线配置
+ * 
+ * @param filename 配置文件名
+ * @param pool_size 各 lua 插件的状态数
+ * @return 流水线，失败返回NULL
+ */
+e_plugin_pipeline_t *e_plugin_pipeline_load(const char *filename, int pool_size);
+
+/**
+ * @brief 销毁流水线
+ * 
+ * @param pipe 流水线
+ */
+void e_plugin_pipeline_destroy(e_plugin_pipeline_t *pipe);
+
+/**
+ * @brief 按方向执行流水线，结果写入 out；所有级都被跳过时输入原样写入 out
+ * 
+ * @param pipe 流水线
+ * @param dir 转换方向
+ * @param uid 设备uid，NULL 表示不跳过任何一级
+ * @param in 输入数据（可以指向 out->data）
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @return 0成功，-1失败（任一级失败即丢弃该消息）
+ */
+int e_plugin_pipeline_transform(e_plugin_pipeline_t *pipe, e_plugin_dir_t dir, const char *uid,
+                                const void *in, size_t in_len, e_plugin_buf_t *out);
+
+/**
+ * @brief 为流水线中的各个插件设置 CPU 预算
+ * 
+ * @param pipe 流水线
+ * @param budget 预算
+ */
+void e_plugin_pipeline_set_budget(e_plugin_pipeline_t *pipe, const e_plugin_budget_t *budget);
+
+/**
+ * @brief 把流水线中各个插件的 lua 调用计数累加到 stats
+ * 
+ * @param pipe 流水线
+ * @param stats 累加的计数
+ */
+void e_plugin_pipeline_lua_stats(e_plugin_pipeline_t *pipe, e_plugin_lua_stats_t *stats);
+
+/**
+ * @brief 打印流水线中各个插件的计数
+ * 
+ * @param pipe 流水线
+ */
+void e_plugin_pipeline_print_stats(e_plugin_pipeline_t *pipe);
+
+#endif // E_PLUGIN_PIPELINE_H
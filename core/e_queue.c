@@ -74,6 +74,13 @@ void *e_queue_pop(e_queue_t *q){
     return data;
 }
 
+void *e_queue_peek(e_queue_t *q){
+    if (NULL == q || NULL == q->top || q->top->next == NULL){
+        return NULL;
+    }
+    return q->top->next->data;
+}
+
 int e_queue_merge(e_queue_t *dq, e_queue_t *sq)
 {
     while (!e_queue_empty(sq)){
@@ -23,6 +23,7 @@ void e_queue_destroy(e_queue_t *q);
 void e_queue_clear(e_queue_t *q);
 void e_queue_push(e_queue_t *q, void *data);
 void *e_queue_pop(e_queue_t *q);
+void *e_queue_peek(e_queue_t *q);
 int e_queue_merge(e_queue_t *dq, e_queue_t *sq);
 void e_queue_foreach(e_queue_t *q, void *arg, e_queue_foreach_callback callback);
 #endif
\ No newline at end of file
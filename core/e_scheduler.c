@@ -0,0 +1,122 @@
+#include "e_scheduler.h"
+#include "e_serialport.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+uint64_t e_scheduler_bus_time_us(const serial_config_t *cfg, size_t req_len, size_t rsp_len, uint64_t turnaround_us) {
+    if (!cfg) return turnaround_us;
+    // 请求之前、请求与响应之间各一个 t3.5 静默间隔；响应之后的间隔即下一个事务请求之前的间隔，不重复计入
+    return serial_wire_time_us(cfg, req_len + rsp_len) + 2 * serial_frame_gap_us(cfg) + turnaround_us;
+}
+
+e_scheduler_t *e_scheduler_create(int capacity) {
+    if (capacity <= 0) return NULL;
+
+    e_scheduler_t *sched = calloc(1, sizeof(e_scheduler_t));
+    if (!sched) {
+        perror("Failed to allocate scheduler");
+        return NULL;
+    }
+    sched->tasks = calloc(capacity, sizeof(e_sched_task_t));
+    if (!sched->tasks) {
+        perror("Failed to allocate scheduler tasks");
+        free(sched);
+        return NULL;
+    }
+    sched->capacity = capacity;
+    return sched;
+}
+
+void e_scheduler_destroy(e_scheduler_t *sched) {
+    if (!sched) return;
+    free(sched->tasks);
+    free(sched);
+}
+
+int e_scheduler_add(e_scheduler_t *sched, uint64_t period_us, uint64_t deadline_us, uint64_t cost_us) {
+    if (!sched || period_us == 0 || sched->count >= sched->capacity) return -1;
+
+    e_sched_task_t *task = &sched->tasks[sched->count];
+    task->period_us = period_us;
+    task->deadline_us = (deadline_us == 0 || deadline_us > period_us) ? period_us : deadline_us;
+    task->cost_us = cost_us;
+    return sched->count++;
+}
+
+void e_scheduler_start(e_scheduler_t *sched, uint64_t now_us) {
+    if (!sched) return;
+
+    sched->start_us = now_us;
+    sched->busy_us = 0;
+    for (int i = 0; i < sched->count; i++) {
+        sched->tasks[i].release_us = now_us;
+    }
+}
+
+int e_scheduler_next(e_scheduler_t *sched, uint64_t now_us, uint64_t *wait_us) {
+    if (!sched || sched->count == 0) return -1;
+
+    int best = -1;
+    uint64_t best_deadline = UINT64_MAX;
+    uint64_t next_release = UINT64_MAX;
+    for (int i = 0; i < sched->count; i++) {
+        const e_sched_task_t *task = &sched->tasks[i];
+        if (task->release_us > now_us) {
+            if (task->release_us < next_release) next_release = task->release_us;
+            continue;
+        }
+        // 截止时间相同时编号小的优先，保证结果确定
+        uint64_t deadline = task->release_us + task->deadline_us;
+        if (deadline < best_deadline) {
+            best_deadline = deadline;
+            best = i;
+        }
+    }
+
+    if (best < 0 && wait_us) *wait_us = next_release - now_us;
+    return best;
+}
+
+void e_scheduler_complete(e_scheduler_t *sched, int task_id, uint64_t start_us, uint64_t end_us) {
+    if (!sched || task_id < 0 || task_id >= sched->count) return;
+
+    e_sched_task_t *task = &sched->tasks[task_id];
+    uint64_t deadline = task->release_us + task->deadline_us;
+    uint64_t response = end_us > task->release_us ? end_us - task->release_us : 0;
+
+    task->runs++;
+    if (end_us > start_us) sched->busy_us += end_us - start_us;
+    if (response > task->response_max_us) task->response_max_us = response;
+    if (end_us > deadline) {
+        task->missed++;
+        if (end_us - deadline > task->lateness_max_us) task->lateness_max_us = end_us - deadline;
+    }
+
+    // 保持相位释放下一个作业，截止时间已过的周期不再补发
+    task->release_us += task->period_us;
+    while (task->release_us + task->deadline_us <= end_us) {
+        task->release_us += task->period_us;
+        task->skipped++;
+    }
+}
+
+void e_scheduler_get_stats(const e_scheduler_t *sched, uint64_t now_us, e_scheduler_stats_t *stats) {
+    if (!sched || !stats) return;
+
+    stats->runs = 0;
+    stats->missed = 0;
+    stats->skipped = 0;
+    stats->lateness_max_us = 0;
+    stats->demand = 0;
+    for (int i = 0; i < sched->count; i++) {
+        const e_sched_task_t *task = &sched->tasks[i];
+        stats->runs += task->runs;
+        stats->missed += task->missed;
+        stats->skipped += task->skipped;
+        if (task->lateness_max_us > stats->lateness_max_us) stats->lateness_max_us = task->lateness_max_us;
+        stats->demand += (double)task->cost_us / (double)task->deadline_us;
+    }
+
+    uint64_t elapsed = now_us > sched->start_us ? now_us - sched->start_us : 0;
+    stats->utilization = elapsed ? (double)sched->busy_us / (double)elapsed : 0;
+}
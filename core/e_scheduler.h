@@ -0,0 +1,106 @@
+#ifndef E_SCHEDULER_H
+#define E_SCHEDULER_H
+
+#include "e_serial_config.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* 周期任务：每个周期释放一个作业，需在相对截止时间内完成 */
+typedef struct {
+    uint64_t period_us;         // 周期
+    uint64_t deadline_us;       // 相对截止时间（不大于周期）
+    uint64_t cost_us;           // 预估总线占用时间
+    uint64_t release_us;        // 当前作业释放时间
+    uint64_t runs;              // 已执行次数
+    uint64_t missed;            // 完成时已超过截止时间的次数
+    uint64_t skipped;           // 截止时间已过未执行被跳过的周期数
+    uint64_t response_max_us;   // 释放到完成的最大耗时
+    uint64_t lateness_max_us;   // 超过截止时间的最大值
+} e_sched_task_t;
+
+/* 单条半双工总线上的 EDF 调度器，非线程安全，由使用者加锁 */
+typedef struct {
+    e_sched_task_t *tasks;
+    int count;
+    int capacity;
+    uint64_t start_us;          // 开始调度的时间
+    uint64_t busy_us;           // 累计总线占用时间
+} e_scheduler_t;
+
+/* 调度器汇总统计 */
+typedef struct {
+    uint64_t runs;
+    uint64_t missed;
+    uint64_t skipped;
+    uint64_t lateness_max_us;
+    double demand;              // 预估总线负载 Σ cost/min(period, deadline)，大于 1 时必然错过截止时间
+    double utilization;         // 实测总线占用率
+} e_scheduler_stats_t;
+
+/**
+ * @brief 估算一次请求-响应事务的总线占用时间
+ * @param cfg 串口配置（波特率、数据位、校验位、停止位）
+ * @param req_len 请求帧长度
+ * @param rsp_len 响应帧长度
+ * @param turnaround_us 从站响应及收发切换时间
+ * @return 占用时间 (us)，包含请求之前、请求与响应之间的两个 t3.5 帧间隔
+ */
+uint64_t e_scheduler_bus_time_us(const serial_config_t *cfg, size_t req_len, size_t rsp_len, uint64_t turnaround_us);
+
+/**
+ * @brief 创建调度器
+ * @param capacity 最大任务数
+ * @return 调度器句柄，失败返回NULL
+ */
+e_scheduler_t *e_scheduler_create(int capacity);
+
+/**
+ * @brief 销毁调度器
+ * @param sched 调度器句柄
+ */
+void e_scheduler_destroy(e_scheduler_t *sched);
+
+/**
+ * @brief 添加周期任务
+ * @param sched 调度器句柄
+ * @param period_us 周期
+ * @param deadline_us 相对截止时间，0 或大于周期时取周期
+ * @param cost_us 预估总线占用时间
+ * @return 任务编号，-1失败
+ */
+int e_scheduler_add(e_scheduler_t *sched, uint64_t period_us, uint64_t deadline_us, uint64_t cost_us);
+
+/**
+ * @brief 开始调度，所有任务在 now_us 释放第一个作业
+ * @param sched 调度器句柄
+ * @param now_us 当前时间（单调时钟）
+ */
+void e_scheduler_start(e_scheduler_t *sched, uint64_t now_us);
+
+/**
+ * @brief 选出已释放作业中截止时间最早的任务
+ * @param sched 调度器句柄
+ * @param now_us 当前时间
+ * @param wait_us 没有就绪作业时返回距下一次释放的时间，可为 NULL
+ * @return 任务编号，-1表示暂无就绪作业
+ */
+int e_scheduler_next(e_scheduler_t *sched, uint64_t now_us, uint64_t *wait_us);
+
+/**
+ * @brief 作业执行完毕，记录统计并释放下一周期的作业
+ * @param sched 调度器句柄
+ * @param task_id 任务编号
+ * @param start_us 占用总线的开始时间
+ * @param end_us 完成时间
+ */
+void e_scheduler_complete(e_scheduler_t *sched, int task_id, uint64_t start_us, uint64_t end_us);
+
+/**
+ * @brief 获取汇总统计
+ * @param sched 调度器句柄
+ * @param now_us 当前时间，用于计算实测占用率
+ * @param stats 输出统计
+ */
+void e_scheduler_get_stats(const e_scheduler_t *sched, uint64_t now_us, e_scheduler_stats_t *stats);
+
+#endif // E_SCHEDULER_H
@@ -12,13 +12,18 @@ void e_serial_config_usage(const char *prog) {
     fprintf(stderr, "Usage: %s [options]\n", prog);
     fprintf(stderr, "  -u, --uid <uid>                 UID for this serial device\n");
     fprintf(stderr, "  -D, --device <dev>              Serial device (e.g., /dev/ttyUSB0)\n");
-    fprintf(stderr, "  -b, --baud <rate>               Baud rate (default %ld)\n", DEFAULT_SERIAL_BAUDRATE);
+    fprintf(stderr, "  -b, --baud <rate>               Baud rate, non-standard rates allowed (default %ld)\n", DEFAULT_SERIAL_BAUDRATE);
     fprintf(stderr, "  -d, --databits <bits>           Data bits (5, 6, 7, 8)\n");
     fprintf(stderr, "  -s, --stopbits <bits>           Stop bits (1 or 2)\n");
     fprintf(stderr, "  -p, --parity <N|E|O>            Parity (None, Even, Odd)\n");
     fprintf(stderr, "  -m, --mindelay <ms>             Minimum delay between sends (ms)\n");
     fprintf(stderr, "  -l, --maxlen <length>           Max frame length (default %d)\n", DEFAULT_BUF_MAX);
     fprintf(stderr, "  -t, --timeout <ms>              Frame timeout in milliseconds (default %d ms)\n", DEFAULT_SERIAL_REV_TIMEOUT);
+    fprintf(stderr, "  -L, --lowlatency                Low latency mode (ASYNC_LOW_LATENCY, USB latency timer 1ms)\n");
+    fprintf(stderr, "  -f, --framelen <bytes>          Bytes that wake the reader in low latency mode (VMIN), shorter data is read after t3.5\n");
+    fprintf(stderr, "  -c, --crc                       Assemble Modbus RTU frames and drop frames with bad CRC\n");
+    fprintf(stderr, "  -r, --turnaround <ms>           Bus hold time after requests without a reply (default %d ms)\n", DEFAULT_TURNAROUND_MS);
+    fprintf(stderr, "  -g, --silent <us>               Silent interval between bus transactions (default t3.5)\n");
     fprintf(stderr, "  -C, --config <config.json>      JSON config file for multiple serial ports\n");
     fprintf(stderr, "\nExample:\n");
     fprintf(stderr, "  %s -u ttyusb2 -D /dev/ttyUSB2\n", prog);
@@ -35,7 +40,19 @@ void e_serial_config_print(const serial_config_t *config) {
     printf("    Parity        : %c\n", toupper(config->parity));
     printf("    Min delay (ms): %d\n", config->min_delay_ms);
     printf("    Max length    : %d\n", config->maxlen);
-    printf("    Timeout (ms)  : %d\n\n", config->timeout_ms);
+    printf("    Timeout (ms)  : %d\n", config->timeout_ms);
+    printf("    Low latency   : %s\n", config->low_latency ? "true" : "false");
+    printf("    Frame length  : %d\n", config->frame_len);
+    printf("    RTU CRC check : %s\n", config->rtu_crc ? "true" : "false");
+    printf("    Turnaround(ms): %d\n", config->turnaround_ms);
+    printf("    Silent (us)   : %d%s\n", config->silent_us, config->silent_us ? "" : " (t3.5)");
+    for (int i = 0; i < config->scan_count; i++) {
+        const e_modbus_scan_t *scan = &config->scan[i];
+        printf("    Scan %-9d : slave %d, fc %02X, address %d, count %d, period %d ms, deadline %d ms\n", i,
+               scan->req.slave, scan->req.function, scan->req.address, scan->req.count, scan->period_ms,
+               scan->deadline_ms ? scan->deadline_ms : scan->period_ms);
+    }
+    printf("\n");
 }
 
 static void e_serial_config_init(serial_config_t *config) {
@@ -48,6 +65,13 @@ static void e_serial_config_init(serial_config_t *config) {
     config->min_delay_ms = 0;
     config->maxlen = DEFAULT_BUF_MAX;
     config->timeout_ms = DEFAULT_SERIAL_REV_TIMEOUT;
+    config->low_latency = false;
+    config->frame_len = 0;
+    config->rtu_crc = false;
+    config->turnaround_ms = DEFAULT_TURNAROUND_MS;
+    config->silent_us = 0;
+    config->scan = NULL;
+    config->scan_count = 0;
 }
 
 static serial_config_t* e_serial_config_copy(const serial_config_t *src) {
@@ -63,6 +87,20 @@ static serial_config_t* e_serial_config_copy(const serial_config_t *src) {
     dst->min_delay_ms = src->min_delay_ms;
     dst->maxlen = src->maxlen;
     dst->timeout_ms = src->timeout_ms;
+    dst->low_latency = src->low_latency;
+    dst->frame_len = src->frame_len;
+    dst->rtu_crc = src->rtu_crc;
+    dst->turnaround_ms = src->turnaround_ms;
+    dst->silent_us = src->silent_us;
+    dst->scan = NULL;
+    dst->scan_count = 0;
+    if (src->scan_count > 0) {
+        dst->scan = malloc(sizeof(e_modbus_scan_t) * src->scan_count);
+        if (dst->scan) {
+            memcpy(dst->scan, src->scan, sizeof(e_modbus_scan_t) * src->scan_count);
+            dst->scan_count = src->scan_count;
+        }
+    }
 
     return dst;
 }
@@ -71,10 +109,57 @@ static void e_serial_config_free(serial_config_t *config) {
     if (config) {
         free(config->uid);
         free(config->device);
+        free(config->scan);
         free(config);
     }
 }
 
+/* 解析端口的 "scan" 数组，只接受读功能码，非法条目跳过 */
+static void e_serial_config_load_scan(struct json_object *array, serial_config_t *config) {
+    int count = json_object_array_length(array);
+    if (count <= 0) return;
+
+    config->scan = calloc(count, sizeof(e_modbus_scan_t));
+    if (!config->scan) return;
+
+    for (int i = 0; i < count; i++) {
+        struct json_object *item = json_object_array_get_idx(array, i);
+        struct json_object *j_val;
+        e_modbus_scan_t scan = {
+            .period_ms = DEFAULT_SCAN_PERIOD_MS,
+        };
+        // 先读入 int 检查范围，避免写入 uint8/uint16 字段时被截断成另一个合法的点
+        int slave = 1, function = MODBUS_FC_READ_HOLDING_REGISTERS, address = 0, num = 1;
+
+        if (json_object_object_get_ex(item, "slave", &j_val))
+            slave = json_object_get_int(j_val);
+        if (json_object_object_get_ex(item, "function", &j_val))
+            function = json_object_get_int(j_val);
+        if (json_object_object_get_ex(item, "address", &j_val))
+            address = json_object_get_int(j_val);
+        if (json_object_object_get_ex(item, "count", &j_val))
+            num = json_object_get_int(j_val);
+        if (json_object_object_get_ex(item, "period", &j_val))
+            scan.period_ms = json_object_get_int(j_val);
+        if (json_object_object_get_ex(item, "deadline", &j_val))
+            scan.deadline_ms = json_object_get_int(j_val);
+
+        scan.req.slave = slave;
+        scan.req.function = function;
+        scan.req.address = address;
+        scan.req.count = num;
+
+        if (slave < 0 || slave > 247 || function < 0 || function > 255 ||
+            address < 0 || address > 65535 || num < 0 || num > 65535 ||
+            !e_modbus_is_read(scan.req.function) || e_modbus_request_valid(&scan.req) != 0 ||
+            scan.period_ms <= 0 || scan.deadline_ms < 0 || scan.deadline_ms > scan.period_ms) {
+            fprintf(stderr, "[%s] Invalid scan entry %d, skipped\n", config->uid ? config->uid : "?", i);
+            continue;
+        }
+        config->scan[config->scan_count++] = scan;
+    }
+}
+
 static int e_serial_config_load_json(const char *filename, e_queue_t *queue) {
     FILE *fp = fopen(filename, "r");
     if (!fp) {
@@ -128,6 +213,8 @@ static int e_serial_config_load_json(const char *filename, e_queue_t *queue) {
         struct json_object *j_uid, *j_device, *j_baud, *j_databits;
         struct json_object *j_stopbits, *j_parity, *j_mindelay;
         struct json_object *j_maxlen, *j_timeout;
+        struct json_object *j_lowlatency, *j_framelen, *j_crc, *j_scan;
+        struct json_object *j_turnaround, *j_silent;
 
         if (json_object_object_get_ex(item, "uid", &j_uid))
             config->uid = strdup(json_object_get_string(j_uid));
@@ -158,6 +245,25 @@ static int e_serial_config_load_json(const char *filename, e_queue_t *queue) {
         if (json_object_object_get_ex(item, "timeout", &j_timeout))
             config->timeout_ms = json_object_get_int(j_timeout);
 
+        if (json_object_object_get_ex(item, "lowlatency", &j_lowlatency))
+            config->low_latency = json_object_get_boolean(j_lowlatency);
+
+        if (json_object_object_get_ex(item, "framelen", &j_framelen))
+            config->frame_len = json_object_get_int(j_framelen);
+
+        if (json_object_object_get_ex(item, "crc", &j_crc))
+            config->rtu_crc = json_object_get_boolean(j_crc);
+
+        if (json_object_object_get_ex(item, "turnaround", &j_turnaround))
+            config->turnaround_ms = json_object_get_int(j_turnaround);
+
+        if (json_object_object_get_ex(item, "silent", &j_silent))
+            config->silent_us = json_object_get_int(j_silent);
+
+        if (json_object_object_get_ex(item, "scan", &j_scan) &&
+            json_object_get_type(j_scan) == json_type_array)
+            e_serial_config_load_scan(j_scan, config);
+
         if (!config->device) {
             e_serial_config_free(config);
             continue;
@@ -185,6 +291,11 @@ int e_serial_config_parse(int argc, char **argv, e_queue_t *queue) {
         {"mindelay", required_argument, 0, 'm'},
         {"maxlen", required_argument, 0, 'l'},
         {"timeout", required_argument, 0, 't'},
+        {"lowlatency", no_argument, 0, 'L'},
+        {"framelen", required_argument, 0, 'f'},
+        {"crc", no_argument, 0, 'c'},
+        {"turnaround", required_argument, 0, 'r'},
+        {"silent", required_argument, 0, 'g'},
         {"config", required_argument, 0, 'C'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -192,7 +303,7 @@ int e_serial_config_parse(int argc, char **argv, e_queue_t *queue) {
 
     int opt;
     int long_index = 0;
-    while ((opt = getopt_long(argc, argv, "u:D:b:d:s:p:m:l:t:C:h", 
+    while ((opt = getopt_long(argc, argv, "u:D:b:d:s:p:m:l:t:Lf:cr:g:C:h", 
                             long_options, &long_index)) != -1) {
         switch (opt) {
             case 'u':
@@ -203,6 +314,10 @@ int e_serial_config_parse(int argc, char **argv, e_queue_t *queue) {
                 break;
             case 'b':
                 config.baudrate = atoi(optarg);
+                if (config.baudrate <= 0) {
+                    fprintf(stderr, "Invalid baud rate (>0)\n");
+                    return -1;
+                }
                 break;
             case 'd':
                 config.databits = atoi(optarg);
@@ -247,6 +362,33 @@ int e_serial_config_parse(int argc, char **argv, e_queue_t *queue) {
                     return -1;
                 }
                 break;
+            case 'L':
+                config.low_latency = true;
+                break;
+            case 'f':
+                config.frame_len = atoi(optarg);
+                if (config.frame_len < 0) {
+                    fprintf(stderr, "Invalid frame length (>=0)\n");
+                    return -1;
+                }
+                break;
+            case 'c':
+                config.rtu_crc = true;
+                break;
+            case 'r':
+                config.turnaround_ms = atoi(optarg);
+                if (config.turnaround_ms < 0) {
+                    fprintf(stderr, "Invalid turnaround (>=0)\n");
+                    return -1;
+                }
+                break;
+            case 'g':
+                config.silent_us = atoi(optarg);
+                if (config.silent_us < 0) {
+                    fprintf(stderr, "Invalid silent interval (>=0)\n");
+                    return -1;
+                }
+                break;
             case 'C':
                 config_file = strdup(optarg);   
                 break;
@@ -3,12 +3,16 @@
 
 #include <pthread.h>
 #include <signal.h>
+#include <stdbool.h>
 #include "e_queue.h"
+#include "e_modbus.h"
 
 #define DEFAULT_BUF_MAX             1024
 #define DEFAULT_SERIAL_BAUDRATE     115200UL
 #define DEFAULT_SERIAL_REV_TIMEOUT  100
 #define MAX_DEVICE_NAME_LEN         32
+#define DEFAULT_SCAN_PERIOD_MS      1000
+#define DEFAULT_TURNAROUND_MS       100
 
 /* 串口配置 */
 typedef struct {
@@ -21,6 +25,13 @@ typedef struct {
     int min_delay_ms;  // 最小发送间隔 (ms)
     int maxlen;        // 最大接收缓冲区长度
     int timeout_ms;    // 接收超时时间
+    bool low_latency;  // 低延迟模式（ASYNC_LOW_LATENCY + USB latency_timer）
+    int frame_len;     // 低延迟模式下唤醒读取线程的字节数，作为 VMIN（0 表示有数据即唤醒，不足的数据 t3.5 后补读）
+    bool rtu_crc;      // 按 t3.5 静默间隔组帧并校验 Modbus RTU CRC，丢弃错误帧
+    int turnaround_ms; // 广播等不需要响应的请求发出后的总线保持时间
+    int silent_us;     // 总线事务之间的最小静默间隔（0 表示 t3.5）
+    e_modbus_scan_t *scan; // Modbus 轮询扫描表（NULL 表示只转发原始数据）
+    int scan_count;    // 扫描块数量
 } serial_config_t;
 
 /**
@@ -1,5 +1,6 @@
 #include "e_serial_manager.h"
-#include "e_queue.h"
+#include "e_hash.h"
+#include "e_crc.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,167 +10,564 @@
 #include <errno.h>
 #include <pthread.h>
 #include <poll.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
 #include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 
+#define HOTPLUG_BACKOFF_BASE_MS     100     // 首次抖动的重连退避
+#define HOTPLUG_BACKOFF_MAX_MS      30000   // 重连退避上限
+#define HOTPLUG_STABLE_MS           5000    // 连接持续超过该时间后断开不视为抖动
+#define HOTPLUG_RESCAN_MS           1000    // inotify 不可用或目录无法监视时的兜底扫描周期
 
 
-static int find_port_index(e_queue_t *q, const char *uid) {
-    int index = 0;
-    e_qnode_t *node = q->top->next;
-    while (node) {
-        serial_context_t *ctx = (serial_context_t *)node->data;
-        if (ctx && strcmp(ctx->ser.uid, uid) == 0) {
-            return index;
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static serial_context_t *find_port(e_hash_t *ports, const char *uid) {
+    return (serial_context_t *)e_hash_get(ports, uid);
+}
+
+static void wake_fd(int fd) {
+    uint64_t one = 1;
+    ssize_t ret = write(fd, &one, sizeof(one));
+    (void)ret;
+}
+
+static void drain_fd(int fd) {
+    char buf[4096];
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+}
+
+static void wake_reader(serial_manager_t *manager) {
+    wake_fd(manager->wake_fd);
+}
+
+/* 关闭串口并丢弃未发送的帧，调用者需持有 fd_mutex */
+static void close_port(serial_context_t *ctx) {
+    if (ctx->fd >= 0) {
+        close(ctx->fd);
+        ctx->fd = -1;
+    }
+    ctx->rx_frame_len = 0;
+    ctx->rx_check_us = 0;
+    pthread_mutex_lock(&ctx->tx_mutex);
+    while (!e_queue_empty(&ctx->tx_queue)) {
+        free(e_queue_pop(&ctx->tx_queue));
+        ctx->stats.tx_dropped++;
+    }
+    ctx->stats.tx_queue_depth = 0;
+    pthread_mutex_unlock(&ctx->tx_mutex);
+}
+
+/*
+ * 组帧缓冲中的数据已静默超过 t3.5，校验 CRC 后拷贝到 frame，错误帧丢弃计数，调用者需持有 fd_mutex。
+ * 返回帧长度（0 表示没有有效帧），调用者释放 fd_mutex 后再调用接收回调。
+ */
+static size_t take_rx_frame(serial_context_t *ctx, uint8_t *frame) {
+    size_t len = ctx->rx_frame_len;
+    ctx->rx_frame_len = 0;
+    if (len == 0) return 0;
+
+    int ok = len >= 4 && e_crc16_modbus_check(ctx->rx_frame, len);
+    pthread_mutex_lock(&ctx->tx_mutex);
+    if (ok) ctx->stats.rx_frames++;
+    else ctx->stats.crc_errors++;
+    pthread_mutex_unlock(&ctx->tx_mutex);
+
+    if (!ok) return 0;
+    memcpy(frame, ctx->rx_frame, len);
+    return len;
+}
+
+/* 读取的数据追加到组帧缓冲，超过 RTU 最大帧长时按错误帧丢弃，调用者需持有 fd_mutex */
+static void append_rx_frame(serial_context_t *ctx, const char *data, size_t len, uint64_t now) {
+    ctx->rx_last_us = now;
+    if (ctx->rx_frame_len + len > sizeof(ctx->rx_frame)) {
+        ctx->rx_frame_len = 0;
+        pthread_mutex_lock(&ctx->tx_mutex);
+        ctx->stats.crc_errors++;
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        if (len > sizeof(ctx->rx_frame)) return;
+    }
+    memcpy(ctx->rx_frame + ctx->rx_frame_len, data, len);
+    ctx->rx_frame_len += len;
+}
+
+/* 低延迟模式设置了大于 1 的 VMIN：不足 VMIN 字节的数据不会触发 POLLIN，需要定时补读 */
+static bool rx_needs_check(const serial_context_t *ctx) {
+    return ctx->ser.low_latency && ctx->ser.frame_len > 1;
+}
+
+/* 安排下一次补读：until 之前每隔 t3.5 读一次，调用者需持有 fd_mutex */
+static void schedule_rx_check(serial_context_t *ctx, uint64_t now, uint64_t until) {
+    if (!rx_needs_check(ctx)) return;
+    ctx->rx_check_us = now + serial_frame_gap_us(&ctx->ser);
+    ctx->rx_check_end_us = until;
+}
+
+/* 读取线程检测到串口断开：关闭设备、按抖动情况计算退避并唤醒监控线程，调用者需持有 fd_mutex */
+static void port_disconnected(serial_manager_t *manager, serial_context_t *ctx) {
+    uint64_t now = monotonic_us();
+    close_port(ctx);
+
+    // 连接后很快又断开视为抖动，退避时间翻倍；稳定运行过则立即允许重连
+    bool flap = ctx->connect_us && now - ctx->connect_us < HOTPLUG_STABLE_MS * 1000ULL;
+    if (flap) {
+        ctx->backoff_ms = ctx->backoff_ms ? ctx->backoff_ms * 2 : HOTPLUG_BACKOFF_BASE_MS;
+        if (ctx->backoff_ms > HOTPLUG_BACKOFF_MAX_MS) ctx->backoff_ms = HOTPLUG_BACKOFF_MAX_MS;
+    } else {
+        ctx->backoff_ms = 0;
+    }
+    ctx->disconnect_us = now;
+    ctx->retry_us = now + (uint64_t)ctx->backoff_ms * 1000ULL;
+
+    pthread_mutex_lock(&ctx->tx_mutex);
+    if (flap) ctx->stats.flaps++;
+    ctx->stats.backoff_ms = ctx->backoff_ms;
+    pthread_mutex_unlock(&ctx->tx_mutex);
+
+    wake_fd(manager->monitor_wake_fd);
+}
+
+static void free_port(serial_context_t *ctx) {
+    ctx->running = 0;
+    pthread_mutex_lock(&ctx->fd_mutex);
+    close_port(ctx);
+    pthread_mutex_unlock(&ctx->fd_mutex);
+    e_queue_destroy(&ctx->tx_queue);
+    pthread_mutex_destroy(&ctx->tx_mutex);
+    pthread_mutex_destroy(&ctx->fd_mutex);
+    free(ctx);
+}
+
+/**
+ * @brief 非阻塞地写出发送队列，调用者需持有 fd_mutex
+ *
+ * 部分写时记录偏移量，等待下一次 POLLOUT；配置了 min_delay_ms 时每次只写一帧，
+ * 下一帧在本帧线上传输完成并再经过 min_delay_ms 后才允许发送。
+ */
+static void flush_tx_queue(serial_context_t *ctx) {
+    pthread_mutex_lock(&ctx->tx_mutex);
+    while (!e_queue_empty(&ctx->tx_queue)) {
+        uint64_t now = monotonic_us();
+        if (now < ctx->tx_ready_us) break;
+
+        serial_tx_frame_t *frame = (serial_tx_frame_t *)e_queue_peek(&ctx->tx_queue);
+        ssize_t n = write(ctx->fd, frame->data + frame->offset, frame->len - frame->offset);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                perror("write error");
+            }
+            break;
+        }
+
+        frame->offset += n;
+        if (frame->offset < frame->len) {
+            ctx->stats.tx_partial++;
+            break;
         }
-        node = node->next;
-        index++;
+
+        uint64_t latency = now - frame->enqueue_us;
+        ctx->stats.tx_frames++;
+        ctx->stats.tx_bytes += frame->len;
+        ctx->stats.tx_latency_last_us = latency;
+        ctx->stats.tx_latency_total_us += latency;
+        if (latency > ctx->stats.tx_latency_max_us) {
+            ctx->stats.tx_latency_max_us = latency;
+        }
+        e_queue_pop(&ctx->tx_queue);
+
+        // 响应可能短于 VMIN，在接收超时内持续补读
+        schedule_rx_check(ctx, now, now + serial_wire_time_us(&ctx->ser, frame->len) +
+                                    (uint64_t)ctx->ser.timeout_ms * 1000ULL);
+
+        if (ctx->ser.min_delay_ms > 0) {
+            ctx->tx_ready_us = now + serial_wire_time_us(&ctx->ser, frame->len) +
+                               (uint64_t)ctx->ser.min_delay_ms * 1000ULL;
+            free(frame);
+            break;
+        }
+        free(frame);
+    }
+    ctx->stats.tx_queue_depth = e_queue_size(&ctx->tx_queue);
+    pthread_mutex_unlock(&ctx->tx_mutex);
+}
+
+
+/* 根据当前串口表生成新快照并原子发布，旧快照进入待回收队列；调用者需持有写锁 */
+static int publish_snapshot(serial_manager_t *manager) {
+    int count = e_hash_size(&manager->ports);
+    serial_port_set_t *set = malloc(sizeof(serial_port_set_t) + sizeof(serial_context_t *) * count);
+    if (!set) return -1;
+
+    set->count = 0;
+    for (int slot = 0; slot < manager->ports.capacity; slot++) {
+        if (manager->ports.slots[slot].key) {
+            set->ports[set->count++] = (serial_context_t *)manager->ports.slots[slot].value;
+        }
+    }
+
+    serial_port_set_t *old = __atomic_exchange_n(&manager->snapshot, set, __ATOMIC_ACQ_REL);
+    if (old) {
+        pthread_mutex_lock(&manager->retire_mutex);
+        e_queue_push(&manager->retired_sets, old);
+        pthread_mutex_unlock(&manager->retire_mutex);
     }
-    return -1;
+    return 0;
 }
 
+/**
+ * @brief 回收已退役的快照和串口上下文
+ *
+ * 只在读取线程不持有任何快照引用时调用（读取循环顶部或读取线程退出后）。
+ * 退役发生在新快照发布之后，因此此后读取线程只会加载到不包含这些对象的快照。
+ */
+static void reclaim_retired(serial_manager_t *manager) {
+    pthread_mutex_lock(&manager->retire_mutex);
+    if (e_queue_empty(&manager->retired_sets) && e_queue_empty(&manager->retired_ports)) {
+        pthread_mutex_unlock(&manager->retire_mutex);
+        return;
+    }
+    e_queue_t sets, ports;
+    e_queue_init(&sets, 0);
+    e_queue_init(&ports, 1);
+    e_queue_merge(&sets, &manager->retired_sets);
+    e_queue_merge(&ports, &manager->retired_ports);
+    pthread_mutex_unlock(&manager->retire_mutex);
+
+    while (!e_queue_empty(&ports)) {
+        free_port((serial_context_t *)e_queue_pop(&ports));
+    }
+    e_queue_destroy(&ports);
+    e_queue_destroy(&sets);
+}
+
+/* 非阻塞读取串口数据，RTU 模式追加到组帧缓冲；返回读取的字节数，调用者需持有 fd_mutex */
+static ssize_t read_port(serial_manager_t *manager, serial_context_t *ctx, char *buf) {
+    ssize_t n = read(ctx->fd, buf, ctx->ser.maxlen);
+    if (n <= 0) {
+        if (n < 0 && errno != EAGAIN) {
+            perror("read error");
+            port_disconnected(manager, ctx);
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&ctx->tx_mutex);
+    ctx->stats.rx_bytes += n;
+    pthread_mutex_unlock(&ctx->tx_mutex);
+
+    uint64_t now = monotonic_us();
+    if (ctx->ser.rtu_crc) append_rx_frame(ctx, buf, n, now);
+    // 帧尾可能不足 VMIN，t3.5 后再补读一次
+    schedule_rx_check(ctx, now, now);
+    return n;
+}
 
 static void *read_thread_func(void *arg) {
     serial_manager_t *manager = (serial_manager_t *)arg;
+    struct pollfd *pfds = NULL;
+    serial_context_t **ctxs = NULL;
+    int pfds_cap = 0;
+    char *buf = NULL;
+    int buf_cap = 0;
+    uint8_t frame[MODBUS_RTU_MAX_ADU];
     
     while (manager->running) {
-        pthread_mutex_lock(&manager->mutex);
+        // 静止点：本线程不再引用上一轮的快照
+        reclaim_retired(manager);
+
+        serial_port_set_t *set = __atomic_load_n(&manager->snapshot, __ATOMIC_ACQUIRE);
+        int nports = set ? set->count : 0;
         
-        // 动态分配pollfd数组
-        struct pollfd *pfds = malloc(sizeof(struct pollfd) * manager->ports.size);
-        if (!pfds) {
-            pthread_mutex_unlock(&manager->mutex);
-            usleep(100000);
-            continue;
+        // pollfd数组按需扩容复用，下标0固定为唤醒用的eventfd
+        if (nports + 1 > pfds_cap) {
+            struct pollfd *new_pfds = realloc(pfds, sizeof(struct pollfd) * (nports + 1));
+            if (new_pfds) pfds = new_pfds;
+            serial_context_t **new_ctxs = realloc(ctxs, sizeof(serial_context_t *) * (nports + 1));
+            if (new_ctxs) ctxs = new_ctxs;
+            if (!new_pfds || !new_ctxs) {
+                usleep(100000);
+                continue;
+            }
+            pfds_cap = nports + 1;
         }
         
-        int valid_fds = 0;
-        e_qnode_t *node = manager->ports.top->next;
+        pfds[0].fd = manager->wake_fd;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        int valid_fds = 1;
+        int timeout_ms = 100;
+        uint64_t now = monotonic_us();
         
-        // 收集有效的文件描述符
-        while (node) {
-            serial_context_t *ctx = (serial_context_t *)node->data;
-            if (ctx && ctx->running) {
-                pthread_mutex_lock(&ctx->fd_mutex);
-                if (ctx->fd >= 0) {
-                    pfds[valid_fds].fd = ctx->fd;
-                    pfds[valid_fds].events = POLLIN | POLLERR | POLLHUP;
-                    pfds[valid_fds].revents = 0;
-                    valid_fds++;
+        // 收集有效的文件描述符，有待发送数据且已过帧间隔的串口关注POLLOUT
+        for (int p = 0; p < nports; p++) {
+            serial_context_t *ctx = set->ports[p];
+            if (!ctx->running) continue;
+
+            pthread_mutex_lock(&ctx->fd_mutex);
+            if (ctx->fd >= 0) {
+                pfds[valid_fds].fd = ctx->fd;
+                pfds[valid_fds].events = POLLIN | POLLERR | POLLHUP;
+                pfds[valid_fds].revents = 0;
+
+                pthread_mutex_lock(&ctx->tx_mutex);
+                if (!e_queue_empty(&ctx->tx_queue)) {
+                    if (now >= ctx->tx_ready_us) {
+                        pfds[valid_fds].events |= POLLOUT;
+                    } else {
+                        int wait_ms = (int)((ctx->tx_ready_us - now + 999) / 1000);
+                        if (wait_ms < timeout_ms) timeout_ms = wait_ms;
+                    }
+                }
+                pthread_mutex_unlock(&ctx->tx_mutex);
+
+                // 组帧中的串口在 t3.5 到期时唤醒
+                if (ctx->ser.rtu_crc && ctx->rx_frame_len > 0) {
+                    uint64_t due = ctx->rx_last_us + serial_frame_gap_us(&ctx->ser);
+                    int wait_ms = due > now ? (int)((due - now + 999) / 1000) : 0;
+                    if (wait_ms < timeout_ms) timeout_ms = wait_ms;
+                }
+
+                // 等待补读的串口
+                if (ctx->rx_check_us) {
+                    int wait_ms = ctx->rx_check_us > now ? (int)((ctx->rx_check_us - now + 999) / 1000) : 0;
+                    if (wait_ms < timeout_ms) timeout_ms = wait_ms;
+                }
+
+                if (ctx->ser.maxlen > buf_cap) {
+                    char *new_buf = realloc(buf, ctx->ser.maxlen);
+                    if (new_buf) {
+                        buf = new_buf;
+                        buf_cap = ctx->ser.maxlen;
+                    }
                 }
-                pthread_mutex_unlock(&ctx->fd_mutex);
+                ctxs[valid_fds] = ctx;
+                valid_fds++;
             }
-            node = node->next;
-        }
-        
-        pthread_mutex_unlock(&manager->mutex);
-        
-        if (valid_fds == 0) {
-            free(pfds);
-            usleep(100000);
-            continue;
+            pthread_mutex_unlock(&ctx->fd_mutex);
         }
         
         // 监控文件描述符
-        int ret = poll(pfds, valid_fds, 100);
+        int ret = poll(pfds, valid_fds, timeout_ms);
         if (ret < 0) {
-            free(pfds);
-            if (errno == EINTR) continue;
-            perror("poll error");
+            if (errno != EINTR) perror("poll error");
             continue;
         }
-        
-        if (ret == 0) {
-            free(pfds);
-            continue;
+
+        if (pfds[0].revents & POLLIN) {
+            uint64_t val;
+            ssize_t n = read(manager->wake_fd, &val, sizeof(val));
+            (void)n;
         }
         
-        // 处理事件
-        pthread_mutex_lock(&manager->mutex);
-        for (int i = 0; i < valid_fds; i++) {
+        // 处理事件：上下文在本轮快照内保持有效，数据拷贝出来后释放 fd_mutex 再回调，
+        // 回调中可以写入或移除串口（移除的上下文在下一轮循环开始时才回收）
+        for (int i = 1; i < valid_fds; i++) {
             if (pfds[i].revents == 0) continue;
             
-            // 查找对应上下文
-            serial_context_t *target_ctx = NULL;
-            e_qnode_t *node = manager->ports.top->next;
-            while (node) {
-                serial_context_t *ctx = (serial_context_t *)node->data;
-                if (ctx && ctx->fd == pfds[i].fd) {
-                    target_ctx = ctx;
-                    break;
-                }
-                node = node->next;
-            }
-            
-            if (!target_ctx || !target_ctx->running) continue;
+            serial_context_t *target_ctx = ctxs[i];
+            if (!target_ctx->running) continue;
             
             // 处理错误事件
             if (pfds[i].revents & (POLLERR | POLLHUP)) {
                 fprintf(stderr, "[%s] Port error/hangup\n", target_ctx->ser.uid);
                 pthread_mutex_lock(&target_ctx->fd_mutex);
-                close(target_ctx->fd);
-                target_ctx->fd = -1;
+                if (target_ctx->fd == pfds[i].fd) {
+                    port_disconnected(manager, target_ctx);
+                }
                 pthread_mutex_unlock(&target_ctx->fd_mutex);
                 continue;
             }
+
+            // 发送队列可写
+            if (pfds[i].revents & POLLOUT) {
+                pthread_mutex_lock(&target_ctx->fd_mutex);
+                if (target_ctx->fd == pfds[i].fd) {
+                    flush_tx_queue(target_ctx);
+                }
+                pthread_mutex_unlock(&target_ctx->fd_mutex);
+            }
             
             // 处理数据到达
-            if (pfds[i].revents & POLLIN) {
+            if ((pfds[i].revents & POLLIN) && buf_cap >= target_ctx->ser.maxlen) {
                 pthread_mutex_lock(&target_ctx->fd_mutex);
-                char *buf = malloc(target_ctx->ser.maxlen);
-                if (!buf) {
+                if (target_ctx->fd != pfds[i].fd) {
                     pthread_mutex_unlock(&target_ctx->fd_mutex);
                     continue;
                 }
                 
-                ssize_t n = read(target_ctx->fd, buf, target_ctx->ser.maxlen);
-                if (n <= 0) {
-                    free(buf);
-                    if (n < 0 && errno != EAGAIN) {
-                        perror("read error");
-                        close(target_ctx->fd);
-                        target_ctx->fd = -1;
-                    }
-                    pthread_mutex_unlock(&target_ctx->fd_mutex);
-                    continue;
-                }
-                
-                if (target_ctx->recv_cb) {
+                ssize_t n = read_port(manager, target_ctx, buf);
+                bool rtu = target_ctx->ser.rtu_crc;
+                pthread_mutex_unlock(&target_ctx->fd_mutex);
+
+                // buf 为本线程所有，回调期间不持有任何锁
+                if (n > 0 && !rtu && target_ctx->running && target_ctx->recv_cb) {
                     target_ctx->recv_cb(target_ctx, buf, n);
                 }
-                free(buf);
-                pthread_mutex_unlock(&target_ctx->fd_mutex);
             }
         }
-        pthread_mutex_unlock(&manager->mutex);
-        free(pfds);
+
+        // 补读不足 VMIN 而未触发 POLLIN 的数据；静默超过 t3.5 的 RTU 帧校验后上送
+        now = monotonic_us();
+        for (int i = 1; i < valid_fds; i++) {
+            serial_context_t *target_ctx = ctxs[i];
+            bool rtu = target_ctx->ser.rtu_crc;
+            if (!rtu && !rx_needs_check(target_ctx)) continue;
+
+            ssize_t n = 0;
+            size_t len = 0;
+            pthread_mutex_lock(&target_ctx->fd_mutex);
+            if (target_ctx->fd == pfds[i].fd && target_ctx->rx_check_us && now >= target_ctx->rx_check_us) {
+                target_ctx->rx_check_us = 0;
+                if (buf_cap >= target_ctx->ser.maxlen) n = read_port(manager, target_ctx, buf);
+                // 还没有收到响应，接收超时之前继续补读
+                if (n == 0 && target_ctx->fd >= 0 && now < target_ctx->rx_check_end_us) {
+                    target_ctx->rx_check_us = now + serial_frame_gap_us(&target_ctx->ser);
+                }
+            }
+            if (rtu && target_ctx->fd == pfds[i].fd && target_ctx->rx_frame_len > 0 &&
+                target_ctx->rx_last_us + serial_frame_gap_us(&target_ctx->ser) <= now) {
+                len = take_rx_frame(target_ctx, frame);
+            }
+            pthread_mutex_unlock(&target_ctx->fd_mutex);
+
+            if (n > 0 && !rtu && target_ctx->running && target_ctx->recv_cb) {
+                target_ctx->recv_cb(target_ctx, buf, n);
+            }
+            if (len > 0 && target_ctx->running && target_ctx->recv_cb) {
+                target_ctx->recv_cb(target_ctx, (const char *)frame, len);
+            }
+        }
     }
+
+    free(pfds);
+    free(ctxs);
+    free(buf);
     return NULL;
 }
 
+/* 为设备所在目录添加 inotify 监视，已监视的目录记录在 watched 中 */
+static void watch_device_dir(int ifd, e_hash_t *watched, const char *device) {
+    char dir[PATH_MAX];
+    const char *slash = strrchr(device, '/');
+    if (!slash) {
+        snprintf(dir, sizeof(dir), ".");
+    } else if (slash == device) {
+        snprintf(dir, sizeof(dir), "/");
+    } else {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - device), device);
+    }
+
+    if (e_hash_get(watched, dir)) return;
+
+    // 设备节点由内核/udev创建（IN_CREATE），权限随后修改（IN_ATTRIB），符号链接可能被移入（IN_MOVED_TO）
+    int wd = inotify_add_watch(ifd, dir, IN_CREATE | IN_ATTRIB | IN_MOVED_TO);
+    if (wd >= 0) {
+        e_hash_put(watched, dir, (void *)(intptr_t)(wd + 1));
+    }
+}
+
+/**
+ * @brief 尝试重新打开断开的串口，调用者需持有 fd_mutex
+ * @param trigger_us 本轮扫描被唤醒（热插拔事件/退避到期）的时间，用于统计重连耗时
+ */
+static void try_reopen(serial_manager_t *manager, serial_context_t *ctx, uint64_t trigger_us) {
+    if (access(ctx->ser.device, F_OK) != 0) return;
+
+    ctx->fd = serial_open(&ctx->ser);
+    if (ctx->fd < 0) return;
+
+    uint64_t now = monotonic_us();
+    ctx->connect_us = now;
+    ctx->tx_ready_us = 0;
+
+    if (ctx->disconnect_us) {
+        uint64_t latency = now - trigger_us;
+        pthread_mutex_lock(&ctx->tx_mutex);
+        ctx->stats.reconnects++;
+        ctx->stats.reconnect_latency_last_us = latency;
+        if (latency > ctx->stats.reconnect_latency_max_us) {
+            ctx->stats.reconnect_latency_max_us = latency;
+        }
+        ctx->stats.downtime_last_us = now - ctx->disconnect_us;
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        printf("[Monitor] %s reopened in %llu us\n", ctx->ser.uid, (unsigned long long)latency);
+    } else {
+        printf("[Monitor] %s opened\n", ctx->ser.uid);
+    }
+    ctx->disconnect_us = 0;
+
+    // 读取线程可能正阻塞在 poll 中，唤醒它以便立即监听新的 fd
+    wake_reader(manager);
+}
+
+/**
+ * @brief 热插拔监控线程
+ *
+ * 监视设备所在目录的 inotify 事件，设备节点出现后立即重新打开并配置串口；
+ * 断开后由读取线程唤醒。频繁抖动的设备按指数退避延迟重连。
+ */
 static void *monitor_thread_func(void *arg) {
     serial_manager_t *manager = (serial_manager_t *)arg;
-    
+    e_hash_t watched;
+    e_hash_init(&watched, 0);
+
+    int ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ifd < 0) {
+        perror("inotify_init1 failed, falling back to polling");
+    }
+
+    uint64_t trigger_us = monotonic_us();
     while (manager->running) {
-        sleep(1); // 1秒检测间隔
-        
-        pthread_mutex_lock(&manager->mutex);
-        e_qnode_t *node = manager->ports.top->next;
-        while (node) {
-            serial_context_t *ctx = (serial_context_t *)node->data;
-            if (ctx && ctx->running) {
-                pthread_mutex_lock(&ctx->fd_mutex);
-                if (ctx->fd < 0 && access(ctx->ser.device, F_OK) == 0) {
-                    ctx->fd = serial_open(&ctx->ser);
-                    if (ctx->fd >= 0) {
-                        printf("[Monitor] %s reopened\n", ctx->ser.uid);
-                    }
+        uint64_t now = monotonic_us();
+        int timeout_ms = HOTPLUG_RESCAN_MS;
+
+        pthread_rwlock_rdlock(&manager->lock);
+        for (int slot = 0; slot < manager->ports.capacity; slot++) {
+            serial_context_t *ctx = (serial_context_t *)manager->ports.slots[slot].value;
+            if (!manager->ports.slots[slot].key || !ctx || !ctx->running) continue;
+
+            if (ifd >= 0) {
+                watch_device_dir(ifd, &watched, ctx->ser.device);
+            }
+
+            pthread_mutex_lock(&ctx->fd_mutex);
+            if (ctx->fd < 0) {
+                if (now >= ctx->retry_us) {
+                    try_reopen(manager, ctx, trigger_us > ctx->retry_us ? trigger_us : ctx->retry_us);
+                } else {
+                    int wait_ms = (int)((ctx->retry_us - now + 999) / 1000);
+                    if (wait_ms < timeout_ms) timeout_ms = wait_ms;
                 }
-                pthread_mutex_unlock(&ctx->fd_mutex);
             }
-            node = node->next;
+            pthread_mutex_unlock(&ctx->fd_mutex);
+        }
+        pthread_rwlock_unlock(&manager->lock);
+
+        struct pollfd pfds[2] = {
+            { manager->monitor_wake_fd, POLLIN, 0 },
+            { ifd, POLLIN, 0 },
+        };
+        int ret = poll(pfds, ifd >= 0 ? 2 : 1, timeout_ms);
+        trigger_us = monotonic_us();
+        if (ret < 0) {
+            if (errno != EINTR) perror("poll error");
+            continue;
         }
-        pthread_mutex_unlock(&manager->mutex);
+        if (pfds[0].revents & POLLIN) drain_fd(manager->monitor_wake_fd);
+        if (ifd >= 0 && (pfds[1].revents & POLLIN)) drain_fd(ifd);
     }
+
+    if (ifd >= 0) close(ifd);
+    e_hash_destroy(&watched);
     return NULL;
 }
 
@@ -178,8 +576,26 @@ serial_manager_t *e_serial_manager_create(void) {
     serial_manager_t *manager = calloc(1, sizeof(serial_manager_t));
     if (!manager) return NULL;
     
-    e_queue_init(&manager->ports, 0);
-    pthread_mutex_init(&manager->mutex, NULL);
+    manager->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    manager->monitor_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (manager->wake_fd < 0 || manager->monitor_wake_fd < 0) {
+        perror("eventfd failed");
+        if (manager->wake_fd >= 0) close(manager->wake_fd);
+        if (manager->monitor_wake_fd >= 0) close(manager->monitor_wake_fd);
+        free(manager);
+        return NULL;
+    }
+
+    if (e_hash_init(&manager->ports, 0) != 0) {
+        close(manager->wake_fd);
+        close(manager->monitor_wake_fd);
+        free(manager);
+        return NULL;
+    }
+    pthread_rwlock_init(&manager->lock, NULL);
+    pthread_mutex_init(&manager->retire_mutex, NULL);
+    e_queue_init(&manager->retired_sets, 0);
+    e_queue_init(&manager->retired_ports, 1);
     return manager;
 }
 
@@ -188,22 +604,25 @@ void e_serial_manager_destroy(serial_manager_t *manager) {
     
     e_serial_manager_stop(manager);
     
-    pthread_mutex_lock(&manager->mutex);
-    while (!e_queue_empty(&manager->ports)) {
-        serial_context_t *ctx = e_queue_pop(&manager->ports);
-        if (ctx) {
-            ctx->running = 0;
-            pthread_mutex_lock(&ctx->fd_mutex);
-            if (ctx->fd >= 0) close(ctx->fd);
-            pthread_mutex_unlock(&ctx->fd_mutex);
-            pthread_mutex_destroy(&ctx->fd_mutex);
-            free(ctx);
+    pthread_rwlock_wrlock(&manager->lock);
+    for (int slot = 0; slot < manager->ports.capacity; slot++) {
+        serial_context_t *ctx = (serial_context_t *)manager->ports.slots[slot].value;
+        if (manager->ports.slots[slot].key && ctx) {
+            free_port(ctx);
         }
     }
-    e_queue_destroy(&manager->ports);
-    pthread_mutex_unlock(&manager->mutex);
-    
-    pthread_mutex_destroy(&manager->mutex);
+    e_hash_destroy(&manager->ports);
+    free(manager->snapshot);
+    manager->snapshot = NULL;
+    pthread_rwlock_unlock(&manager->lock);
+
+    reclaim_retired(manager);
+    e_queue_destroy(&manager->retired_sets);
+    e_queue_destroy(&manager->retired_ports);
+    pthread_mutex_destroy(&manager->retire_mutex);
+    pthread_rwlock_destroy(&manager->lock);
+    close(manager->wake_fd);
+    close(manager->monitor_wake_fd);
     free(manager);
 }
 
@@ -213,10 +632,12 @@ int e_serial_manager_add_port(serial_manager_t *manager,
                           void *data) {
     if (!manager || !config) return -1;
     
+    if (!config->uid) return -1;
+
     // 检查UID唯一性
-    pthread_mutex_lock(&manager->mutex);
-    if (find_port_index(&manager->ports, config->uid) >= 0) {
-        pthread_mutex_unlock(&manager->mutex);
+    pthread_rwlock_wrlock(&manager->lock);
+    if (find_port(&manager->ports, config->uid)) {
+        pthread_rwlock_unlock(&manager->lock);
         fprintf(stderr, "UID %s exists\n", config->uid);
         return -1;
     }
@@ -224,7 +645,7 @@ int e_serial_manager_add_port(serial_manager_t *manager,
     // 创建新上下文
     serial_context_t *ctx = calloc(1, sizeof(serial_context_t));
     if (!ctx) {
-        pthread_mutex_unlock(&manager->mutex);
+        pthread_rwlock_unlock(&manager->lock);
         return -1;
     }
     
@@ -233,42 +654,50 @@ int e_serial_manager_add_port(serial_manager_t *manager,
     ctx->running = 1;
     ctx->recv_cb = recv_cb;
     pthread_mutex_init(&ctx->fd_mutex, NULL);
+    pthread_mutex_init(&ctx->tx_mutex, NULL);
+    e_queue_init(&ctx->tx_queue, 0);
     ctx->data = data;
-    e_queue_push(&manager->ports, ctx);
-    pthread_mutex_unlock(&manager->mutex);
+    if (e_hash_put(&manager->ports, config->uid, ctx) != 0) {
+        pthread_rwlock_unlock(&manager->lock);
+        free_port(ctx);
+        return -1;
+    }
+    if (publish_snapshot(manager) != 0) {
+        e_hash_remove(&manager->ports, config->uid);
+        pthread_rwlock_unlock(&manager->lock);
+        free_port(ctx);
+        return -1;
+    }
+    pthread_rwlock_unlock(&manager->lock);
+
+    // 唤醒监控线程立即打开新串口
+    wake_fd(manager->monitor_wake_fd);
     return 0;
 }
 
 void e_serial_manager_remove_port(serial_manager_t *manager, const char *uid) {
     if (!manager || !uid) return;
     
-    pthread_mutex_lock(&manager->mutex);
-    
-    // 创建临时队列
-    e_queue_t temp;
-    e_queue_init(&temp, 0);
-    
-    while (!e_queue_empty(&manager->ports)) {
-        serial_context_t *ctx = e_queue_pop(&manager->ports);
-        if (ctx && strcmp(ctx->ser.uid, uid) == 0) {
-            ctx->running = 0;
-            pthread_mutex_lock(&ctx->fd_mutex);
-            if (ctx->fd >= 0) close(ctx->fd);
-            pthread_mutex_unlock(&ctx->fd_mutex);
-            pthread_mutex_destroy(&ctx->fd_mutex);
-            free(ctx);
-        } else {
-            e_queue_push(&temp, ctx);
-        }
+    pthread_rwlock_wrlock(&manager->lock);
+    serial_context_t *ctx = (serial_context_t *)e_hash_remove(&manager->ports, uid);
+    if (!ctx) {
+        pthread_rwlock_unlock(&manager->lock);
+        return;
     }
-    
-    // 恢复剩余端口
-    while (!e_queue_empty(&temp)) {
-        e_queue_push(&manager->ports, e_queue_pop(&temp));
+
+    // 立即停用并关闭设备，内存延后到读取线程不再引用时释放
+    ctx->running = 0;
+    pthread_mutex_lock(&ctx->fd_mutex);
+    close_port(ctx);
+    pthread_mutex_unlock(&ctx->fd_mutex);
+
+    while (publish_snapshot(manager) != 0) {
+        usleep(1000);
     }
-    e_queue_destroy(&temp);
-    
-    pthread_mutex_unlock(&manager->mutex);
+    pthread_mutex_lock(&manager->retire_mutex);
+    e_queue_push(&manager->retired_ports, ctx);
+    pthread_mutex_unlock(&manager->retire_mutex);
+    pthread_rwlock_unlock(&manager->lock);
 }
 
 int e_serial_manager_write(serial_manager_t *manager, 
@@ -277,27 +706,45 @@ int e_serial_manager_write(serial_manager_t *manager,
                        size_t len) {
     if (!manager || !uid || !data || len == 0) return -1;
     
-    pthread_mutex_lock(&manager->mutex);
-    e_qnode_t *node = manager->ports.top->next;
-    while (node) {
-        serial_context_t *ctx = (serial_context_t *)node->data;
-        if (ctx && strcmp(ctx->ser.uid, uid) == 0) {
-            pthread_mutex_lock(&ctx->fd_mutex);
-            if (ctx->fd < 0) {
-                pthread_mutex_unlock(&ctx->fd_mutex);
-                pthread_mutex_unlock(&manager->mutex);
-                return -1;
-            }
-            
-            ssize_t ret = write(ctx->fd, data, len);
-            pthread_mutex_unlock(&ctx->fd_mutex);
-            pthread_mutex_unlock(&manager->mutex);
-            return ret;
-        }
-        node = node->next;
+    pthread_rwlock_rdlock(&manager->lock);
+    serial_context_t *ctx = find_port(&manager->ports, uid);
+    // fd 只作为是否在线的提示读取，真正的写出在读取线程持有 fd_mutex 时完成
+    if (!ctx || ctx->fd < 0) {
+        pthread_rwlock_unlock(&manager->lock);
+        return -1;
     }
-    pthread_mutex_unlock(&manager->mutex);
-    return -1;
+
+    pthread_mutex_lock(&ctx->tx_mutex);
+    if (e_queue_size(&ctx->tx_queue) >= SERIAL_TX_QUEUE_MAX) {
+        ctx->stats.tx_dropped++;
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        pthread_rwlock_unlock(&manager->lock);
+        fprintf(stderr, "[%s] TX queue full\n", uid);
+        return -1;
+    }
+
+    serial_tx_frame_t *frame = malloc(sizeof(serial_tx_frame_t) + len);
+    if (!frame) {
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        pthread_rwlock_unlock(&manager->lock);
+        return -1;
+    }
+    frame->len = len;
+    frame->offset = 0;
+    frame->enqueue_us = monotonic_us();
+    memcpy(frame->data, data, len);
+    e_queue_push(&ctx->tx_queue, frame);
+
+    int depth = e_queue_size(&ctx->tx_queue);
+    ctx->stats.tx_queue_depth = depth;
+    if (depth > ctx->stats.tx_queue_peak) {
+        ctx->stats.tx_queue_peak = depth;
+    }
+    pthread_mutex_unlock(&ctx->tx_mutex);
+    pthread_rwlock_unlock(&manager->lock);
+
+    wake_reader(manager);
+    return (int)len;
 }
 
 void e_serial_manager_start(serial_manager_t *manager) {
@@ -312,11 +759,70 @@ void e_serial_manager_stop(serial_manager_t *manager) {
     if (!manager || !manager->running) return;
     
     manager->running = 0;
+    wake_fd(manager->wake_fd);
+    wake_fd(manager->monitor_wake_fd);
     pthread_join(manager->read_tid, NULL);
     pthread_join(manager->monitor_tid, NULL);
+    reclaim_retired(manager);
 }
 
 int e_serial_manager_size(serial_manager_t *manager) {
     if (!manager) return 0;
-    return e_queue_size(&manager->ports);
+    pthread_rwlock_rdlock(&manager->lock);
+    int size = e_hash_size(&manager->ports);
+    pthread_rwlock_unlock(&manager->lock);
+    return size;
+}
+
+int e_serial_manager_get_stats(serial_manager_t *manager, const char *uid, serial_port_stats_t *stats) {
+    if (!manager || !uid || !stats) return -1;
+
+    pthread_rwlock_rdlock(&manager->lock);
+    serial_context_t *ctx = find_port(&manager->ports, uid);
+    if (!ctx) {
+        pthread_rwlock_unlock(&manager->lock);
+        return -1;
+    }
+    pthread_mutex_lock(&ctx->tx_mutex);
+    *stats = ctx->stats;
+    pthread_mutex_unlock(&ctx->tx_mutex);
+    pthread_rwlock_unlock(&manager->lock);
+    return 0;
+}
+
+static int print_port_stats(void *arg, const char *uid, void *value) {
+    (void)arg;
+    (void)uid;
+    serial_context_t *ctx = (serial_context_t *)value;
+    if (!ctx) return 0;
+
+    pthread_mutex_lock(&ctx->tx_mutex);
+    serial_port_stats_t st = ctx->stats;
+    pthread_mutex_unlock(&ctx->tx_mutex);
+
+    printf("[%s] tx: %llu frames, %llu bytes, %llu dropped, %llu partial | "
+           "queue: %d (peak %d) | latency us: last %llu, avg %llu, max %llu | rx: %llu bytes, %llu frames, %llu crc errors | "
+           "reconnects: %llu (flaps %llu, backoff %d ms), reconnect us: last %llu, max %llu, downtime %llu\n",
+           ctx->ser.uid,
+           (unsigned long long)st.tx_frames, (unsigned long long)st.tx_bytes,
+           (unsigned long long)st.tx_dropped, (unsigned long long)st.tx_partial,
+           st.tx_queue_depth, st.tx_queue_peak,
+           (unsigned long long)st.tx_latency_last_us,
+           (unsigned long long)(st.tx_frames ? st.tx_latency_total_us / st.tx_frames : 0),
+           (unsigned long long)st.tx_latency_max_us,
+           (unsigned long long)st.rx_bytes, (unsigned long long)st.rx_frames,
+           (unsigned long long)st.crc_errors,
+           (unsigned long long)st.reconnects, (unsigned long long)st.flaps, st.backoff_ms,
+           (unsigned long long)st.reconnect_latency_last_us,
+           (unsigned long long)st.reconnect_latency_max_us,
+           (unsigned long long)st.downtime_last_us);
+    return 0;
+}
+
+void e_serial_manager_print_stats(serial_manager_t *manager) {
+    if (!manager) return;
+
+    pthread_rwlock_rdlock(&manager->lock);
+    e_hash_foreach(&manager->ports, NULL, print_port_stats);
+    pthread_rwlock_unlock(&manager->lock);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #ifndef E_SERIAL_MANAGER_H
 #define E_SERIAL_MANAGER_H
 
-#include "e_queue.h"
+#include "e_hash.h"
 #include "e_serialport.h"
 #include <stdbool.h>
 
@@ -9,13 +9,25 @@
 /* 串口接收回调函数类型 */
 typedef void (*serial_recv_callback_t)(void *ctx, const char *data, size_t len);
 
+/* 串口集合快照：发布后只读，读取线程无锁遍历 */
+typedef struct serial_port_set {
+    int count;
+    serial_context_t *ports[];
+} serial_port_set_t;
+
 /* 串口管理器结构体 */
 typedef struct serial_manager {
-    e_queue_t ports;              // 串口队列（使用e_queue管理）
+    e_hash_t ports;               // 串口表（uid -> serial_context_t*）
     volatile sig_atomic_t running; // 原子运行标志
-    pthread_mutex_t mutex;        // 全局互斥锁
+    pthread_rwlock_t lock;        // 串口表读写锁（增删取写锁，查找/收发取读锁）
+    serial_port_set_t *snapshot;  // 读取线程使用的串口快照（原子发布）
+    pthread_mutex_t retire_mutex; // 保护待回收队列
+    e_queue_t retired_sets;       // 待回收的旧快照
+    e_queue_t retired_ports;      // 待回收的已移除串口上下文
     pthread_t read_tid;           // 读取线程
     pthread_t monitor_tid;        // 监控线程
+    int wake_fd;                  // eventfd，有新发送数据时唤醒读取线程
+    int monitor_wake_fd;          // eventfd，串口断开/新增时唤醒监控线程
 } serial_manager_t;
 
 /* ========== API 接口 ========== */
@@ -47,6 +59,10 @@ int e_serial_manager_add_port(serial_manager_t *manager,
 
 /**
  * @brief 从管理器移除串口
+ *
+ * 串口立即关闭并从读取快照中移除，上下文内存在读取线程进入下一轮循环后回收。
+ * 读取线程调用接收回调时不持有任何锁，因此可以在接收回调中调用（包括移除回调所属的串口）。
+ *
  * @param manager 管理器句柄
  * @param uid 要移除的设备uid
  */
@@ -54,11 +70,15 @@ void e_serial_manager_remove_port(serial_manager_t *manager, const char *uid);
 
 /**
  * @brief 向指定串口写入数据
+ *
+ * 数据被拷贝进该串口的发送队列后立即返回，由读取线程在 POLLOUT 时
+ * 非阻塞写出，并保证相邻两帧之间至少间隔 min_delay_ms。
+ *
  * @param manager 管理器句柄
  * @param uid 目标串口uid
  * @param data 要写入的数据
  * @param len 数据长度
- * @return 成功写入的字节数，失败返回-1
+ * @return 成功入队的字节数，串口不存在/未打开/队列已满返回-1
  */
 int e_serial_manager_write(serial_manager_t *manager, 
                        const char *uid,
@@ -84,5 +104,20 @@ void e_serial_manager_stop(serial_manager_t *manager);
  */
 int e_serial_manager_size(serial_manager_t *manager);
 
+/**
+ * @brief 获取串口统计信息（发送队列深度、入队延迟等）
+ * @param manager 管理器句柄
+ * @param uid 串口uid
+ * @param stats 输出统计信息
+ * @return 成功返回0，串口不存在返回-1
+ */
+int e_serial_manager_get_stats(serial_manager_t *manager, const char *uid, serial_port_stats_t *stats);
+
+/**
+ * @brief 打印所有串口的统计信息
+ * @param manager 管理器句柄
+ */
+void e_serial_manager_print_stats(serial_manager_t *manager);
+
 
 #endif // E_SERIAL_MANAGER_H
\ No newline at end of file
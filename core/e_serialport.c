@@ -1,9 +1,40 @@
 #include "e_serialport.h"
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <termios.h>
 #include <getopt.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+
+/*
+ * 内核的 asm/termbits.h 与 glibc 的 termios.h 不能同时包含，
+ * 这里按内核布局声明 termios2，用于 BOTHER 设置任意波特率。
+ */
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#ifndef IBSHIFT
+#define IBSHIFT 16
+#endif
+
+struct serial_termios2 {
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+#define SERIAL_TCGETS2 _IOR('T', 0x2A, struct serial_termios2)
+#define SERIAL_TCSETS2 _IOW('T', 0x2B, struct serial_termios2)
 
 
 static speed_t get_baud_constant(int baudrate) {
@@ -39,9 +70,73 @@ static speed_t get_baud_constant(int baudrate) {
         case 3500000: return B3500000;
         case 4000000: return B4000000;
         default:
-            fprintf(stderr, "Unsupported baudrate %d\n", baudrate);
-            return B0;
+            return B0;  // 非标准波特率，由 serial_set_custom_baud 处理
+    }
+}
+
+/**
+ * @brief 通过 termios2/BOTHER 设置任意波特率
+ * @param fd 串口文件描述符
+ * @param baudrate 波特率
+ * @return 0成功，-1失败
+ */
+static int serial_set_custom_baud(int fd, int baudrate) {
+    struct serial_termios2 tio;
+    if (ioctl(fd, SERIAL_TCGETS2, &tio) < 0) {
+        perror("TCGETS2 failed");
+        return -1;
+    }
+
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = baudrate;
+    tio.c_ospeed = baudrate;
+    if (ioctl(fd, SERIAL_TCSETS2, &tio) < 0) {
+        fprintf(stderr, "Unsupported baudrate %d: %s\n", baudrate, strerror(errno));
+        return -1;
+    }
+
+    // 驱动可能取最接近的分频，读回实际波特率
+    if (ioctl(fd, SERIAL_TCGETS2, &tio) == 0 && (int)tio.c_ospeed != baudrate) {
+        fprintf(stderr, "Baudrate %d rounded to %u by driver\n", baudrate, (unsigned)tio.c_ospeed);
+    }
+    return 0;
+}
+
+/**
+ * @brief 设置 USB 串口（FTDI 等）的 latency_timer 为 1ms
+ *
+ * 默认 16ms 的延迟定时器会叠加到每次收发上，需要写 sysfs 权限，失败时忽略。
+ */
+static void serial_set_usb_latency_timer(const char *device) {
+    char real[PATH_MAX];
+    if (!realpath(device, real)) return;
+
+    const char *name = strrchr(real, '/');
+    name = name ? name + 1 : real;
+
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "/sys/bus/usb-serial/devices/%s/latency_timer", name);
+    FILE *f = fopen(path, "w");
+    if (!f) return;
+    fputs("1", f);
+    fclose(f);
+}
+
+/**
+ * @brief 低延迟模式：设置 ASYNC_LOW_LATENCY 并缩短 USB 串口延迟定时器
+ * @param fd 串口文件描述符
+ * @param cfg 串口配置
+ */
+static void serial_set_low_latency(int fd, const serial_config_t *cfg) {
+    struct serial_struct ss;
+    if (ioctl(fd, TIOCGSERIAL, &ss) == 0) {
+        ss.flags |= ASYNC_LOW_LATENCY;
+        if (ioctl(fd, TIOCSSERIAL, &ss) < 0) {
+            perror("TIOCSSERIAL ASYNC_LOW_LATENCY failed");
+        }
     }
+    serial_set_usb_latency_timer(cfg->device);
 }
 
 
@@ -54,11 +149,16 @@ int serial_configure(int fd, const serial_config_t *cfg) {
 
     cfmakeraw(&options);
 
-    // 设置波特率
-    speed_t baud = get_baud_constant(cfg->baudrate);
-    if (baud == B0) {
+    // 设置波特率，非标准波特率先用占位值，tcsetattr 之后再通过 termios2 设置
+    if (cfg->baudrate <= 0) {
+        fprintf(stderr, "Invalid baudrate %d\n", cfg->baudrate);
         return -1;
     }
+    speed_t baud = get_baud_constant(cfg->baudrate);
+    bool custom_baud = (baud == B0);
+    if (custom_baud) {
+        baud = B38400;
+    }
     cfsetispeed(&options, baud);
     cfsetospeed(&options, baud);
 
@@ -109,14 +209,28 @@ int serial_configure(int fd, const serial_config_t *cfg) {
     options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG); // 非规范模式
 
     // 设置超时特性
-    options.c_cc[VMIN] = 0;  // 非阻塞读取
-    options.c_cc[VTIME] = 0; // 无超时
+    // fd 以 O_NONBLOCK 打开，read 不会因 VMIN 阻塞；但 VTIME=0 时 poll 只在
+    // 缓冲区至少有 VMIN 字节时才报告可读，低延迟模式据此按帧长唤醒读取线程，
+    // 不足 VMIN 的短帧与帧尾由读取线程在 t3.5 后补读
+    options.c_cc[VMIN] = 0;
+    options.c_cc[VTIME] = 0;
+    if (cfg->low_latency && cfg->frame_len > 0) {
+        options.c_cc[VMIN] = cfg->frame_len > 255 ? 255 : cfg->frame_len;
+    }
 
     if (tcsetattr(fd, TCSANOW, &options) < 0) {
         perror("tcsetattr failed");
         return -1;
     }
 
+    if (custom_baud && serial_set_custom_baud(fd, cfg->baudrate) < 0) {
+        return -1;
+    }
+
+    if (cfg->low_latency) {
+        serial_set_low_latency(fd, cfg);
+    }
+
     tcflush(fd, TCIOFLUSH);
 
     return 0;
@@ -152,4 +266,16 @@ size_t serial_write(serial_context_t *ctx, const char *data, size_t len) {
     ssize_t n = write(ctx->fd, data, len);
     pthread_mutex_unlock(&ctx->fd_mutex);
     return n;
-}
\ No newline at end of file
+}
+
+uint64_t serial_wire_time_us(const serial_config_t *cfg, size_t len) {
+    if (cfg->baudrate <= 0) return 0;
+    int bits = 1 + cfg->databits + cfg->stopbits;
+    if (cfg->parity != 'n' && cfg->parity != 'N') bits++;
+    return (uint64_t)len * bits * 1000000ULL / (uint64_t)cfg->baudrate;
+}
+
+uint64_t serial_frame_gap_us(const serial_config_t *cfg) {
+    if (cfg->baudrate > 19200) return 1750;
+    return serial_wire_time_us(cfg, 35) / 10;
+}
@@ -2,10 +2,43 @@
 #define E_SERIALPORT_H
 
 #include "e_serial_config.h"
+#include <stdint.h>
+
+#define SERIAL_TX_QUEUE_MAX         64   // 每个串口发送队列最大帧数
 
 /* 串口接收回调函数类型 */
 typedef void (*serial_recv_callback_t)(void *ctx, const char *data, size_t len);
 
+/* 串口发送帧（数据紧跟在结构体之后，一次分配） */
+typedef struct {
+    size_t len;             // 帧长度
+    size_t offset;          // 已写出的字节数（处理部分写）
+    uint64_t enqueue_us;    // 入队时间（单调时钟，微秒）
+    char data[];            // 帧数据
+} serial_tx_frame_t;
+
+/* 串口统计信息 */
+typedef struct {
+    uint64_t tx_frames;             // 已发送帧数
+    uint64_t tx_bytes;              // 已发送字节数
+    uint64_t tx_dropped;            // 队列满被拒绝的帧数
+    uint64_t tx_partial;            // 部分写次数
+    uint64_t tx_latency_last_us;    // 最近一帧从入队到写完的延迟
+    uint64_t tx_latency_max_us;     // 最大入队延迟
+    uint64_t tx_latency_total_us;   // 入队延迟累计（用于求平均）
+    int tx_queue_depth;             // 当前发送队列深度
+    int tx_queue_peak;              // 发送队列深度峰值
+    uint64_t rx_bytes;              // 已接收字节数
+    uint64_t rx_frames;             // 通过 CRC 校验的 RTU 帧数（rtu_crc 模式）
+    uint64_t crc_errors;            // CRC 错误或超长被丢弃的帧数（rtu_crc 模式）
+    uint64_t reconnects;            // 断开后重新打开的次数
+    uint64_t flaps;                 // 连接后短时间内又断开的次数
+    uint64_t reconnect_latency_last_us; // 最近一次从检测到设备到重新打开的耗时
+    uint64_t reconnect_latency_max_us;  // 最大重连耗时
+    uint64_t downtime_last_us;      // 最近一次断开到重新打开的总时长
+    int backoff_ms;                 // 当前重连退避时间
+} serial_port_stats_t;
+
 /* 串口上下文 */
 typedef struct {
     int fd;
@@ -14,6 +47,19 @@ typedef struct {
     serial_recv_callback_t recv_cb; // 接收回调函数
     serial_config_t ser;            // 串口配置
     void *data;                     // 回调函数参数
+    e_queue_t tx_queue;             // 发送队列（serial_tx_frame_t）
+    pthread_mutex_t tx_mutex;       // 保护发送队列与统计信息
+    uint64_t tx_ready_us;           // 下一帧最早可发送时间（min_delay_ms 帧间隔）
+    serial_port_stats_t stats;      // 统计信息
+    uint64_t connect_us;            // 最近一次打开成功的时间
+    uint64_t disconnect_us;         // 最近一次断开的时间（0表示尚未断开过）
+    uint64_t retry_us;              // 允许重新打开的最早时间（抖动退避）
+    int backoff_ms;                 // 当前退避时间
+    uint8_t rx_frame[MODBUS_RTU_MAX_ADU]; // RTU 组帧缓冲（rtu_crc 模式，受 fd_mutex 保护）
+    size_t rx_frame_len;            // 组帧缓冲中的字节数
+    uint64_t rx_last_us;            // 最近一次收到数据的时间，用于判断 t3.5 帧间隔
+    uint64_t rx_check_us;           // VMIN 模式下补读不足 VMIN 字节的时间（0 表示不需要，受 fd_mutex 保护）
+    uint64_t rx_check_end_us;       // 等待响应期间持续补读的截止时间
 } serial_context_t;
 
 /**
@@ -54,4 +100,19 @@ size_t serial_write(serial_context_t *ctx, const char *data, size_t len);
  */
 int serial_set_recv_callback(serial_context_t *ctx, serial_recv_callback_t cb);
 
+/**
+ * @brief 按串口参数计算 len 字节在线路上的传输时间
+ * @param cfg 串口配置
+ * @param len 字节数
+ * @return 传输时间 (us)
+ */
+uint64_t serial_wire_time_us(const serial_config_t *cfg, size_t len);
+
+/**
+ * @brief Modbus RTU 帧间隔 t3.5，19200 以上波特率固定为 1750us
+ * @param cfg 串口配置
+ * @return 帧间隔 (us)
+ */
+uint64_t serial_frame_gap_us(const serial_config_t *cfg);
+
 #endif // E_SERIALPORT_H
\ No newline at end of file
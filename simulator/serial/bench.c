@@ -0,0 +1,301 @@
+#include "e_sim_device.h"
+#include <ezmb/e_serial_manager.h>
+#include <ezmb/e_crc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <getopt.h>
+
+#define BENCH_MAX_PORTS     256
+#define BENCH_MAX_SAMPLES   (4 * 1024 * 1024)
+
+/* 单个串口的基准测试状态 */
+typedef struct {
+    char uid[32];
+    int master_fd;
+    int slave_fd;
+    char slave_path[64];
+    uint8_t buf[SIM_BUF_MAX * 2];   // 接收重组缓冲
+    size_t len;
+    uint32_t seq;
+} bench_port_t;
+
+typedef struct {
+    int frame_len;
+    int rate_hz;                    // 每个串口的发送速率，0表示尽可能快
+    int seconds;
+} bench_options_t;
+
+static bench_options_t g_opts = { 32, 1000, 3 };
+static bench_port_t g_ports[BENCH_MAX_PORTS];
+static int g_nports;
+static volatile int g_writing;
+
+// 以下统计只在串口管理器的读取线程中更新
+static uint32_t *g_samples;
+static size_t g_nsamples;
+static uint64_t g_rx_frames;
+static uint64_t g_rx_bytes;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options]\n", prog);
+    fprintf(stderr, "  -n, --ports <list>              Comma separated port counts (default 1,2,4,8,16)\n");
+    fprintf(stderr, "  -t, --time <seconds>            Duration of each run (default 3)\n");
+    fprintf(stderr, "  -s, --size <bytes>              Frame length, >= %d (default 32)\n", SIM_STREAM_HDR_LEN);
+    fprintf(stderr, "  -r, --rate <hz>                 Frames per second per port, 0 = as fast as possible (default 1000)\n");
+    fprintf(stderr, "  -c, --crc                       Benchmark the CRC16 implementations instead\n");
+}
+
+static void recv_callback(void *ctx, const char *data, size_t len) {
+    serial_context_t *port_ctx = (serial_context_t *)ctx;
+    bench_port_t *port = (bench_port_t *)port_ctx->data;
+    uint64_t now = sim_now_us();
+
+    g_rx_bytes += len;
+    while (len > 0) {
+        size_t n = sizeof(port->buf) - port->len;
+        if (n > len) n = len;
+        memcpy(port->buf + port->len, data, n);
+        port->len += n;
+        data += n;
+        len -= n;
+
+        size_t off = 0;
+        while (port->len - off >= (size_t)g_opts.frame_len) {
+            if (port->buf[off] != SIM_STREAM_MAGIC0 || port->buf[off + 1] != SIM_STREAM_MAGIC1) {
+                off++;
+                continue;
+            }
+            uint64_t ts;
+            memcpy(&ts, port->buf + off + 6, sizeof(ts));
+            if (g_nsamples < BENCH_MAX_SAMPLES && now >= ts) {
+                g_samples[g_nsamples++] = (uint32_t)(now - ts);
+            }
+            g_rx_frames++;
+            off += g_opts.frame_len;
+        }
+        port->len -= off;
+        memmove(port->buf, port->buf + off, port->len);
+    }
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    uint8_t frame[SIM_BUF_MAX];
+    uint64_t period = g_opts.rate_hz > 0 ? 1000000ULL / g_opts.rate_hz : 0;
+    uint64_t next = sim_now_us();
+
+    for (int i = SIM_STREAM_HDR_LEN; i < g_opts.frame_len; i++) {
+        frame[i] = (uint8_t)i;
+    }
+    frame[0] = SIM_STREAM_MAGIC0;
+    frame[1] = SIM_STREAM_MAGIC1;
+
+    while (g_writing) {
+        for (int i = 0; i < g_nports; i++) {
+            bench_port_t *port = &g_ports[i];
+            uint64_t now = sim_now_us();
+            memcpy(frame + 2, &port->seq, 4);
+            memcpy(frame + 6, &now, 8);
+            if (write(port->master_fd, frame, g_opts.frame_len) == g_opts.frame_len) {
+                port->seq++;
+            }
+        }
+
+        if (period) {
+            next += period;
+            uint64_t now = sim_now_us();
+            if (next > now) usleep(next - now);
+            else next = now;
+        } else {
+            // 主设备缓冲区满时等待可写
+            struct pollfd pfd = { g_ports[0].master_fd, POLLOUT, 0 };
+            poll(&pfd, 1, 1);
+        }
+    }
+    return NULL;
+}
+
+typedef uint16_t (*crc_func_t)(uint16_t crc, const uint8_t *data, size_t len);
+
+/* 各 CRC 实现在不同帧长下的吞吐，单位 MB/s */
+static int crc_bench(void) {
+    static const struct { const char *name; crc_func_t fn; } impls[] = {
+        { "bitwise", e_crc16_modbus_bitwise },
+        { "table",   e_crc16_modbus_table },
+        { "slice8",  e_crc16_modbus_slice8 },
+        { "auto",    e_crc16_modbus_update },
+    };
+    static const size_t sizes[] = { 8, 64, 256, 4096 };
+    static uint8_t data[4096];
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    printf("%8s", "bytes");
+    for (size_t k = 0; k < sizeof(impls) / sizeof(impls[0]); k++) {
+        printf(" %12s", impls[k].name);
+    }
+    printf("   (MB/s)\n");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t len = sizes[s];
+        uint16_t expect = e_crc16_modbus_bitwise(E_CRC16_MODBUS_INIT, data, len);
+        printf("%8zu", len);
+        for (size_t k = 0; k < sizeof(impls) / sizeof(impls[0]); k++) {
+            if (impls[k].fn(E_CRC16_MODBUS_INIT, data, len) != expect) {
+                fprintf(stderr, "\n%s mismatch at %zu bytes\n", impls[k].name, len);
+                return -1;
+            }
+
+            volatile uint16_t sink = 0;
+            uint64_t bytes = 0;
+            uint64_t start = sim_now_us(), elapsed;
+            do {
+                for (int r = 0; r < 1000; r++) {
+                    sink ^= impls[k].fn(E_CRC16_MODBUS_INIT, data, len);
+                }
+                bytes += 1000 * len;
+                elapsed = sim_now_us() - start;
+            } while (elapsed < 200000);
+            printf(" %12.1f", (double)bytes / elapsed);
+        }
+        printf("\n");
+    }
+    printf("a 4 Mbaud 8N1 port carries %.1f MB/s\n", 4000000.0 / 10 / 1e6);
+    return 0;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int run(int nports) {
+    g_nports = nports;
+    g_nsamples = 0;
+    g_rx_frames = 0;
+    g_rx_bytes = 0;
+
+    serial_manager_t *manager = e_serial_manager_create();
+    if (!manager) return -1;
+
+    for (int i = 0; i < nports; i++) {
+        bench_port_t *port = &g_ports[i];
+        memset(port, 0, sizeof(*port));
+        snprintf(port->uid, sizeof(port->uid), "bench%d", i);
+        port->master_fd = sim_pty_open(&port->slave_fd, port->slave_path, sizeof(port->slave_path));
+        if (port->master_fd < 0) return -1;
+
+        serial_config_t cfg = {
+            .uid = port->uid,
+            .device = port->slave_path,
+            .baudrate = 4000000,
+            .databits = 8,
+            .stopbits = 1,
+            .parity = 'n',
+            .min_delay_ms = 0,
+            .maxlen = 4096,
+            .timeout_ms = DEFAULT_SERIAL_REV_TIMEOUT,
+        };
+        if (e_serial_manager_add_port(manager, &cfg, recv_callback, port) != 0) return -1;
+    }
+    e_serial_manager_start(manager);
+
+    // 等待所有串口被打开
+    for (int i = 0; i < nports; i++) {
+        while (e_serial_manager_write(manager, g_ports[i].uid, "", 1) < 0) {
+            usleep(1000);
+        }
+    }
+
+    pthread_t tid;
+    g_writing = 1;
+    pthread_create(&tid, NULL, writer_thread, NULL);
+    sleep(g_opts.seconds);
+    g_writing = 0;
+    pthread_join(tid, NULL);
+    usleep(200000);
+    e_serial_manager_stop(manager);
+
+    uint64_t frames = g_rx_frames, bytes = g_rx_bytes;
+    uint32_t p50 = 0, p99 = 0, max = 0;
+    if (g_nsamples) {
+        qsort(g_samples, g_nsamples, sizeof(uint32_t), cmp_u32);
+        p50 = g_samples[g_nsamples / 2];
+        p99 = g_samples[g_nsamples * 99 / 100];
+        max = g_samples[g_nsamples - 1];
+    }
+    printf("%5d %12.0f %12.0f %9u %9u %9u\n", nports,
+           (double)frames / g_opts.seconds, (double)bytes / g_opts.seconds, p50, p99, max);
+
+    e_serial_manager_destroy(manager);
+    for (int i = 0; i < nports; i++) {
+        close(g_ports[i].master_fd);
+        close(g_ports[i].slave_fd);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    char *list = strdup("1,2,4,8,16");
+
+    static struct option long_options[] = {
+        {"ports", required_argument, 0, 'n'},
+        {"time", required_argument, 0, 't'},
+        {"size", required_argument, 0, 's'},
+        {"rate", required_argument, 0, 'r'},
+        {"crc", no_argument, 0, 'c'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:t:s:r:ch", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'n': free(list); list = strdup(optarg); break;
+            case 't': g_opts.seconds = atoi(optarg); break;
+            case 's': g_opts.frame_len = atoi(optarg); break;
+            case 'r': g_opts.rate_hz = atoi(optarg); break;
+            case 'c': free(list); return crc_bench() == 0 ? 0 : 1;
+            case 'h': usage(argv[0]); return 0;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (g_opts.frame_len < SIM_STREAM_HDR_LEN || g_opts.frame_len > SIM_BUF_MAX || g_opts.seconds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    g_samples = malloc(sizeof(uint32_t) * BENCH_MAX_SAMPLES);
+    if (!g_samples) {
+        perror("malloc failed");
+        return 1;
+    }
+
+    printf("frame %d bytes, %d frames/s per port%s, %d s per run\n", g_opts.frame_len, g_opts.rate_hz,
+           g_opts.rate_hz ? "" : " (unlimited)", g_opts.seconds);
+    printf("%5s %12s %12s %9s %9s %9s\n", "ports", "frames/s", "bytes/s", "p50(us)", "p99(us)", "max(us)");
+
+    for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+        int n = atoi(tok);
+        if (n < 1 || n > BENCH_MAX_PORTS) {
+            fprintf(stderr, "Invalid port count %s\n", tok);
+            continue;
+        }
+        if (run(n) != 0) {
+            fprintf(stderr, "Run with %d ports failed\n", n);
+            return 1;
+        }
+    }
+
+    free(g_samples);
+    free(list);
+    return 0;
+}
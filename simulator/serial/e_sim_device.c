@@ -0,0 +1,295 @@
+#define _GNU_SOURCE
+#include "e_sim_device.h"
+#include <ezmb/e_crc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <termios.h>
+
+#define MODBUS_EXC_ILLEGAL_FUNCTION     0x01
+#define MODBUS_EXC_ILLEGAL_ADDRESS      0x02
+#define MODBUS_EXC_ILLEGAL_VALUE        0x03
+
+uint64_t sim_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+int sim_pty_open(int *slave_fd, char *slave_path, size_t len) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0) {
+        perror("posix_openpt failed");
+        return -1;
+    }
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || ptsname_r(master, slave_path, len) != 0) {
+        perror("pty setup failed");
+        close(master);
+        return -1;
+    }
+
+    int slave = open(slave_path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (slave < 0) {
+        perror("open pty slave failed");
+        close(master);
+        return -1;
+    }
+
+    // 关闭回显等行规程处理，避免采集器打开前写入的数据被回显给模拟器
+    struct termios tio;
+    if (tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    *slave_fd = slave;
+    return master;
+}
+
+static void device_write(sim_device_t *dev, const uint8_t *data, size_t len) {
+    ssize_t n = write(dev->master_fd, data, len);
+    if (n < 0) {
+        if (errno != EAGAIN) perror("pty write failed");
+        return;
+    }
+    dev->stats.tx_bytes += n;
+    dev->stats.tx_frames++;
+}
+
+int sim_device_init(sim_device_t *dev, const sim_options_t *opts, const char *link_path) {
+    memset(dev, 0, sizeof(*dev));
+    dev->opts = opts;
+    dev->slave_fd = -1;
+    dev->master_fd = sim_pty_open(&dev->slave_fd, dev->slave_path, sizeof(dev->slave_path));
+    if (dev->master_fd < 0) return -1;
+
+    if (link_path) {
+        snprintf(dev->link_path, sizeof(dev->link_path), "%s", link_path);
+        unlink(dev->link_path);
+        if (symlink(dev->slave_path, dev->link_path) != 0) {
+            perror("symlink failed");
+            sim_device_close(dev);
+            return -1;
+        }
+    }
+
+    if (opts->mode == SIM_MODE_MODBUS) {
+        dev->registers = malloc(sizeof(uint16_t) * 65536);
+        dev->coils = calloc(65536, 1);
+        if (!dev->registers || !dev->coils) {
+            sim_device_close(dev);
+            return -1;
+        }
+        for (int i = 0; i < 65536; i++) {
+            dev->registers[i] = (uint16_t)i;
+        }
+    }
+
+    dev->tx_due_us = UINT64_MAX;
+    dev->next_stream_us = opts->mode == SIM_MODE_STREAM ? sim_now_us() : UINT64_MAX;
+    return 0;
+}
+
+void sim_device_close(sim_device_t *dev) {
+    if (dev->link_path[0]) unlink(dev->link_path);
+    if (dev->master_fd >= 0) close(dev->master_fd);
+    if (dev->slave_fd >= 0) close(dev->slave_fd);
+    dev->master_fd = -1;
+    dev->slave_fd = -1;
+    free(dev->registers);
+    free(dev->coils);
+    dev->registers = NULL;
+    dev->coils = NULL;
+}
+
+/* 请求帧长度，数据不足返回0 */
+static size_t modbus_request_len(const uint8_t *buf, size_t len) {
+    if (len < 2) return 0;
+    switch (buf[1]) {
+        case 0x0F:
+        case 0x10:
+            if (len < 7) return 0;
+            return 9 + buf[6];
+        default:
+            return 8;
+    }
+}
+
+static size_t modbus_exception(uint8_t *out, uint8_t slave, uint8_t fc, uint8_t code) {
+    out[0] = slave;
+    out[1] = fc | 0x80;
+    out[2] = code;
+    return 3;
+}
+
+/* 处理一帧请求，返回不含CRC的应答长度，0表示不应答 */
+static size_t modbus_handle(sim_device_t *dev, const uint8_t *req, size_t len, uint8_t *out) {
+    uint8_t slave = req[0];
+    uint8_t fc = req[1];
+    uint16_t addr = (req[2] << 8) | req[3];
+    uint16_t val = (req[4] << 8) | req[5];
+
+    out[0] = slave;
+    out[1] = fc;
+    switch (fc) {
+        case 0x01:
+        case 0x02: {
+            if (val < 1 || val > 2000) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_VALUE);
+            if ((uint32_t)addr + val > 65536) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_ADDRESS);
+            uint8_t nbytes = (val + 7) / 8;
+            out[2] = nbytes;
+            memset(out + 3, 0, nbytes);
+            for (uint16_t i = 0; i < val; i++) {
+                // 离散输入按地址奇偶生成固定图样
+                int bit = fc == 0x01 ? dev->coils[addr + i] : ((addr + i) & 1);
+                if (bit) out[3 + i / 8] |= 1 << (i % 8);
+            }
+            return 3 + nbytes;
+        }
+        case 0x03:
+        case 0x04: {
+            if (val < 1 || val > 125) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_VALUE);
+            if ((uint32_t)addr + val > 65536) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_ADDRESS);
+            out[2] = val * 2;
+            for (uint16_t i = 0; i < val; i++) {
+                // 输入寄存器的值恒等于其地址
+                uint16_t v = fc == 0x03 ? dev->registers[addr + i] : (uint16_t)(addr + i);
+                out[3 + i * 2] = v >> 8;
+                out[4 + i * 2] = v & 0xFF;
+            }
+            return 3 + val * 2;
+        }
+        case 0x05:
+            if (val != 0xFF00 && val != 0x0000) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_VALUE);
+            dev->coils[addr] = val == 0xFF00;
+            memcpy(out, req, 6);
+            return 6;
+        case 0x06:
+            dev->registers[addr] = val;
+            memcpy(out, req, 6);
+            return 6;
+        case 0x0F: {
+            if (val < 1 || val > 1968 || req[6] != (val + 7) / 8 || len != 9u + req[6]) {
+                return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_VALUE);
+            }
+            if ((uint32_t)addr + val > 65536) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_ADDRESS);
+            for (uint16_t i = 0; i < val; i++) {
+                dev->coils[addr + i] = (req[7 + i / 8] >> (i % 8)) & 1;
+            }
+            memcpy(out, req, 6);
+            return 6;
+        }
+        case 0x10: {
+            if (val < 1 || val > 123 || req[6] != val * 2 || len != 9u + req[6]) {
+                return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_VALUE);
+            }
+            if ((uint32_t)addr + val > 65536) return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_ADDRESS);
+            for (uint16_t i = 0; i < val; i++) {
+                dev->registers[addr + i] = (req[7 + i * 2] << 8) | req[8 + i * 2];
+            }
+            memcpy(out, req, 6);
+            return 6;
+        }
+        default:
+            return modbus_exception(out, slave, fc, MODBUS_EXC_ILLEGAL_FUNCTION);
+    }
+}
+
+static void modbus_process(sim_device_t *dev) {
+    // 上一帧应答尚未发出时暂不处理新请求（半双工）
+    while (dev->tx_len == 0) {
+        size_t flen = modbus_request_len(dev->rx, dev->rx_len);
+        if (flen == 0 || flen > dev->rx_len) {
+            if (flen > SIM_BUF_MAX) dev->rx_len = 0;
+            return;
+        }
+
+        uint16_t crc = dev->rx[flen - 2] | (dev->rx[flen - 1] << 8);
+        if (e_crc16_modbus(dev->rx, flen - 2) != crc) {
+            // CRC错误，丢弃一个字节重新同步
+            dev->stats.crc_errors++;
+            memmove(dev->rx, dev->rx + 1, --dev->rx_len);
+            continue;
+        }
+        dev->stats.rx_frames++;
+
+        uint8_t slave = dev->rx[0];
+        if (slave != 0 && (dev->opts->slave_id == 0 || slave == dev->opts->slave_id)) {
+            size_t n = modbus_handle(dev, dev->rx, flen, dev->tx);
+            if (dev->tx[1] & 0x80) dev->stats.exceptions++;
+            uint16_t out_crc = e_crc16_modbus(dev->tx, n);
+            dev->tx[n] = out_crc & 0xFF;
+            dev->tx[n + 1] = out_crc >> 8;
+            dev->tx_len = n + 2;
+            dev->tx_due_us = sim_now_us() + (uint64_t)dev->opts->response_delay_ms * 1000ULL;
+        }
+
+        dev->rx_len -= flen;
+        memmove(dev->rx, dev->rx + flen, dev->rx_len);
+    }
+}
+
+void sim_device_on_readable(sim_device_t *dev) {
+    for (;;) {
+        size_t room = SIM_BUF_MAX - dev->rx_len;
+        if (room == 0) {
+            dev->rx_len = 0;
+            room = SIM_BUF_MAX;
+        }
+        ssize_t n = read(dev->master_fd, dev->rx + dev->rx_len, room);
+        if (n <= 0) break;
+        dev->stats.rx_bytes += n;
+
+        switch (dev->opts->mode) {
+            case SIM_MODE_ECHO:
+                device_write(dev, dev->rx, n);
+                break;
+            case SIM_MODE_STREAM:
+                break;
+            case SIM_MODE_MODBUS:
+                dev->rx_len += n;
+                modbus_process(dev);
+                break;
+        }
+    }
+}
+
+void sim_device_on_timer(sim_device_t *dev) {
+    uint64_t now = sim_now_us();
+
+    if (dev->tx_len && now >= dev->tx_due_us) {
+        device_write(dev, dev->tx, dev->tx_len);
+        dev->tx_len = 0;
+        dev->tx_due_us = UINT64_MAX;
+        modbus_process(dev);
+    }
+
+    if (dev->opts->mode == SIM_MODE_STREAM && now >= dev->next_stream_us) {
+        uint8_t frame[SIM_BUF_MAX];
+        size_t len = dev->opts->stream_frame_len;
+        if (len < SIM_STREAM_HDR_LEN) len = SIM_STREAM_HDR_LEN;
+        if (len > SIM_BUF_MAX) len = SIM_BUF_MAX;
+
+        frame[0] = SIM_STREAM_MAGIC0;
+        frame[1] = SIM_STREAM_MAGIC1;
+        memcpy(frame + 2, &dev->seq, 4);
+        memcpy(frame + 6, &now, 8);
+        for (size_t i = SIM_STREAM_HDR_LEN; i < len; i++) {
+            frame[i] = (uint8_t)i;
+        }
+        dev->seq++;
+        device_write(dev, frame, len);
+
+        uint64_t period = dev->opts->stream_rate_hz > 0 ? 1000000ULL / dev->opts->stream_rate_hz : 1000000ULL;
+        dev->next_stream_us += period;
+        if (dev->next_stream_us < now) dev->next_stream_us = now + period;
+    }
+}
+
+uint64_t sim_device_next_deadline(const sim_device_t *dev) {
+    return dev->tx_due_us < dev->next_stream_us ? dev->tx_due_us : dev->next_stream_us;
+}
@@ -0,0 +1,110 @@
+#ifndef E_SIM_DEVICE_H
+#define E_SIM_DEVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SIM_BUF_MAX         512
+#define SIM_STREAM_MAGIC0   0xA5
+#define SIM_STREAM_MAGIC1   0x5A
+#define SIM_STREAM_HDR_LEN  14      // magic(2) + seq(4) + timestamp_us(8)
+
+/**
+ * @brief 模拟设备类型
+ *
+ * @param SIM_MODE_ECHO: 原样回显收到的数据
+ * @param SIM_MODE_STREAM: 按固定速率主动发送带序号和时间戳的帧
+ * @param SIM_MODE_MODBUS: Modbus RTU 从站（寄存器应答器）
+ */
+typedef enum {
+    SIM_MODE_ECHO,
+    SIM_MODE_STREAM,
+    SIM_MODE_MODBUS
+} sim_mode_t;
+
+/* 模拟参数 */
+typedef struct {
+    sim_mode_t mode;
+    int stream_rate_hz;     // 流模式发送速率（帧/秒）
+    int stream_frame_len;   // 流模式帧长
+    int response_delay_ms;  // Modbus 应答延迟（模拟从站处理与换向时间）
+    int slave_id;           // Modbus 从站地址，0 表示应答所有地址
+} sim_options_t;
+
+/* 统计信息 */
+typedef struct {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t rx_frames;
+    uint64_t tx_frames;
+    uint64_t crc_errors;
+    uint64_t exceptions;
+} sim_stats_t;
+
+/* 模拟设备（一个伪终端） */
+typedef struct {
+    int master_fd;                  // 伪终端主设备，模拟器一侧
+    int slave_fd;                   // 保持从设备打开，避免采集器重开串口时主设备读到 EIO
+    char slave_path[64];            // 从设备路径（/dev/pts/N）
+    char link_path[128];            // 指向从设备的符号链接，为空表示不创建
+    const sim_options_t *opts;
+    uint8_t rx[SIM_BUF_MAX];        // 接收缓冲（Modbus 组帧）
+    size_t rx_len;
+    uint8_t tx[SIM_BUF_MAX];        // 延迟发送的应答
+    size_t tx_len;
+    uint64_t tx_due_us;
+    uint64_t next_stream_us;
+    uint32_t seq;
+    uint16_t *registers;            // 保持寄存器（初始值为寄存器地址）
+    uint8_t *coils;                 // 线圈
+    sim_stats_t stats;
+} sim_device_t;
+
+/**
+ * @brief 单调时钟（微秒）
+ */
+uint64_t sim_now_us(void);
+
+/**
+ * @brief 打开一对伪终端，从设备设置为原始模式
+ * @param slave_fd 输出从设备fd
+ * @param slave_path 输出从设备路径
+ * @param len 路径缓冲区长度
+ * @return 主设备fd（非阻塞），失败返回-1
+ */
+int sim_pty_open(int *slave_fd, char *slave_path, size_t len);
+
+/**
+ * @brief 初始化模拟设备
+ * @param dev 设备
+ * @param opts 模拟参数
+ * @param link_path 符号链接路径，可为NULL
+ * @return 0成功，-1失败
+ */
+int sim_device_init(sim_device_t *dev, const sim_options_t *opts, const char *link_path);
+
+/**
+ * @brief 关闭模拟设备并删除符号链接
+ * @param dev 设备
+ */
+void sim_device_close(sim_device_t *dev);
+
+/**
+ * @brief 主设备可读时调用
+ * @param dev 设备
+ */
+void sim_device_on_readable(sim_device_t *dev);
+
+/**
+ * @brief 处理到期的定时任务（延迟应答、流模式发送）
+ * @param dev 设备
+ */
+void sim_device_on_timer(sim_device_t *dev);
+
+/**
+ * @brief 下一个定时任务的时间，无任务返回UINT64_MAX
+ * @param dev 设备
+ */
+uint64_t sim_device_next_deadline(const sim_device_t *dev);
+
+#endif // E_SIM_DEVICE_H
@@ -13,8 +13,18 @@ driver.south = function(input, size)
     return table.concat(out)
 end
 
+-- 可选的批量入口：msgs 为消息数组，返回同样长度的结果数组（nil 表示丢弃）
+driver.south_batch = function(msgs, n)
+    local results = {}
+    for k = 1, n do
+        results[k] = driver.south(msgs[k], #msgs[k])
+    end
+    return results
+end
+
 function register_plugin(plugin)
     plugin.north_transform = driver.north
     plugin.south_transform = driver.south
+    plugin.south_transform_batch = driver.south_batch
     return plugin
 end
\ No newline at end of file
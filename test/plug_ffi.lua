@@ -0,0 +1,38 @@
+-- FFI 缓冲模式插件（需要 LuaJIT 构建：cmake -DEZMB_WITH_LUAJIT=ON 或 make LUAJIT=1）
+-- 转换函数收到输入/输出缓冲指针，直接读写字节，不创建 lua 字符串
+local ffi = require("ffi")
+local bit = require("bit")
+
+local driver = {}
+
+-- 返回输出长度；容量不足时返回所需长度且不写 out；返回 nil 丢弃消息
+driver.north = function(input, size, output, cap)
+    if cap < size then return size end
+    local i = ffi.cast("const uint8_t *", input)
+    local o = ffi.cast("uint8_t *", output)
+    if input ~= output then ffi.copy(o, i, size) end
+    local l, r = 0, size - 1
+    while l < r do
+        o[l], o[r] = o[r], o[l]
+        l, r = l + 1, r - 1
+    end
+    return size
+end
+
+driver.south = function(input, size, output, cap)
+    if cap < size then return size end
+    local i = ffi.cast("const uint8_t *", input)
+    local o = ffi.cast("uint8_t *", output)
+    for k = 0, size - 1 do
+        o[k] = bit.band(i[k] + 1, 0xff)
+    end
+    return size
+end
+
+function register_plugin(plugin)
+    plugin.ffi = true
+    plugin.inplace = true
+    plugin.north_transform = driver.north
+    plugin.south_transform = driver.south
+    return plugin
+end
@@ -2,13 +2,22 @@
 #include <string.h>
 
 /**
- * @brief 数据转换回调函数
- * 
- * @param ctx 插件上下文
- * @param in_data 输入数据
- * @param in_data_size 输入数据大小
- * @param out_data 输出数据
- * @param out_data_size 输出数据大小
+ * @brief 插件 ABI 版本，必须与宿主 E_PLUGIN_ABI_VERSION 一致
+ */
+#define E_PLUGIN_ABI_VERSION    3
+#define E_PLUGIN_F_INPLACE      0x01
+
+/**
+ * @brief v2 转换返回值
+ */
+typedef enum {
+    E_PLUGIN_ERROR = -1,
+    E_PLUGIN_OK = 0,
+    E_PLUGIN_NEED_SPACE = 1,
+} e_plugin_status_t;
+
+/**
+ * @brief v1 数据转换回调函数（输出由插件 malloc）
  */
 typedef void (*e_plugin_message_transform_callback)(
     void *ctx,
@@ -18,45 +27,164 @@ typedef void (*e_plugin_message_transform_callback)(
     size_t *out_data_size
 );
 
+/**
+ * @brief v2 数据转换回调函数
+ * 
+ * @param ctx 插件上下文
+ * @param in 输入数据
+ * @param in_len 输入数据大小
+ * @param out 输出缓冲
+ * @param out_cap 输出缓冲容量
+ * @param out_len 输出数据大小，容量不足时为所需容量
+ * @return e_plugin_status_t
+ */
+typedef int (*e_plugin_transform_fn)(
+    void *ctx,
+    const void *in,
+    size_t in_len,
+    void *out,
+    size_t out_cap,
+    size_t *out_len
+);
+
+/**
+ * @brief 批量转换中的一条消息
+ */
+typedef struct {
+    const void *in;
+    size_t in_len;
+    void *out;
+    size_t out_cap;
+    size_t out_len;
+    int status;
+} e_plugin_batch_item_t;
+
+/**
+ * @brief v2 批量数据转换回调函数（可选）
+ * 
+ * @param ctx 插件上下文
+ * @param items 消息数组，逐条填写 out_len 与 status
+ * @param count 消息数
+ */
+typedef void (*e_plugin_transform_batch_fn)(
+    void *ctx,
+    e_plugin_batch_item_t *items,
+    size_t count
+);
+
 /**
  * @brief 插件驱动
  * 
- * @param north_transform 北向转换回调函数
- * @param south_transform 南向转换回调函数
+ * @param north_transform 北向转换回调函数（v1，不需要填写）
+ * @param south_transform 南向转换回调函数（v1，不需要填写）
+ * @param north 北向转换回调函数
+ * @param south 南向转换回调函数
+ * @param flags 插件标志
+ * @param north_batch 北向批量转换回调函数（可选）
+ * @param south_batch 南向批量转换回调函数（可选）
+ * @param create_instance 创建实例状态（可选），每个工作线程一个，作为转换函数的 ctx
+ * @param destroy_instance 销毁实例状态（可选）
  */
 typedef struct {
     e_plugin_message_transform_callback north_transform;
     e_plugin_message_transform_callback south_transform;
+    e_plugin_transform_fn north;
+    e_plugin_transform_fn south;
+    unsigned int flags;
+    e_plugin_transform_batch_fn north_batch;
+    e_plugin_transform_batch_fn south_batch;
+    void *(*create_instance)(void);
+    void (*destroy_instance)(void *state);
 } e_plugin_driver_t;
 
 /**
- * @brief 北向转换函数
+ * @brief 声明插件 ABI 版本
+ * 
+ * PS: 必须命名为plugin_abi_version，未导出时按 v1 插件加载
+ */
+const unsigned int plugin_abi_version = E_PLUGIN_ABI_VERSION;
+
+/**
+ * @brief 北向转换函数：字节逆序
  * 
  * @param ud 插件上下文
  * @param in 输入数据
  * @param len 输入数据大小
- * @param out 输出数据
+ * @param out 输出缓冲（可能与 in 相同）
+ * @param cap 输出缓冲容量
+ * @param out_len 输出数据大小
  */
-static void north(void *ud, const void *in, size_t len, void **out, size_t *out_len) {
-    *out = malloc(len);
-    for (size_t i = 0; i < len; ++i)
-        ((char *)*out)[i] = ((char *)in)[len - i - 1];
+static int north(void *ud, const void *in, size_t len, void *out, size_t cap, size_t *out_len) {
     *out_len = len;
+    if (cap < len) return E_PLUGIN_NEED_SPACE;
+    unsigned char *o = (unsigned char *)out;
+    memmove(o, in, len);
+    for (size_t i = 0; i < len / 2; ++i) {
+        unsigned char t = o[i];
+        o[i] = o[len - i - 1];
+        o[len - i - 1] = t;
+    }
+    return E_PLUGIN_OK;
+}
+
+/**
+ * @brief 实例状态：南向转换的查找表，每个工作线程一份，不需要加锁
+ */
+typedef struct {
+    unsigned char table[256];
+} instance_t;
+
+/**
+ * @brief 创建实例状态，在首次使用它的工作线程中调用
+ * 
+ * @return 实例状态，NULL 失败
+ */
+static void *create_instance(void) {
+    instance_t *state = malloc(sizeof(*state));
+    if (!state) return NULL;
+    for (int i = 0; i < 256; ++i)
+        state->table[i] = (unsigned char)(i + 1);
+    return state;
 }
 
 /**
- * @brief 南向转换函数
+ * @brief 销毁实例状态
  * 
- * @param ud 插件上下文
+ * @param state 实例状态
+ */
+static void destroy_instance(void *state) {
+    free(state);
+}
+
+/**
+ * @brief 南向转换函数：按查找表逐字节映射（每字节加一）
+ * 
+ * @param ud 实例状态
  * @param in 输入数据
  * @param len 输入数据大小
- * @param out 输出数据
+ * @param out 输出缓冲（可能与 in 相同）
+ * @param cap 输出缓冲容量
+ * @param out_len 输出数据大小
  */
-static void south(void *ud, const void *in, size_t len, void **out, size_t *out_len) {
-    *out = malloc(len);
-    for (size_t i = 0; i < len; ++i)
-        ((char *)*out)[i] = ((char *)in)[i] + 1;
+static int south(void *ud, const void *in, size_t len, void *out, size_t cap, size_t *out_len) {
+    const unsigned char *table = ((const instance_t *)ud)->table;
     *out_len = len;
+    if (cap < len) return E_PLUGIN_NEED_SPACE;
+    for (size_t i = 0; i < len; ++i)
+        ((unsigned char *)out)[i] = table[((const unsigned char *)in)[i]];
+    return E_PLUGIN_OK;
+}
+
+/**
+ * @brief 南向批量转换函数：一次处理多条消息
+ * 
+ * @param ud 实例状态
+ * @param items 消息数组
+ * @param count 消息数
+ */
+static void south_batch(void *ud, e_plugin_batch_item_t *items, size_t count) {
+    for (size_t k = 0; k < count; ++k)
+        items[k].status = south(ud, items[k].in, items[k].in_len, items[k].out, items[k].out_cap, &items[k].out_len);
 }
 
 /**
@@ -68,7 +196,11 @@ static void south(void *ud, const void *in, size_t len, void **out, size_t *out_
  * PS: 必须命名函数为register_plugin
  */
 int register_plugin(e_plugin_driver_t *driver) {
-    driver->north_transform = north;
-    driver->south_transform = south;
+    driver->north = north;
+    driver->south = south;
+    driver->flags = E_PLUGIN_F_INPLACE;
+    driver->south_batch = south_batch;
+    driver->create_instance = create_instance;
+    driver->destroy_instance = destroy_instance;
     return 0;
-}
\ No newline at end of file
+}